@@ -25,6 +25,8 @@
 #include "pinhole_camera.h"
 #include "transform.h"
 #include "ray.h"
+#include "interaction.h"
+#include "light.h"
 
 namespace pixel {
 
@@ -39,6 +41,8 @@ namespace pixel {
 
         // Compute transformation matrix
         view_matrix = LookAt(eye, at, up);
+        inv_view_matrix = Inverse(view_matrix);
+        image_area = (right - left) * (top - bottom);
     }
 
     Ray PinholeCamera::GenerateRay(uint32_t i, uint32_t j, float u1, float u2) const {
@@ -52,8 +56,73 @@ namespace pixel {
         // Compute direction
         SSEVector dir = s_world - eye_world;
 
+        // Offset rays toward the next pixel in each direction
+        RayDifferential diff;
+        diff.rx_origin = diff.ry_origin = eye_world;
+        diff.rx_direction = dir + view_matrix * SSEVector((right - left) / width, 0.f, 0.f, 0.f);
+        diff.ry_direction = dir + view_matrix * SSEVector(0.f, 0.f, (top - bottom) / height, 0.f);
+
         // Return ray
-        return Ray(eye_world, dir);
+        Ray ray(eye_world, dir);
+        ray.SetDifferentials(diff);
+
+        return ray;
+    }
+
+    float PinholeCamera::CosView(const SSEVector &dir, float *const raster_x, float *const raster_y) const {
+        // Direction in camera space, where the image plane lies at y = 1
+        const SSEVector d = Normalize(inv_view_matrix * dir);
+        if (d.y <= 0.f) {
+            return 0.f;
+        }
+        // Find the point hit on the image plane
+        const float x = d.x / d.y;
+        const float z = d.z / d.y;
+        if (x < left || x > right || z < bottom || z > top) {
+            return 0.f;
+        }
+        if (raster_x) {
+            *raster_x = (x - left) / (right - left) * width;
+            *raster_y = (z - bottom) / (top - bottom) * height;
+        }
+
+        return d.y;
+    }
+
+    SSESpectrum PinholeCamera::We(const Ray &ray, float *const raster_x, float *const raster_y) const {
+        const float cos_theta = CosView(ray.Direction(), raster_x, raster_y);
+        if (cos_theta == 0.f) {
+            return SSESpectrum(0.f);
+        }
+        // Importance is normalized so that it integrates to one over the image
+        const float cos_2 = cos_theta * cos_theta;
+
+        return SSESpectrum(1.f / (image_area * cos_2 * cos_2));
+    }
+
+    void PinholeCamera::Pdf_We(const Ray &ray, float *const pdf_pos, float *const pdf_dir) const {
+        // Rays are generated uniformly over the image plane from a single point
+        const float cos_theta = CosView(ray.Direction(), nullptr, nullptr);
+        *pdf_pos = 1.f;
+        *pdf_dir = cos_theta > 0.f ? 1.f / (image_area * cos_theta * cos_theta * cos_theta) : 0.f;
+    }
+
+    SSESpectrum PinholeCamera::Sample_Wi(const SurfaceInteraction &from, SSEVector *const wi, float *const pdf,
+                                         float *const raster_x, float *const raster_y,
+                                         OcclusionTester *const occ) const {
+        const SSEVector to_eye = eye_world - from.hit_point;
+        const float distance_2 = SqrdLength(to_eye);
+        *wi = Normalize(to_eye);
+        // Convert the delta position pdf to solid angle at the interaction
+        const float cos_theta = CosView(-*wi, raster_x, raster_y);
+        if (cos_theta == 0.f) {
+            *pdf = 0.f;
+            return SSESpectrum(0.f);
+        }
+        *pdf = distance_2 / cos_theta;
+        *occ = OcclusionTester(from.hit_point, eye_world);
+
+        return We(Ray(eye_world, -*wi), nullptr, nullptr);
     }
 
-}
\ No newline at end of file
+}
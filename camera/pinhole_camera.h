@@ -48,15 +48,28 @@ namespace pixel {
         // Create ray for a given couple of pixel coordinates and a sample
         Ray GenerateRay(uint32_t i, uint32_t j, float u1, float u2) const override;
 
+        SSESpectrum We(const Ray &ray, float *const raster_x, float *const raster_y) const override;
+
+        void Pdf_We(const Ray &ray, float *const pdf_pos, float *const pdf_dir) const override;
+
+        SSESpectrum Sample_Wi(const SurfaceInteraction &from, SSEVector *const wi, float *const pdf,
+                              float *const raster_x, float *const raster_y, OcclusionTester *const occ) const override;
+
     private:
+        // Cosine between a ray and the view direction, zero if the ray misses the image. The raster position
+        // of the ray is returned when requested
+        float CosView(const SSEVector &dir, float *const raster_x, float *const raster_y) const;
+
         //Camera position
         SSEVector eye_world;
-        // Transformation matrix
-        SSEMatrix view_matrix;
+        // Transformation matrix and its inverse
+        SSEMatrix view_matrix, inv_view_matrix;
         // Field of view
         float bottom, top, left, right;
         // Image size
         uint32_t width, height;
+        // Area of the image plane at unit distance
+        float image_area;
     };
 
 }
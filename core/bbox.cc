@@ -23,6 +23,7 @@
  */
 
 #include "bbox.h"
+#include "sse_matrix.h"
 
 namespace pixel {
 
@@ -45,14 +46,76 @@ namespace pixel {
         return BBox(
                 SSEVector(FMin(b1.Min().x, b2.Min().x), FMin(b1.Min().y, b2.Min().y), FMin(b1.Min().z, b2.Min().z),
                           1.f),
-                SSEVector(FMin(b1.Max().x, b2.Max().x), FMin(b1.Max().y, b2.Max().y), FMin(b1.Max().z, b2.Max().z),
+                SSEVector(FMax(b1.Max().x, b2.Max().x), FMax(b1.Max().y, b2.Max().y), FMax(b1.Max().z, b2.Max().z),
                           1.f));
     }
 
     BBox BBoxUnion(const BBox &b, const SSEVector &p) {
         return BBox(
                 SSEVector(FMin(b.Min().x, p.x), FMin(b.Min().y, p.y), FMin(b.Min().z, p.z), 1.f),
-                SSEVector(FMin(b.Max().x, p.x), FMin(b.Max().y, p.y), FMin(b.Max().z, p.z), 1.f));
+                SSEVector(FMax(b.Max().x, p.x), FMax(b.Max().y, p.y), FMax(b.Max().z, p.z), 1.f));
+    }
+
+    BBox TransformBBox(const BBox &b, const SSEMatrix &mat) {
+        // Compute all eight BBox vertices
+        SSEVector vertices[8];
+        vertices[0] = b.Min();
+        vertices[1] = SSEVector(b.Max().x, b.Min().y, b.Min().z, 1.f);
+        vertices[2] = SSEVector(b.Max().x, b.Min().y, b.Max().z, 1.f);
+        vertices[3] = SSEVector(b.Min().x, b.Min().y, b.Max().z, 1.f);
+
+        vertices[4] = SSEVector(b.Min().x, b.Max().y, b.Min().z, 1.f);
+        vertices[5] = SSEVector(b.Max().x, b.Max().y, b.Min().z, 1.f);
+        vertices[6] = b.Max();
+        vertices[7] = SSEVector(b.Min().x, b.Max().y, b.Max().z, 1.f);
+
+        // Compute the BBox of the transformed vertices
+        TransformPoints(mat, vertices, vertices, 8);
+        BBox bbox;
+        for (uint32_t i = 0; i < 8; i++) {
+            bbox = BBoxUnion(bbox, vertices[i]);
+        }
+
+        return bbox;
+    }
+
+    SSEVector BBox::Centroid() const {
+        return SSEVector(0.5f * (bounds[0].x + bounds[1].x), 0.5f * (bounds[0].y + bounds[1].y),
+                         0.5f * (bounds[0].z + bounds[1].z), 1.f);
+    }
+
+    float BBox::SurfaceArea() const {
+        float dx = bounds[1].x - bounds[0].x;
+        float dy = bounds[1].y - bounds[0].y;
+        float dz = bounds[1].z - bounds[0].z;
+        // An empty box has negative extent, report zero area for it
+        if (dx < 0.f || dy < 0.f || dz < 0.f) {
+            return 0.f;
+        }
+
+        return 2.f * (dx * dy + dx * dz + dy * dz);
+    }
+
+    uint32_t BBox::MaximumExtent() const {
+        float dx = bounds[1].x - bounds[0].x;
+        float dy = bounds[1].y - bounds[0].y;
+        float dz = bounds[1].z - bounds[0].z;
+        if (dx > dy && dx > dz) {
+            return 0;
+        } else if (dy > dz) {
+            return 1;
+        }
+
+        return 2;
+    }
+
+    SSEVector BBox::Offset(const SSEVector &p) const {
+        SSEVector o(p.x - bounds[0].x, p.y - bounds[0].y, p.z - bounds[0].z, 0.f);
+        if (bounds[1].x > bounds[0].x) { o.x /= bounds[1].x - bounds[0].x; }
+        if (bounds[1].y > bounds[0].y) { o.y /= bounds[1].y - bounds[0].y; }
+        if (bounds[1].z > bounds[0].z) { o.z /= bounds[1].z - bounds[0].z; }
+
+        return o;
     }
 
 }
\ No newline at end of file
@@ -93,6 +93,18 @@ namespace pixel {
             return (i == 0) ? bounds[0] : bounds[1];
         }
 
+        // Compute BBox center
+        SSEVector Centroid() const;
+
+        // Compute BBox surface area
+        float SurfaceArea() const;
+
+        // Find the axis with the largest extent
+        uint32_t MaximumExtent() const;
+
+        // Position of a point relative to the BBox, 0 at the minimum and 1 at the maximum corner
+        SSEVector Offset(const SSEVector &p) const;
+
     private:
         // Maximum and minimum
         SSEVector bounds[2];
@@ -104,6 +116,9 @@ namespace pixel {
     // Compute the union between a BBox and a point
     BBox BBoxUnion(const BBox &b, const SSEVector &p);
 
+    // Compute the BBox of a transformed BBox
+    BBox TransformBBox(const BBox &b, const SSEMatrix &mat);
+
 }
 
 #endif /* BBOX_H */
@@ -33,6 +33,7 @@
 #define CAMERA_H
 
 #include "pixel.h"
+#include "sse_spectrum.h"
 
 namespace pixel {
 
@@ -44,6 +45,26 @@ namespace pixel {
 
         // Create ray for a given couple of pixel coordinates and a sample
         virtual Ray GenerateRay(uint32_t i, uint32_t j, float u1, float u2) const = 0;
+
+        // Importance carried by a ray leaving the camera and the raster position it goes through, cameras that
+        // cannot be reached by paths traced from the lights return zero
+        virtual SSESpectrum We(const Ray &, float *const, float *const) const {
+            return SSESpectrum(0.f);
+        }
+
+        // Compute the pdfs of generating a given ray, its origin with respect to area and its direction to
+        // solid angle
+        virtual void Pdf_We(const Ray &, float *const pdf_pos, float *const pdf_dir) const {
+            *pdf_pos = *pdf_dir = 0.f;
+        }
+
+        // Sample the camera seen from a given SurfaceInteraction, returning the importance arriving there with
+        // the raster position it is seen at. The pdf is with respect to solid angle at the interaction
+        virtual SSESpectrum Sample_Wi(const SurfaceInteraction &, SSEVector *const, float *const pdf,
+                                      float *const, float *const, OcclusionTester *const) const {
+            *pdf = 0.f;
+            return SSESpectrum(0.f);
+        }
     };
 }
 
@@ -0,0 +1,180 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2016 simon.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "denoiser.h"
+#include "film.h"
+#include "kernels.h"
+#include "parallel.h"
+
+#include <iostream>
+#include <vector>
+
+namespace pixel {
+
+    // 1 / log(2), converts natural exponents to powers of 2
+    static const float INV_LN2 = 1.44269504f;
+    // Smallest albedo the radiance is divided by
+    static const float MIN_ALBEDO = 0.01f;
+    // Half size of the window over which the variance of the pixels is estimated
+    static const int32_t VARIANCE_RADIUS = 2;
+    // Pixels brighter than the mean of their neighbors by more than this many deviations are clamped
+    static const float OUTLIER_DEVIATIONS = 3.f;
+    // Rows of a chunk processed by a thread
+    static const uint32_t DENOISE_ROWS = 8;
+
+    Denoiser::Denoiser(uint32_t iterations, float color_sigma, float albedo_sigma, float normal_sigma)
+            : iterations(iterations), color_weight(INV_LN2 / (color_sigma * color_sigma)),
+              albedo_weight(INV_LN2 / (albedo_sigma * albedo_sigma)),
+              normal_weight(INV_LN2 / (normal_sigma * normal_sigma)) {
+    }
+
+    void Denoiser::EnableFeatures(Film *const film) {
+        film->EnableAOV(AOV_ALBEDO);
+        film->EnableAOV(AOV_NORMAL);
+    }
+
+    bool Denoiser::HasFeatures(const Film &film) {
+        return film.HasAOV(AOV_ALBEDO) && film.HasAOV(AOV_NORMAL);
+    }
+
+    bool Denoiser::Denoise(const Film &film, Film *const output) const {
+        if (!HasFeatures(film)) {
+            std::cerr << "Cannot denoise a film without albedo and normal outputs" << std::endl;
+            return false;
+        }
+        const uint32_t width = film.GetWidth();
+        const uint32_t height = film.GetHeight();
+        const uint32_t size = width * height;
+        // Planar color, albedo, normal and inverse variance, followed by two color buffers for the passes
+        std::vector<float> planes(16 * size);
+        float *const color[3] = {&planes[0], &planes[size], &planes[2 * size]};
+        float *const albedo[3] = {&planes[3 * size], &planes[4 * size], &planes[5 * size]};
+        float *const normal[3] = {&planes[6 * size], &planes[7 * size], &planes[8 * size]};
+        float *const inv_variance = &planes[9 * size];
+        // The luminance is only read before the first pass, it shares its plane with a pass buffer
+        float *const luminance = &planes[10 * size];
+        float *const buffers[2][3] = {{&planes[10 * size], &planes[11 * size], &planes[12 * size]},
+                                      {&planes[13 * size], &planes[14 * size], &planes[15 * size]}};
+
+        // Divide the colors by the albedo, leaving the lighting to filter
+        ParallelFor(height, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t j = begin; j < end; j++) {
+                for (uint32_t i = 0; i < width; i++) {
+                    const uint32_t p = j * width + i;
+                    const SSESpectrum c = film.GetSpectrum(i, j);
+                    const SSESpectrum a(film.GetAOV(AOV_ALBEDO, 0, i, j), film.GetAOV(AOV_ALBEDO, 1, i, j),
+                                        film.GetAOV(AOV_ALBEDO, 2, i, j));
+                    SSEVector n(film.GetAOV(AOV_NORMAL, 0, i, j), film.GetAOV(AOV_NORMAL, 1, i, j),
+                                film.GetAOV(AOV_NORMAL, 2, i, j), 0.f);
+                    if (SqrdLength(n) > 0.f) {
+                        Normalize(&n);
+                    }
+                    albedo[0][p] = FMax(a.r, MIN_ALBEDO);
+                    albedo[1][p] = FMax(a.g, MIN_ALBEDO);
+                    albedo[2][p] = FMax(a.b, MIN_ALBEDO);
+                    color[0][p] = c.r / albedo[0][p];
+                    color[1][p] = c.g / albedo[1][p];
+                    color[2][p] = c.b / albedo[2][p];
+                    normal[0][p] = n.x;
+                    normal[1][p] = n.y;
+                    normal[2][p] = n.z;
+                    luminance[p] = Luminance(SSESpectrum(color[0][p], color[1][p], color[2][p]));
+                }
+            }
+        }, DENOISE_ROWS);
+
+        // Statistics of the luminance of the neighbors of each pixel. Its variance scales the color distances,
+        // and brighter pixels are clamped to it as the outliers of a few samples would not be smoothed out
+        ParallelFor(height, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t j = begin; j < end; j++) {
+                for (uint32_t i = 0; i < width; i++) {
+                    const uint32_t p = j * width + i;
+                    float sum = 0.f, sum_squares = 0.f;
+                    uint32_t count = 0;
+                    for (int32_t y = FMax(static_cast<int32_t>(j) - VARIANCE_RADIUS, 0);
+                         y <= FMin(static_cast<int32_t>(j) + VARIANCE_RADIUS, static_cast<int32_t>(height) - 1); y++) {
+                        for (int32_t x = FMax(static_cast<int32_t>(i) - VARIANCE_RADIUS, 0);
+                             x <= FMin(static_cast<int32_t>(i) + VARIANCE_RADIUS, static_cast<int32_t>(width) - 1);
+                             x++) {
+                            const uint32_t q = y * width + x;
+                            if (q != p) {
+                                sum += luminance[q];
+                                sum_squares += luminance[q] * luminance[q];
+                                count++;
+                            }
+                        }
+                    }
+                    const float mean = sum / count;
+                    const float variance = FMax(sum_squares / count - mean * mean, 0.f);
+                    inv_variance[p] = 1.f / (variance + 1e-4f * mean * mean + 1e-8f);
+                    const float limit = mean + OUTLIER_DEVIATIONS * std::sqrt(variance);
+                    if (luminance[p] > limit) {
+                        const float scale = limit / luminance[p];
+                        for (uint32_t k = 0; k < 3; k++) {
+                            color[k][p] *= scale;
+                        }
+                    }
+                }
+            }
+        }, DENOISE_ROWS);
+
+        // Filter passes of growing step, the noise left shrinks so the color weight grows
+        DenoiseImages images;
+        for (uint32_t k = 0; k < 3; k++) {
+            images.albedo[k] = albedo[k];
+            images.normal[k] = normal[k];
+        }
+        images.inv_variance = inv_variance;
+        images.width = width;
+        images.height = height;
+        const float *const *source = color;
+        for (uint32_t pass = 0; pass < iterations; pass++) {
+            for (uint32_t k = 0; k < 3; k++) {
+                images.color[k] = source[k];
+            }
+            float *const *const destination = buffers[pass % 2];
+            const uint32_t step = 1u << pass;
+            const float pass_color_weight = color_weight * static_cast<float>(step * step);
+            ParallelFor(height, [&](uint32_t begin, uint32_t end) {
+                for (uint32_t j = begin; j < end; j++) {
+                    Kernels().atrous_row(images, j, step, pass_color_weight, albedo_weight, normal_weight,
+                                         destination);
+                }
+            }, DENOISE_ROWS);
+            source = destination;
+        }
+
+        // Multiply the filtered lighting by the albedo
+        for (uint32_t j = 0; j < height; j++) {
+            for (uint32_t i = 0; i < width; i++) {
+                const uint32_t p = j * width + i;
+                output->AddSample(SSESpectrum(source[0][p] * albedo[0][p], source[1][p] * albedo[1][p],
+                                              source[2][p] * albedo[2][p]), i + 0.5f, j + 0.5f);
+            }
+        }
+
+        return true;
+    }
+
+}
@@ -0,0 +1,71 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2016 simon.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * File:   denoiser.h
+ * Author: simon
+ *
+ * Created on October 20, 2026, 3:25 AM
+ */
+
+#ifndef PIXEL_DENOISER_H
+#define PIXEL_DENOISER_H
+
+#include "pixel.h"
+
+namespace pixel {
+
+    // Define Denoiser class, an edge-avoiding a-trous wavelet filter (Dammertz et al. 2010) run between the film
+    // and the tone mapper. The radiance is divided by the first hit albedo, so that textures are kept, and
+    // smoothed by B3 spline passes of growing step, each neighbor weighted by its distance to the pixel in
+    // color, albedo and normal. The color distance is scaled by the variance of the pixel estimated from its
+    // neighborhood, which makes a single set of parameters work at any sample count, and the outliers of that
+    // neighborhood are clamped first
+    class Denoiser {
+    public:
+        // Constructor, the sigmas are the distances in variances, albedo and normal over which the weight of a
+        // neighbor is divided by e
+        Denoiser(uint32_t iterations = 5, float color_sigma = 4.f, float albedo_sigma = 0.2f,
+                 float normal_sigma = 0.5f);
+
+        // Register the auxiliary outputs read by the denoiser, the albedo and the normal, before rendering
+        static void EnableFeatures(Film *const film);
+
+        // Check that a film records the auxiliary outputs read by the denoiser
+        static bool HasFeatures(const Film &film);
+
+        // Filter the colors of a film into output. Returns false, leaving output untouched, when the film does
+        // not record the features
+        bool Denoise(const Film &film, Film *const output) const;
+
+    private:
+        // Number of passes, the last one has a step of 2^(iterations - 1) pixels
+        const uint32_t iterations;
+        // Inverse squared sigmas over log(2), the weights are computed as powers of 2
+        const float color_weight, albedo_weight, normal_weight;
+    };
+
+}
+
+#endif //PIXEL_DENOISER_H
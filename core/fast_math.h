@@ -0,0 +1,302 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2016 simon.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * File:   fast_math.h
+ * Author: simon
+ *
+ * Created on October 19, 2026, 3:05 PM
+ */
+
+#ifndef PIXEL_FAST_MATH_H
+#define PIXEL_FAST_MATH_H
+
+#include <cmath>
+#include <cstdint>
+#include <immintrin.h>
+
+// Polynomial approximations of the transcendental functions used in the hot paths. The SSE versions
+// evaluate 4 values at once, the scalar ones use the first lane so both give the same results.
+// Maximum errors measured against double precision over the documented input ranges:
+//  - FastSin, FastCos, FastSinCos: 1e-7 absolute for |x| <= 8192
+//  - FastAtan2: 3e-7 absolute (radians)
+//  - FastAcos: 3.5e-7 absolute (radians) for x in [-1, 1]
+//  - FastLog2: 8.2e-8 * max(1, |log2(x)|) absolute for normal positive x, the rounding of the result
+//    dominates away from 1, e.g. 5.3e-7 for x in [1e-3, 1e3]
+//  - FastExp2: 1e-7 relative for x in [-126, 127]
+//  - FastPow: 1.5e-7 * max(1, |e * log2(x)|) relative for x > 0, returns 0 for x <= 0
+// Define PIXEL_FAST_MATH to make Sin, Cos, SinCos, Atan2 and Acos use them instead of the standard library
+
+namespace pixel {
+
+    // Constants of the approximations, pi / 2 is split in three parts for an exact range reduction
+    static const float FAST_MATH_TWO_OVER_PI = 0.636619772367581f;
+    static const float FAST_MATH_PI_OVER_2_1 = 1.5703125f;
+    static const float FAST_MATH_PI_OVER_2_2 = 4.837512969970703125e-4f;
+    static const float FAST_MATH_PI_OVER_2_3 = 7.54978995489188216e-8f;
+    static const float FAST_MATH_PI_OVER_2 = 1.57079632679489662f;
+    static const float FAST_MATH_PI_OVER_4 = 0.785398163397448310f;
+    static const float FAST_MATH_PI = 3.14159265358979324f;
+    static const float FAST_MATH_TAN_PI_OVER_8 = 0.414213562373095049f;
+    static const float FAST_MATH_SQRT_HALF = 0.707106781186547524f;
+    static const float FAST_MATH_LOG2_E = 1.44269504088896341f;
+
+    // Compute sine and cosine at the same time, |x| <= 8192
+    inline void FastSinCos(const __m128 &x, __m128 *const s, __m128 *const c) {
+        // Reduce to [-pi / 4, pi / 4], the quadrant selects the polynomial and the sign
+        const __m128 j = _mm_round_ps(_mm_mul_ps(x, _mm_set1_ps(FAST_MATH_TWO_OVER_PI)),
+                                      _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        __m128 r = _mm_sub_ps(x, _mm_mul_ps(j, _mm_set1_ps(FAST_MATH_PI_OVER_2_1)));
+        r = _mm_sub_ps(r, _mm_mul_ps(j, _mm_set1_ps(FAST_MATH_PI_OVER_2_2)));
+        r = _mm_sub_ps(r, _mm_mul_ps(j, _mm_set1_ps(FAST_MATH_PI_OVER_2_3)));
+        const __m128i quadrant = _mm_cvtps_epi32(j);
+        const __m128 z = _mm_mul_ps(r, r);
+        // Minimax polynomials from Cephes
+        __m128 sin_r = _mm_mul_ps(_mm_set1_ps(-1.9515295891e-4f), z);
+        sin_r = _mm_mul_ps(_mm_add_ps(sin_r, _mm_set1_ps(8.3321608736e-3f)), z);
+        sin_r = _mm_mul_ps(_mm_add_ps(sin_r, _mm_set1_ps(-1.6666654611e-1f)), z);
+        sin_r = _mm_add_ps(_mm_mul_ps(sin_r, r), r);
+        __m128 cos_r = _mm_mul_ps(_mm_set1_ps(2.443315711809948e-5f), z);
+        cos_r = _mm_mul_ps(_mm_add_ps(cos_r, _mm_set1_ps(-1.388731625493765e-3f)), z);
+        cos_r = _mm_mul_ps(_mm_add_ps(cos_r, _mm_set1_ps(4.166664568298827e-2f)), _mm_mul_ps(z, z));
+        cos_r = _mm_add_ps(_mm_sub_ps(_mm_set1_ps(1.f), _mm_mul_ps(_mm_set1_ps(0.5f), z)), cos_r);
+        // Odd quadrants swap sine and cosine
+        const __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(1)),
+                                                             _mm_set1_epi32(1)));
+        const __m128 sin_x = _mm_blendv_ps(sin_r, cos_r, swap);
+        const __m128 cos_x = _mm_blendv_ps(cos_r, sin_r, swap);
+        // Sine is negative in quadrants 2 and 3, cosine in quadrants 1 and 2
+        const __m128 sin_sign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(2)), 30));
+        const __m128 cos_sign = _mm_castsi128_ps(
+                _mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30));
+        *s = _mm_xor_ps(sin_x, sin_sign);
+        *c = _mm_xor_ps(cos_x, cos_sign);
+    }
+
+    inline __m128 FastSin(const __m128 &x) {
+        __m128 s, c;
+        FastSinCos(x, &s, &c);
+
+        return s;
+    }
+
+    inline __m128 FastCos(const __m128 &x) {
+        __m128 s, c;
+        FastSinCos(x, &s, &c);
+
+        return c;
+    }
+
+    // Compute the arc tangent of y / x in [-pi, pi]
+    inline __m128 FastAtan2(const __m128 &y, const __m128 &x) {
+        const __m128 sign_mask = _mm_set1_ps(-0.f);
+        const __m128 abs_x = _mm_andnot_ps(sign_mask, x);
+        const __m128 abs_y = _mm_andnot_ps(sign_mask, y);
+        // Compute atan(a) with a in [0, 1], reduced to [0, tan(pi / 8)]
+        const __m128 max_xy = _mm_max_ps(abs_x, abs_y);
+        const __m128 a = _mm_and_ps(_mm_div_ps(_mm_min_ps(abs_x, abs_y), max_xy),
+                                    _mm_cmpgt_ps(max_xy, _mm_setzero_ps()));
+        const __m128 reduce = _mm_cmpgt_ps(a, _mm_set1_ps(FAST_MATH_TAN_PI_OVER_8));
+        const __m128 t = _mm_blendv_ps(a, _mm_div_ps(_mm_sub_ps(a, _mm_set1_ps(1.f)), _mm_add_ps(a, _mm_set1_ps(1.f))),
+                                       reduce);
+        const __m128 z = _mm_mul_ps(t, t);
+        // Minimax polynomial from Cephes
+        __m128 p = _mm_mul_ps(_mm_set1_ps(8.05374449538e-2f), z);
+        p = _mm_mul_ps(_mm_add_ps(p, _mm_set1_ps(-1.38776856032e-1f)), z);
+        p = _mm_mul_ps(_mm_add_ps(p, _mm_set1_ps(1.99777106478e-1f)), z);
+        p = _mm_mul_ps(_mm_add_ps(p, _mm_set1_ps(-3.33329491539e-1f)), z);
+        __m128 r = _mm_add_ps(_mm_mul_ps(p, t), t);
+        r = _mm_add_ps(r, _mm_and_ps(reduce, _mm_set1_ps(FAST_MATH_PI_OVER_4)));
+        // Move to the right octant and quadrant
+        r = _mm_blendv_ps(r, _mm_sub_ps(_mm_set1_ps(FAST_MATH_PI_OVER_2), r), _mm_cmpgt_ps(abs_y, abs_x));
+        r = _mm_blendv_ps(r, _mm_sub_ps(_mm_set1_ps(FAST_MATH_PI), r), _mm_cmplt_ps(x, _mm_setzero_ps()));
+
+        return _mm_or_ps(r, _mm_and_ps(y, sign_mask));
+    }
+
+    // Compute the arc cosine of x in [-1, 1]
+    inline __m128 FastAcos(const __m128 &x) {
+        const __m128 sign_mask = _mm_set1_ps(-0.f);
+        const __m128 abs_x = _mm_min_ps(_mm_andnot_ps(sign_mask, x), _mm_set1_ps(1.f));
+        // Compute asin(|x|), using asin(|x|) = pi / 2 - 2 asin(sqrt((1 - |x|) / 2)) above 0.5
+        const __m128 large = _mm_cmpgt_ps(abs_x, _mm_set1_ps(0.5f));
+        const __m128 z = _mm_blendv_ps(_mm_mul_ps(abs_x, abs_x),
+                                       _mm_mul_ps(_mm_set1_ps(0.5f), _mm_sub_ps(_mm_set1_ps(1.f), abs_x)), large);
+        const __m128 t = _mm_blendv_ps(abs_x, _mm_sqrt_ps(z), large);
+        // Minimax polynomial from Cephes
+        __m128 p = _mm_mul_ps(_mm_set1_ps(4.2163199048e-2f), z);
+        p = _mm_mul_ps(_mm_add_ps(p, _mm_set1_ps(2.4181311049e-2f)), z);
+        p = _mm_mul_ps(_mm_add_ps(p, _mm_set1_ps(4.5470025998e-2f)), z);
+        p = _mm_mul_ps(_mm_add_ps(p, _mm_set1_ps(7.4953002686e-2f)), z);
+        p = _mm_mul_ps(_mm_add_ps(p, _mm_set1_ps(1.6666752422e-1f)), z);
+        const __m128 asin_t = _mm_add_ps(_mm_mul_ps(p, t), t);
+        // acos(|x|) is 2 asin(t) above 0.5 and pi / 2 - asin(|x|) below
+        const __m128 acos_abs = _mm_blendv_ps(_mm_sub_ps(_mm_set1_ps(FAST_MATH_PI_OVER_2), asin_t),
+                                              _mm_add_ps(asin_t, asin_t), large);
+
+        return _mm_blendv_ps(acos_abs, _mm_sub_ps(_mm_set1_ps(FAST_MATH_PI), acos_abs), x);
+    }
+
+    // Compute the base 2 logarithm of a positive normal x
+    inline __m128 FastLog2(const __m128 &x) {
+        // Split x in exponent and mantissa in [sqrt(0.5), sqrt(2))
+        const __m128i bits = _mm_castps_si128(x);
+        __m128 e = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+        __m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007FFFFF)),
+                                                 _mm_set1_epi32(0x3F800000)));
+        const __m128 large = _mm_cmpgt_ps(m, _mm_set1_ps(2.f * FAST_MATH_SQRT_HALF));
+        m = _mm_blendv_ps(m, _mm_mul_ps(m, _mm_set1_ps(0.5f)), large);
+        e = _mm_add_ps(e, _mm_and_ps(large, _mm_set1_ps(1.f)));
+        // Minimax polynomial of log(1 + t) from Cephes
+        const __m128 t = _mm_sub_ps(m, _mm_set1_ps(1.f));
+        const __m128 z = _mm_mul_ps(t, t);
+        __m128 p = _mm_set1_ps(7.0376836292e-2f);
+        p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(-1.1514610310e-1f));
+        p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(1.1676998740e-1f));
+        p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(-1.2420140846e-1f));
+        p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(1.4249322787e-1f));
+        p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(-1.6668057665e-1f));
+        p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(2.0000714765e-1f));
+        p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(-2.4999993993e-1f));
+        p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(3.3333331174e-1f));
+        p = _mm_mul_ps(_mm_mul_ps(p, t), z);
+        const __m128 log_m = _mm_add_ps(t, _mm_sub_ps(p, _mm_mul_ps(_mm_set1_ps(0.5f), z)));
+
+        return _mm_add_ps(_mm_mul_ps(log_m, _mm_set1_ps(FAST_MATH_LOG2_E)), e);
+    }
+
+    // Compute 2^x for x in [-126, 127]
+    inline __m128 FastExp2(const __m128 &x) {
+        const __m128 clamped = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-126.f)), _mm_set1_ps(127.f));
+        // Split in integer part and fraction in [-0.5, 0.5]
+        const __m128 i = _mm_round_ps(clamped, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        const __m128 f = _mm_sub_ps(clamped, i);
+        // Minimax polynomial from Cephes
+        __m128 p = _mm_set1_ps(1.535336188319500e-4f);
+        p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(1.339887440266574e-3f));
+        p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(9.618437357674640e-3f));
+        p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(5.550332471162809e-2f));
+        p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(2.402264791363012e-1f));
+        p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(6.931472028550421e-1f));
+        p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(1.f));
+        // Scale by 2^i building the exponent bits
+        const __m128i exponent = _mm_slli_epi32(_mm_add_epi32(_mm_cvtps_epi32(i), _mm_set1_epi32(127)), 23);
+
+        return _mm_mul_ps(p, _mm_castsi128_ps(exponent));
+    }
+
+    // Compute x^e, 0 for x <= 0
+    inline __m128 FastPow(const __m128 &x, const __m128 &e) {
+        const __m128 positive = _mm_cmpgt_ps(x, _mm_setzero_ps());
+
+        return _mm_and_ps(FastExp2(_mm_mul_ps(e, FastLog2(x))), positive);
+    }
+
+    // Scalar versions
+    inline void FastSinCos(float x, float *const s, float *const c) {
+        __m128 s4, c4;
+        FastSinCos(_mm_set_ss(x), &s4, &c4);
+        *s = _mm_cvtss_f32(s4);
+        *c = _mm_cvtss_f32(c4);
+    }
+
+    inline float FastSin(float x) {
+        return _mm_cvtss_f32(FastSin(_mm_set_ss(x)));
+    }
+
+    inline float FastCos(float x) {
+        return _mm_cvtss_f32(FastCos(_mm_set_ss(x)));
+    }
+
+    inline float FastAtan2(float y, float x) {
+        return _mm_cvtss_f32(FastAtan2(_mm_set_ss(y), _mm_set_ss(x)));
+    }
+
+    inline float FastAcos(float x) {
+        return _mm_cvtss_f32(FastAcos(_mm_set_ss(x)));
+    }
+
+    inline float FastLog2(float x) {
+        return _mm_cvtss_f32(FastLog2(_mm_set_ss(x)));
+    }
+
+    inline float FastExp2(float x) {
+        return _mm_cvtss_f32(FastExp2(_mm_set_ss(x)));
+    }
+
+    inline float FastPow(float x, float e) {
+        return _mm_cvtss_f32(FastPow(_mm_set_ss(x), _mm_set_ss(e)));
+    }
+
+    // Functions used by the renderer, selected at compile time
+#ifdef PIXEL_FAST_MATH
+
+    inline float Sin(float x) {
+        return FastSin(x);
+    }
+
+    inline float Cos(float x) {
+        return FastCos(x);
+    }
+
+    inline void SinCos(float x, float *const s, float *const c) {
+        FastSinCos(x, s, c);
+    }
+
+    inline float Atan2(float y, float x) {
+        return FastAtan2(y, x);
+    }
+
+    inline float Acos(float x) {
+        return FastAcos(x);
+    }
+
+#else
+
+    inline float Sin(float x) {
+        return std::sin(x);
+    }
+
+    inline float Cos(float x) {
+        return std::cos(x);
+    }
+
+    inline void SinCos(float x, float *const s, float *const c) {
+        *s = std::sin(x);
+        *c = std::cos(x);
+    }
+
+    inline float Atan2(float y, float x) {
+        return std::atan2(y, x);
+    }
+
+    inline float Acos(float x) {
+        return std::acos(x);
+    }
+
+#endif
+
+}
+
+#endif //PIXEL_FAST_MATH_H
@@ -24,15 +24,164 @@
 
 #include "film.h"
 
+#include <cassert>
+
 namespace pixel {
 
+    // Number of components of each auxiliary output
+    static const uint32_t AOV_COMPONENTS[NUM_AOV_TYPES] = {1, 3, 3, 1, 1};
+
+    // Add to a float shared between threads
+    static void AtomicAdd(std::atomic<float> *const a, float v) {
+        float old = a->load(std::memory_order_relaxed);
+        while (!a->compare_exchange_weak(old, old + v, std::memory_order_relaxed)) {
+        }
+    }
+
     Film::Film(uint32_t w, uint32_t h)
-            : width(w), height(h) {
+            : width(w), height(h), splat_scale(1.f), aovs_packed(false) {
     }
 
     Film::~Film() {
     }
 
+    void Film::EnableSplats() {
+        if (splats) { return; }
+        splats.reset(new std::atomic<float>[3 * width * height]);
+        for (uint32_t i = 0; i < 3 * width * height; i++) {
+            splats[i].store(0.f, std::memory_order_relaxed);
+        }
+    }
+
+    bool Film::HasSplats() const {
+        return splats != nullptr;
+    }
+
+    void Film::AddSplat(const SSESpectrum &s, float x, float y) {
+        assert(splats);
+        // Check pixel coordinates
+        if (!(x >= 0.f && y >= 0.f) || static_cast<uint32_t>(x) >= width || static_cast<uint32_t>(y) >= height) {
+            return;
+        }
+        std::atomic<float> *const pixel = &splats[3 * (static_cast<uint32_t>(y) * width + static_cast<uint32_t>(x))];
+        AtomicAdd(pixel, s.r);
+        AtomicAdd(pixel + 1, s.g);
+        AtomicAdd(pixel + 2, s.b);
+    }
+
+    void Film::SetSplatScale(float s) {
+        splat_scale = s;
+    }
+
+    SSESpectrum Film::GetSplat(uint32_t i, uint32_t j) const {
+        if (!splats) { return SSESpectrum(0.f); }
+        const std::atomic<float> *const pixel = &splats[3 * (j * width + i)];
+
+        return SSESpectrum(splat_scale * pixel[0].load(std::memory_order_relaxed),
+                           splat_scale * pixel[1].load(std::memory_order_relaxed),
+                           splat_scale * pixel[2].load(std::memory_order_relaxed));
+    }
+
+    AOVSample::AOVSample()
+            : depth(INFINITY), normal(0.f, 0.f, 0.f, 0.f), albedo(1.f), material_id(0) {
+    }
+
+    void Film::EnableAOV(AOV_TYPE type) {
+        if (type == AOV_NORMAL || type == AOV_ALBEDO) {
+            EnableAOV(AOV_SAMPLES);
+        }
+        if (!aovs[type]) {
+            aovs[type].reset(new FilmPlanes(AOV_COMPONENTS[type], width * height, STORAGE_FLOAT,
+                                            (type == AOV_DEPTH) ? INFINITY : 0.f));
+        }
+    }
+
+    bool Film::HasAOV(AOV_TYPE type) const {
+        return static_cast<bool>(aovs[type]);
+    }
+
+    bool Film::HasAOVs() const {
+        for (uint32_t type = 0; type < NUM_AOV_TYPES; type++) {
+            if (aovs[type]) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void Film::AddAOVSample(const AOVSample &sample, float x, float y) {
+        // Check pixel coordinates
+        if (aovs_packed || !(x >= 0.f && y >= 0.f) || static_cast<uint32_t>(x) >= width ||
+            static_cast<uint32_t>(y) >= height) {
+            return;
+        }
+        const uint32_t p = static_cast<uint32_t>(y) * width + static_cast<uint32_t>(x);
+        if (aovs[AOV_DEPTH]) {
+            float *const depth = aovs[AOV_DEPTH]->Floats(0);
+            depth[p] = FMin(depth[p], sample.depth);
+        }
+        if (aovs[AOV_NORMAL]) {
+            aovs[AOV_NORMAL]->Floats(0)[p] += sample.normal.x;
+            aovs[AOV_NORMAL]->Floats(1)[p] += sample.normal.y;
+            aovs[AOV_NORMAL]->Floats(2)[p] += sample.normal.z;
+        }
+        if (aovs[AOV_ALBEDO]) {
+            aovs[AOV_ALBEDO]->Floats(0)[p] += sample.albedo.r;
+            aovs[AOV_ALBEDO]->Floats(1)[p] += sample.albedo.g;
+            aovs[AOV_ALBEDO]->Floats(2)[p] += sample.albedo.b;
+        }
+        if (aovs[AOV_MATERIAL_ID]) {
+            float *const id = aovs[AOV_MATERIAL_ID]->Floats(0);
+            if (id[p] == 0.f) {
+                id[p] = static_cast<float>(sample.material_id);
+            }
+        }
+        if (aovs[AOV_SAMPLES]) {
+            aovs[AOV_SAMPLES]->Floats(0)[p] += 1.f;
+        }
+    }
+
+    float Film::GetAOV(AOV_TYPE type, uint32_t component, uint32_t i, uint32_t j) const {
+        const uint32_t p = j * width + i;
+        const float v = aovs[type]->Get(component, p);
+        if (!aovs_packed && (type == AOV_NORMAL || type == AOV_ALBEDO)) {
+            const float samples = aovs[AOV_SAMPLES]->Get(0, p);
+            return (samples > 0.f) ? v / samples : 0.f;
+        }
+
+        return v;
+    }
+
+    const FilmPlanes &Film::GetAOVPlanes(AOV_TYPE type) const {
+        return *aovs[type];
+    }
+
+    void Film::PackAOVs() {
+        if (aovs_packed) {
+            return;
+        }
+        const uint32_t size = width * height;
+        for (AOV_TYPE type : {AOV_NORMAL, AOV_ALBEDO}) {
+            if (!aovs[type]) {
+                continue;
+            }
+            const float *const samples = aovs[AOV_SAMPLES]->Floats(0);
+            for (uint32_t c = 0; c < AOV_COMPONENTS[type]; c++) {
+                float *const values = aovs[type]->Floats(c);
+                for (uint32_t p = 0; p < size; p++) {
+                    values[p] = (samples[p] > 0.f) ? values[p] / samples[p] : 0.f;
+                }
+            }
+        }
+        for (AOV_TYPE type : {AOV_DEPTH, AOV_NORMAL, AOV_ALBEDO}) {
+            if (aovs[type]) {
+                aovs[type]->Pack();
+            }
+        }
+        aovs_packed = true;
+    }
+
     uint32_t Film::GetWidth() const {
         return width;
     }
@@ -33,9 +33,38 @@
 #define FILM_H
 
 #include "sse_spectrum.h"
+#include "sse_vector.h"
+#include "film_planes.h"
+#include <atomic>
+#include <memory>
 
 namespace pixel {
 
+    // Auxiliary outputs of a film, written alongside the radiance for compositing and denoising
+    enum AOV_TYPE : uint32_t {
+        // Distance to the first hit, the nearest of the samples of a pixel
+        AOV_DEPTH,
+        // Shading normal and albedo of the first hit, averaged over the samples
+        AOV_NORMAL,
+        AOV_ALBEDO,
+        // Identifier of the material of the first sample of a pixel hitting a surface, 0 when none did
+        AOV_MATERIAL_ID,
+        // Number of samples of a pixel
+        AOV_SAMPLES,
+        NUM_AOV_TYPES
+    };
+
+    // Auxiliary values of a sample, taken at the first hit of its ray. Rays leaving the scene keep the values
+    // of the constructor
+    struct AOVSample {
+        AOVSample();
+
+        float depth;
+        SSEVector normal;
+        SSESpectrum albedo;
+        uint32_t material_id;
+    };
+
     // Define base film class
     class Film {
     public:
@@ -51,14 +80,60 @@ namespace pixel {
         // Get film color at a given coordinate
         virtual SSESpectrum GetSpectrum(uint32_t i, uint32_t j) const = 0;
 
+        // Allocate the splat buffer, for the integrators tracing paths from the lights. Must be called before
+        // rendering
+        void EnableSplats();
+
+        bool HasSplats() const;
+
+        // Add the contribution of a path traced from a light, which may land on any pixel. The splat buffer must
+        // be enabled. Safe to call from several threads at once
+        void AddSplat(const SSESpectrum &s, float x, float y);
+
+        // Set the scale of the splats, one over the number of paths traced from the lights per pixel
+        void SetSplatScale(float s);
+
+        // Register an auxiliary output, its planes are allocated and written by AddAOVSample from then on. The
+        // normal and the albedo also register the number of samples they are averaged over
+        void EnableAOV(AOV_TYPE type);
+
+        bool HasAOV(AOV_TYPE type) const;
+
+        // Check if any auxiliary output is registered
+        bool HasAOVs() const;
+
+        // Add the auxiliary values of a sample to the registered outputs
+        void AddAOVSample(const AOVSample &sample, float x, float y);
+
+        // Get a component of an auxiliary output of a pixel, the normal is averaged but not normalized
+        float GetAOV(AOV_TYPE type, uint32_t component, uint32_t i, uint32_t j) const;
+
+        // Get the planes of a registered output, its components as accumulated until packed
+        const FilmPlanes &GetAOVPlanes(AOV_TYPE type) const;
+
+        // Average the normal and the albedo and store them with the depth as halves, once rendering is done.
+        // The material identifiers and the numbers of samples stay exact, no sample can be added afterwards
+        void PackAOVs();
+
         // Get width and height of the film
         uint32_t GetWidth() const;
 
         uint32_t GetHeight() const;
 
     protected:
+        // Get the scaled splats of a pixel
+        SSESpectrum GetSplat(uint32_t i, uint32_t j) const;
+
         // Film dimension
         const uint32_t width, height;
+
+    private:
+        // Splatted color channels of each pixel, null until enabled
+        std::unique_ptr<std::atomic<float>[]> splats;
+        float splat_scale;
+        // Planes of the auxiliary outputs, one per component, empty unless registered
+        std::unique_ptr<FilmPlanes> aovs[NUM_AOV_TYPES];
+        bool aovs_packed;
     };
 
 }
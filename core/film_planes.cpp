@@ -0,0 +1,110 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2016 simon.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "film_planes.h"
+#include "kernels.h"
+#include "half.h"
+#include <immintrin.h>
+#include <cassert>
+#include <algorithm>
+
+namespace pixel {
+
+    // Alignment of the planes, a cache line
+    static const uint32_t PLANE_ALIGNMENT = 64;
+
+    FilmPlanes::FilmPlanes(uint32_t n_planes, uint32_t size, FILM_STORAGE storage, float value)
+            : n_planes(n_planes), size(size), storage(storage), stride(0), data(nullptr) {
+        Allocate(storage);
+        if (storage == STORAGE_FLOAT) {
+            std::fill(reinterpret_cast<float *>(data), reinterpret_cast<float *>(data) + n_planes * stride, value);
+        } else {
+            std::fill(reinterpret_cast<uint16_t *>(data), reinterpret_cast<uint16_t *>(data) + n_planes * stride,
+                      HalfFromFloat(value));
+        }
+    }
+
+    FilmPlanes::~FilmPlanes() {
+        _mm_free(data);
+    }
+
+    void FilmPlanes::Allocate(FILM_STORAGE s) {
+        // Planes are padded to the alignment
+        const uint32_t value_size = (s == STORAGE_FLOAT) ? sizeof(float) : sizeof(uint16_t);
+        const uint32_t per_line = PLANE_ALIGNMENT / value_size;
+        storage = s;
+        stride = (size + per_line - 1) / per_line * per_line;
+        data = _mm_malloc(static_cast<size_t>(n_planes) * stride * value_size, PLANE_ALIGNMENT);
+    }
+
+    float FilmPlanes::Get(uint32_t plane, uint32_t i) const {
+        if (storage == STORAGE_FLOAT) {
+            return reinterpret_cast<const float *>(data)[plane * stride + i];
+        }
+        return FloatFromHalf(reinterpret_cast<const uint16_t *>(data)[plane * stride + i]);
+    }
+
+    void FilmPlanes::Set(uint32_t plane, uint32_t i, float v) {
+        if (storage == STORAGE_FLOAT) {
+            reinterpret_cast<float *>(data)[plane * stride + i] = v;
+        } else {
+            reinterpret_cast<uint16_t *>(data)[plane * stride + i] = HalfFromFloat(v);
+        }
+    }
+
+    float *FilmPlanes::Floats(uint32_t plane) {
+        assert(storage == STORAGE_FLOAT);
+
+        return reinterpret_cast<float *>(data) + plane * stride;
+    }
+
+    const float *FilmPlanes::Floats(uint32_t plane) const {
+        assert(storage == STORAGE_FLOAT);
+
+        return reinterpret_cast<const float *>(data) + plane * stride;
+    }
+
+    void FilmPlanes::Pack() {
+        if (storage == STORAGE_HALF) {
+            return;
+        }
+        const float *const floats = reinterpret_cast<const float *>(data);
+        const uint32_t float_stride = stride;
+        Allocate(STORAGE_HALF);
+        uint16_t *const halves = reinterpret_cast<uint16_t *>(data);
+        for (uint32_t plane = 0; plane < n_planes; plane++) {
+            Kernels().float_to_half(floats + plane * float_stride, size, halves + plane * stride);
+        }
+        _mm_free(const_cast<float *>(floats));
+    }
+
+    FILM_STORAGE FilmPlanes::Storage() const {
+        return storage;
+    }
+
+    size_t FilmPlanes::Bytes() const {
+        return static_cast<size_t>(n_planes) * stride * ((storage == STORAGE_FLOAT) ? sizeof(float) : sizeof(uint16_t));
+    }
+
+}
@@ -0,0 +1,93 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2016 simon.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * File:   film_planes.h
+ * Author: simon
+ *
+ * Created on October 20, 2026, 4:05 AM
+ */
+
+#ifndef PIXEL_FILM_PLANES_H
+#define PIXEL_FILM_PLANES_H
+
+#include "pixel.h"
+
+namespace pixel {
+
+    // Precision of the values of film planes
+    enum FILM_STORAGE {
+        // 32-bit floats, which samples are accumulated into
+        STORAGE_FLOAT,
+        // 16-bit halves, for finished images and auxiliary outputs
+        STORAGE_HALF
+    };
+
+    // Define FilmPlanes class, a set of planes of the same size whose values are stored as floats or halves.
+    // Each plane starts on a 64-byte boundary, so that runs of pixels are read with aligned vector loads
+    class FilmPlanes {
+    public:
+        // Constructor, all the values are set to value
+        FilmPlanes(uint32_t n_planes, uint32_t size, FILM_STORAGE storage = STORAGE_FLOAT, float value = 0.f);
+
+        // Destructor
+        ~FilmPlanes();
+
+        FilmPlanes(const FilmPlanes &) = delete;
+
+        FilmPlanes &operator=(const FilmPlanes &) = delete;
+
+        // Get and set a value of a plane
+        float Get(uint32_t plane, uint32_t i) const;
+
+        void Set(uint32_t plane, uint32_t i, float v);
+
+        // Get a plane of float storage, for direct access
+        float *Floats(uint32_t plane);
+
+        const float *Floats(uint32_t plane) const;
+
+        // Convert the values to halves, once they are not accumulated anymore
+        void Pack();
+
+        FILM_STORAGE Storage() const;
+
+        // Bytes of memory used by the values
+        size_t Bytes() const;
+
+    private:
+        // Allocate the planes with the given storage
+        void Allocate(FILM_STORAGE s);
+
+        const uint32_t n_planes, size;
+        FILM_STORAGE storage;
+        // Values between the starts of consecutive planes
+        uint32_t stride;
+        // Aligned values, floats or halves
+        void *data;
+    };
+
+}
+
+#endif //PIXEL_FILM_PLANES_H
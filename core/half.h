@@ -0,0 +1,107 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2016 simon.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * File:   half.h
+ * Author: simon
+ *
+ * Created on October 20, 2026, 4:30 AM
+ */
+
+#ifndef PIXEL_HALF_H
+#define PIXEL_HALF_H
+
+#include "pixel.h"
+#include <cstring>
+
+namespace pixel {
+
+    // Scalar conversions between floats and IEEE half precision values. Runs of values are converted by the
+    // kernels, with the half precision instructions when the target has them
+
+    // Convert a float to the nearest half, ties to even
+    inline uint16_t HalfFromFloat(float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        const uint32_t sign = (bits >> 16) & 0x8000u;
+        const uint32_t magnitude = bits & 0x7FFFFFFFu;
+        // Infinity and NaN, which stays quiet
+        if (magnitude >= 0x7F800000u) {
+            return static_cast<uint16_t>(sign | 0x7C00u | ((magnitude > 0x7F800000u) ? 0x0200u : 0u));
+        }
+        // Values rounding above the largest half, 65504
+        if (magnitude >= 0x477FF000u) {
+            return static_cast<uint16_t>(sign | 0x7C00u);
+        }
+        // Subnormal halves, multiples of 2^-24 down to half of the smallest one
+        if (magnitude < 0x38800000u) {
+            if (magnitude <= 0x33000000u) {
+                return static_cast<uint16_t>(sign);
+            }
+            const uint32_t mantissa = (magnitude & 0x007FFFFFu) | 0x00800000u;
+            const uint32_t shift = 126u - (magnitude >> 23);
+            uint32_t half = mantissa >> shift;
+            const uint32_t remainder = mantissa & ((1u << shift) - 1u);
+            const uint32_t midpoint = 1u << (shift - 1u);
+            if (remainder > midpoint || (remainder == midpoint && (half & 1u))) {
+                half++;
+            }
+
+            return static_cast<uint16_t>(sign | half);
+        }
+        // Normal halves, rebias the exponent and round the mantissa, a carry moves to the exponent
+        uint32_t half = (magnitude >> 13) - (112u << 10);
+        const uint32_t remainder = magnitude & 0x1FFFu;
+        if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u))) {
+            half++;
+        }
+
+        return static_cast<uint16_t>(sign | half);
+    }
+
+    // Convert a half to a float, exactly
+    inline float FloatFromHalf(uint16_t half) {
+        const uint32_t sign = static_cast<uint32_t>(half & 0x8000u) << 16;
+        const uint32_t exponent = (half >> 10) & 0x1Fu;
+        const uint32_t mantissa = half & 0x03FFu;
+        uint32_t bits;
+        if (exponent == 0x1Fu) {
+            bits = sign | 0x7F800000u | (mantissa << 13);
+        } else if (exponent != 0u) {
+            bits = sign | ((exponent + 112u) << 23) | (mantissa << 13);
+        } else {
+            // Subnormal, mantissa * 2^-24
+            const float v = static_cast<float>(mantissa) * 5.9604644775390625e-8f;
+            std::memcpy(&bits, &v, sizeof(bits));
+            bits |= sign;
+        }
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+
+        return value;
+    }
+
+}
+
+#endif //PIXEL_HALF_H
@@ -0,0 +1,73 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2016 simon.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "image_io.h"
+#include <cstring>
+#include <fstream>
+
+namespace pixel {
+
+    bool ReadPFM(const std::string &file_name, uint32_t *const width, uint32_t *const height,
+                 std::vector<SSESpectrum> *const pixels) {
+        std::ifstream file(file_name, std::ios::binary);
+        if (!file) { return false; }
+        // Header, the sign of the scale gives the byte order
+        std::string magic;
+        int32_t w, h;
+        float scale;
+        file >> magic >> w >> h >> scale;
+        if (!file || (magic != "PF" && magic != "Pf") || w <= 0 || h <= 0) { return false; }
+        file.get();
+        const uint32_t channels = (magic == "PF") ? 3 : 1;
+        std::vector<float> data(static_cast<size_t>(w) * h * channels);
+        if (!file.read(reinterpret_cast<char *>(data.data()), data.size() * sizeof(float))) { return false; }
+        // Swap bytes if the file order differs from the machine one
+        const uint32_t one = 1;
+        const bool little_endian_machine = *reinterpret_cast<const uint8_t *>(&one) == 1;
+        if ((scale < 0.f) != little_endian_machine) {
+            for (float &v : data) {
+                uint32_t bits;
+                std::memcpy(&bits, &v, sizeof(bits));
+                bits = __builtin_bswap32(bits);
+                std::memcpy(&v, &bits, sizeof(bits));
+            }
+        }
+
+        // Rows are stored from the bottom one
+        *width = static_cast<uint32_t>(w);
+        *height = static_cast<uint32_t>(h);
+        pixels->resize(static_cast<size_t>(w) * h);
+        for (int32_t y = 0; y < h; y++) {
+            const float *row = data.data() + static_cast<size_t>(h - 1 - y) * w * channels;
+            for (int32_t x = 0; x < w; x++) {
+                const float *p = row + x * channels;
+                (*pixels)[static_cast<size_t>(y) * w + x] = (channels == 3) ? SSESpectrum(p[0], p[1], p[2])
+                                                                            : SSESpectrum(p[0]);
+            }
+        }
+
+        return true;
+    }
+
+}
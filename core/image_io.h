@@ -0,0 +1,49 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2016 simon.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * File:   image_io.h
+ * Author: simon
+ *
+ * Created on October 19, 2026, 7:10 PM
+ */
+
+#ifndef PIXEL_IMAGE_IO_H
+#define PIXEL_IMAGE_IO_H
+
+#include "pixel.h"
+#include "sse_spectrum.h"
+#include <string>
+#include <vector>
+
+namespace pixel {
+
+    // Read a PFM float image, color or grayscale. Rows are returned from the top one, returns false if the
+    // file cannot be read
+    bool ReadPFM(const std::string &file_name, uint32_t *const width, uint32_t *const height,
+                 std::vector<SSESpectrum> *const pixels);
+
+}
+
+#endif //PIXEL_IMAGE_IO_H
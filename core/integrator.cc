@@ -26,22 +26,50 @@
 #include "sse_spectrum.h"
 #include "interaction.h"
 #include "scene.h"
+#include "film.h"
+#include "material.h"
 #include "light.h"
 #include "scattering.h"
 #include "ray.h"
-
-// DEBUG
-#include <random>
+#include "montecarlo.h"
 
 namespace pixel {
 
-    // TODO: FIX ME
-    std::default_random_engine generator;
-    std::uniform_real_distribution<float> distribution(0.f, 1.f);
+    void SurfaceIntegratorInterface::IncomingRadianceBatch(const Ray *const rays, uint32_t count, const Scene &scene,
+                                                           SSESpectrum *const L, AOVSample *const aovs) const {
+        for (uint32_t i = 0; i < count; i++) {
+            if (aovs) {
+                aovs[i] = AOVSample();
+                FirstHitAOVs(rays[i], scene, &aovs[i]);
+            }
+            L[i] = IncomingRadiance(rays[i], scene);
+        }
+    }
+
+    void RecordAOVs(const SurfaceInteraction &interaction, const Ray &ray, AOVSample *const aov) {
+        aov->depth = Length(interaction.hit_point - ray.Origin());
+        aov->normal = interaction.normal;
+        aov->material_id = interaction.mat_ptr->id;
+        // Lights keep a white albedo, so that their radiance is not scaled by the denoiser
+        if (interaction.bsdf->NumMatchingBRDF() > 0) {
+            aov->albedo = interaction.bsdf->Rho(Normalize(-ray.Direction()));
+        }
+    }
+
+    void FirstHitAOVs(const Ray &ray, const Scene &scene, AOVSample *const aov) {
+        // The intersection moves the maximum of the ray, which the caller still traces
+        const Ray first(ray);
+        SurfaceInteraction interaction;
+        if (scene.Intersect(first, &interaction)) {
+            interaction.GenerateBSDF();
+            RecordAOVs(interaction, first, aov);
+        }
+    }
 
     SSESpectrum
     DirectIllumination(const SurfaceInteraction &interaction, const SSEVector &wo_world, const Scene &scene) {
         SSESpectrum Ld(0.f);
+        RandomGenerator &rng = ThreadRandomGenerator();
 
         // Type of BRDF to check for direct illumination
         BRDF_TYPE brdf_types = BRDF_TYPE(ALL_BRDF & ~BRDF_SPECULAR);
@@ -51,14 +79,32 @@ namespace pixel {
         OcclusionTester occ_tester;
         for (auto light : scene.GetLights()) {
             // Sample incoming radiance
-            SSESpectrum Li = light->Sample_Li(interaction, distribution(generator), distribution(generator), &wi,
-                                              &pdf_Li, &occ_tester);
+            SSESpectrum Li = light->Sample_Li(interaction, rng(), rng(), &wi, &pdf_Li, &occ_tester);
             if (!IsBlack(Li) && pdf_Li != 0.f) {
                 if (occ_tester.Unoccluded(scene)) {
                     // Evaluate BRDF
                     SSESpectrum f = interaction.bsdf->f(wo_world, wi, brdf_types);
                     if (!IsBlack(f)) {
-                        Ld += f * Li * AbsDotProductSSE(wi, interaction.normal) / pdf_Li;
+                        // Lights at infinity are also sampled through the BSDF, weight the two strategies
+                        const float weight = light->IsInfiniteLight() ?
+                                             PowerHeuristic(pdf_Li, interaction.bsdf->Pdf(wo_world, wi, brdf_types))
+                                                                      : 1.f;
+                        Ld += f * Li * AbsDotProductSSE(wi, interaction.normal) * weight / pdf_Li;
+                    }
+                }
+            }
+            if (light->IsInfiniteLight()) {
+                // Sample the BSDF, the light contributes if the ray leaves the scene
+                float pdf_f;
+                SSESpectrum f = interaction.bsdf->Sample_f(wo_world, &wi, &pdf_f, rng(), rng(), brdf_types);
+                if (!IsBlack(f) && pdf_f != 0.f) {
+                    const Ray ray = interaction.SpawnRay(wi);
+                    if (!scene.IntersectP(ray)) {
+                        Li = light->Le(ray);
+                        if (!IsBlack(Li)) {
+                            const float weight = PowerHeuristic(pdf_f, light->Pdf_Li(interaction, wi));
+                            Ld += f * Li * AbsDotProductSSE(wi, interaction.normal) * weight / pdf_f;
+                        }
                     }
                 }
             }
@@ -67,40 +113,40 @@ namespace pixel {
         return Ld;
     }
 
-    SSESpectrum SpecularReflection(const SurfaceInteraction &interaction, const SSEVector &wo_world,
-                                   const SurfaceIntegratorInterface *const integrator, const Scene &scene,
-                                   uint32_t depth) {
+    SSESpectrum SpecularReflect(const SurfaceInteraction &interaction, const Ray &ray, const SSEVector &wo_world,
+                                const SurfaceIntegratorInterface *const integrator, const Scene &scene,
+                                uint32_t depth) {
         SSESpectrum Ls(0.f);
+        RandomGenerator &rng = ThreadRandomGenerator();
         // Type of BRDF to check for direct illumination
         BRDF_TYPE brdf_types = BRDF_TYPE(BRDF_REFLECTION | BRDF_SPECULAR);
         // Sample specular BRDF
         SSEVector world_wi;
         float pdf;
-        SSESpectrum f = interaction.bsdf->Sample_f(wo_world, &world_wi, &pdf, distribution(generator),
-                                                   distribution(generator), brdf_types);
+        SSESpectrum f = interaction.bsdf->Sample_f(wo_world, &world_wi, &pdf, rng(), rng(), brdf_types);
         if (pdf > 0.f && !IsBlack(f)) {
             // Create specular ray
-            Ray specular_ray = interaction.SpawnRay(world_wi, depth);
+            Ray specular_ray = interaction.SpawnSpecularRay(ray, world_wi, false, depth);
             Ls = f * integrator->IncomingRadiance(specular_ray, scene) / pdf;
         }
 
         return Ls;
     }
 
-    SSESpectrum SpecularRefraction(const SurfaceInteraction &interaction, const SSEVector &wo_world,
-                                   const SurfaceIntegratorInterface *const integrator, const Scene &scene,
-                                   uint32_t depth) {
+    SSESpectrum SpecularTransmit(const SurfaceInteraction &interaction, const Ray &ray, const SSEVector &wo_world,
+                                 const SurfaceIntegratorInterface *const integrator, const Scene &scene,
+                                 uint32_t depth) {
         SSESpectrum Ls(0.f);
+        RandomGenerator &rng = ThreadRandomGenerator();
         // Type of BRDF to check for direct illumination
         BRDF_TYPE brdf_types = BRDF_TYPE(BRDF_TRANSMISSION | BRDF_SPECULAR);
         // Sample specular BRDF
         SSEVector world_wi;
         float pdf;
-        SSESpectrum f = interaction.bsdf->Sample_f(wo_world, &world_wi, &pdf, distribution(generator),
-                                                   distribution(generator), brdf_types);
+        SSESpectrum f = interaction.bsdf->Sample_f(wo_world, &world_wi, &pdf, rng(), rng(), brdf_types);
         if (pdf > 0.f && !IsBlack(f)) {
             // Create specular ray
-            Ray specular_ray = interaction.SpawnRay(world_wi, depth);
+            Ray specular_ray = interaction.SpawnSpecularRay(ray, world_wi, true, depth);
             Ls = f * integrator->IncomingRadiance(specular_ray, scene) / pdf;
         }
 
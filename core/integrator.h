@@ -42,8 +42,8 @@ namespace pixel {
         // Destructor
         virtual ~IntegratorInterface() {}
 
-        // Preprocess
-        virtual void Preprocess() const = 0;
+        // Preprocess, called by the renderer before the first sample
+        virtual void Preprocess(const Scene &scene) const = 0;
     };
 
     // Define surface integrator base class
@@ -51,21 +51,43 @@ namespace pixel {
     public:
         // Compute incoming radiance from a given ray
         virtual SSESpectrum IncomingRadiance(const Ray &ray, const Scene &scene) const = 0;
+
+        // Compute incoming radiance for a batch of rays, integrators that shade hits together override it. The
+        // auxiliary values of the first hit of each ray are stored in aovs if given, by tracing the rays again
+        // unless the integrator records them from its own hits
+        virtual void IncomingRadianceBatch(const Ray *const rays, uint32_t count, const Scene &scene,
+                                           SSESpectrum *const L, AOVSample *const aovs = nullptr) const;
+
+        // Called by the renderer between passes over the image, not after the last one. Integrators that learn
+        // from the samples of a pass override it
+        virtual void EndPass() const {}
+
+        // Largest number of samples per pixel in a pass, integrators refining their estimate between passes
+        // may ask for more of them
+        virtual uint32_t MaxPassSamples() const {
+            return UINT32_MAX;
+        }
     };
 
     // Estimate direct illumination at given SurfaceInteraction
     SSESpectrum DirectIllumination(const SurfaceInteraction &interaction, const SSEVector &wo_world,
                                    const Scene &scene);
 
-    // Estimate specular reflection
-    SSESpectrum SpecularReflection(const SurfaceInteraction &interaction, const SSEVector &wo_world,
-                                   const SurfaceIntegratorInterface *const integrator, const Scene &scene,
-                                   uint32_t depth);
+    // Store the auxiliary values of a hit, whose BSDF is already generated, seen along a ray
+    void RecordAOVs(const SurfaceInteraction &interaction, const Ray &ray, AOVSample *const aov);
+
+    // Trace a ray to store the auxiliary values of its first hit
+    void FirstHitAOVs(const Ray &ray, const Scene &scene, AOVSample *const aov);
+
+    // Estimate specular reflection, the differentials of the incoming ray are carried over
+    SSESpectrum SpecularReflect(const SurfaceInteraction &interaction, const Ray &ray, const SSEVector &wo_world,
+                                const SurfaceIntegratorInterface *const integrator, const Scene &scene,
+                                uint32_t depth);
 
     // Estimate specular refraction
-    SSESpectrum SpecularRefraction(const SurfaceInteraction &interaction, const SSEVector &wo_world,
-                                   const SurfaceIntegratorInterface *const integrator, const Scene &scene,
-                                   uint32_t depth);
+    SSESpectrum SpecularTransmit(const SurfaceInteraction &interaction, const Ray &ray, const SSEVector &wo_world,
+                                 const SurfaceIntegratorInterface *const integrator, const Scene &scene,
+                                 uint32_t depth);
 
 }
 
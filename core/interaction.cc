@@ -28,8 +28,16 @@
 
 namespace pixel {
 
+    // Coordinate of a vector by index
+    static inline float Component(const SSEVector &v, uint32_t i) {
+        return (&v.x)[i];
+    }
+
     SurfaceInteraction::SurfaceInteraction()
-            : hit_point(), normal(), s(), t(), u(0.f), v(0.f), prim_ptr(nullptr), mat_ptr(nullptr), bsdf(nullptr) {}
+            : hit_point(), normal(), s(), t(), u(0.f), v(0.f), dpdu(), dpdv(), dndu(), dndv(), dpdx(), dpdy(),
+              dudx(0.f), dvdx(0.f), dudy(0.f), dvdy(0.f), prim_ptr(nullptr), prim_index(0),
+              instance_ptr(nullptr),
+              mat_ptr(nullptr), bsdf(nullptr) {}
 
 //    SurfaceInteraction::~SurfaceInteraction() {
 //        delete bsdf;
@@ -39,8 +47,9 @@ namespace pixel {
                                            const SSEVector &s, const SSEVector &t, float u, float v,
                                            const PrimitiveInterface *prim_ptr,
                                            const MaterialInterface *const mat_ptr)
-            : hit_point(hit), normal(n), s(s), t(t), u(u), v(v),
-              prim_ptr(prim_ptr), mat_ptr(mat_ptr), bsdf(nullptr) {
+            : hit_point(hit), normal(n), s(s), t(t), u(u), v(v), dpdu(), dpdv(), dndu(), dndv(), dpdx(), dpdy(),
+              dudx(0.f), dvdx(0.f), dudy(0.f), dvdy(0.f), prim_ptr(prim_ptr), prim_index(0),
+              instance_ptr(nullptr), mat_ptr(mat_ptr), bsdf(nullptr) {
     }
 
     SSESpectrum SurfaceInteraction::EmittedRadiance(const SSEVector &w) const {
@@ -51,21 +60,114 @@ namespace pixel {
         return Ray(hit_point, dir, EPS, INFINITY, depth);
     }
 
+    Ray SurfaceInteraction::SpawnSpecularRay(const Ray &ray, const SSEVector &wi, bool transmission,
+                                             uint32_t depth) const {
+        Ray spawned = SpawnRay(wi, depth);
+        if (!ray.HasDifferentials()) {
+            return spawned;
+        }
+        const RayDifferential &diff = ray.Differentials();
+        const SSEVector wo = Normalize(-ray.Direction());
+        SSEVector n = normal;
+        // Change of the normal across the footprint
+        SSEVector dndx = dndu * dudx + dndv * dvdx;
+        SSEVector dndy = dndu * dudy + dndv * dvdy;
+        const SSEVector dwodx = -Normalize(diff.rx_direction) - wo;
+        const SSEVector dwody = -Normalize(diff.ry_direction) - wo;
+
+        RayDifferential spawned_diff;
+        spawned_diff.rx_origin = hit_point + dpdx;
+        spawned_diff.ry_origin = hit_point + dpdy;
+        if (!transmission) {
+            // Differentiate the mirror direction
+            const float dDNdx = DotProduct(dwodx, n) + DotProduct(wo, dndx);
+            const float dDNdy = DotProduct(dwody, n) + DotProduct(wo, dndy);
+            const float cos_wo = DotProduct(wo, n);
+            spawned_diff.rx_direction = wi - dwodx + 2.f * (cos_wo * dndx + dDNdx * n);
+            spawned_diff.ry_direction = wi - dwody + 2.f * (cos_wo * dndy + dDNdy * n);
+        } else {
+            // Differentiate the refracted direction, the relative index depends on the side of the surface
+            float eta = 1.f / bsdf->eta;
+            if (DotProduct(wo, n) < 0.f) {
+                eta = 1.f / eta;
+                n = -n;
+                dndx = -dndx;
+                dndy = -dndy;
+            }
+            const float dDNdx = DotProduct(dwodx, n) + DotProduct(wo, dndx);
+            const float dDNdy = DotProduct(dwody, n) + DotProduct(wo, dndy);
+            const float cos_wo = DotProduct(wo, n);
+            const float cos_wi = AbsDotProduct(wi, n);
+            const float mu = eta * cos_wo - cos_wi;
+            const float dmu = eta - eta * eta * cos_wo / cos_wi;
+            spawned_diff.rx_direction = wi - eta * dwodx + (mu * dndx + dmu * dDNdx * n);
+            spawned_diff.ry_direction = wi - eta * dwody + (mu * dndy + dmu * dDNdy * n);
+        }
+        spawned.SetDifferentials(spawned_diff);
+
+        return spawned;
+    }
+
+    void SurfaceInteraction::ComputeDifferentials(const Ray &ray) {
+        dudx = dvdx = dudy = dvdy = 0.f;
+        dpdx = dpdy = SSEVector();
+        if (!ray.HasDifferentials()) { return; }
+
+        // Intersect the offset rays with the tangent plane
+        const RayDifferential &diff = ray.Differentials();
+        const float d = DotProduct3(normal, hit_point);
+        const float tx = (d - DotProduct3(normal, diff.rx_origin)) / DotProduct3(normal, diff.rx_direction);
+        const float ty = (d - DotProduct3(normal, diff.ry_origin)) / DotProduct3(normal, diff.ry_direction);
+        if (!std::isfinite(tx) || !std::isfinite(ty)) { return; }
+        dpdx = diff.rx_origin + tx * diff.rx_direction - hit_point;
+        dpdy = diff.ry_origin + ty * diff.ry_direction - hit_point;
+        dpdx.w = dpdy.w = 0.f;
+
+        // Solve dp = du * dpdu + dv * dpdv on the two axes least aligned with the normal
+        uint32_t dim[2];
+        if (std::abs(normal.x) > std::abs(normal.y) && std::abs(normal.x) > std::abs(normal.z)) {
+            dim[0] = 1;
+            dim[1] = 2;
+        } else if (std::abs(normal.y) > std::abs(normal.z)) {
+            dim[0] = 0;
+            dim[1] = 2;
+        } else {
+            dim[0] = 0;
+            dim[1] = 1;
+        }
+        const float a00 = Component(dpdu, dim[0]), a01 = Component(dpdv, dim[0]);
+        const float a10 = Component(dpdu, dim[1]), a11 = Component(dpdv, dim[1]);
+        const float det = a00 * a11 - a01 * a10;
+        if (std::abs(det) < 1e-12f) { return; }
+        const float inv_det = 1.f / det;
+        dudx = (a11 * Component(dpdx, dim[0]) - a01 * Component(dpdx, dim[1])) * inv_det;
+        dvdx = (a00 * Component(dpdx, dim[1]) - a10 * Component(dpdx, dim[0])) * inv_det;
+        dudy = (a11 * Component(dpdy, dim[0]) - a01 * Component(dpdy, dim[1])) * inv_det;
+        dvdy = (a00 * Component(dpdy, dim[1]) - a10 * Component(dpdy, dim[0])) * inv_det;
+        if (!std::isfinite(dudx) || !std::isfinite(dvdx) || !std::isfinite(dudy) || !std::isfinite(dvdy)) {
+            dudx = dvdx = dudy = dvdy = 0.f;
+        }
+    }
+
     void SurfaceInteraction::GenerateBSDF() {
         bsdf = mat_ptr->GetBSDF(*this);
     }
 
-    void TransformSurfaceInteraction(SurfaceInteraction *const interaction, const SSEMatrix &mat) {
+    void TransformSurfaceInteraction(SurfaceInteraction *const interaction, const SSEMatrix &mat,
+                                     const SSEMatrix &inverse) {
         // Transform hit_point
         interaction->hit_point = mat * interaction->hit_point;
-        // Transform normal
-        interaction->normal = Transpose(Inverse(mat)) * interaction->normal;
-        // Small correction we need to consider or normalization will be incorrect
-        interaction->normal.w = 0.f;
+        // Transform normal, w is cleared for the normalization
+        interaction->normal = TransformNormal(inverse, interaction->normal);
         Normalize(&(interaction->normal));
         // Transform tangent space
         interaction->s = Normalize(mat * interaction->s);
         interaction->t = Normalize(mat * interaction->t);
+        // Transform the partial derivatives, the normal ones like normals
+        interaction->dpdu = mat * interaction->dpdu;
+        interaction->dpdv = mat * interaction->dpdv;
+        interaction->dndu = TransformNormal(inverse, interaction->dndu);
+        interaction->dndv = TransformNormal(inverse, interaction->dndv);
     }
 
 }
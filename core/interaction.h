@@ -57,6 +57,12 @@ namespace pixel {
         // Spawn ray in given direction
         Ray SpawnRay(const SSEVector &dir, uint32_t depth = 0) const;
 
+        // Spawn the ray of a specular bounce, carrying over the differentials of the incoming ray
+        Ray SpawnSpecularRay(const Ray &ray, const SSEVector &wi, bool transmission, uint32_t depth = 0) const;
+
+        // Estimate the footprint of the ray on the surface from its differentials, cleared without them
+        void ComputeDifferentials(const Ray &ray);
+
         // Generate the BSDF
         void GenerateBSDF();
 
@@ -68,17 +74,27 @@ namespace pixel {
         SSEVector s, t;
         // UV coordinates
         float u, v;
+        // Partial derivatives of the hit point and of the normal along u and v
+        SSEVector dpdu, dpdv;
+        SSEVector dndu, dndv;
+        // Variation of the hit point and of the uv coordinates between neighbor pixels
+        SSEVector dpdx, dpdy;
+        float dudx, dvdx, dudy, dvdy;
         // Primitive hit
         const PrimitiveInterface *prim_ptr;
+        // Element hit inside the primitive, for primitives grouping several of them
+        uint32_t prim_index;
+        // Instance placing the primitive hit in the world, if any
+        const PrimitiveInterface *instance_ptr;
         // Primitive material
         const MaterialInterface *mat_ptr;
         // BSDF
         std::unique_ptr<const BSDF> bsdf;
     };
 
-    // Transform surface_interaction for a given matrix
+    // Transform surface_interaction for a given matrix, its inverse is needed for the normal
     void TransformSurfaceInteraction(SurfaceInteraction *const interaction,
-                                     const SSEMatrix &mat);
+                                     const SSEMatrix &mat, const SSEMatrix &inverse);
 
 }
 
@@ -0,0 +1,235 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2016 simon.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "irradiance_cache.h"
+#include "interaction.h"
+#include "ray.h"
+#include "montecarlo.h"
+
+#include <mutex>
+
+namespace pixel {
+
+    // Strata of the hemisphere gathered for a record along theta and phi, about pi times as many along phi
+    static const uint32_t THETA_STRATA = 8;
+    static const uint32_t PHI_STRATA = 25;
+
+    // Smallest and largest record radius relative to the scene diagonal
+    static const float MIN_RADIUS_FRACTION = 0.001f;
+    static const float MAX_RADIUS_FRACTION = 0.1f;
+
+    // Deepest level of the octree
+    static const uint32_t MAX_OCTREE_DEPTH = 16;
+
+    // Add the components of v times s to the spectra of a gradient along each axis
+    static void AddGradient(SSESpectrum *const gradient, const SSEVector &v, const SSESpectrum &s) {
+        gradient[0] += v.x * s;
+        gradient[1] += v.y * s;
+        gradient[2] += v.z * s;
+    }
+
+    // Change of the spectrum of a gradient along v
+    static SSESpectrum GradientDot(const SSESpectrum *const gradient, const SSEVector &v) {
+        return SSESpectrum(v.x * gradient[0] + SSESpectrum(v.y * gradient[1]) + SSESpectrum(v.z * gradient[2]));
+    }
+
+    IrradianceCache::Node::Node()
+            : child{0, 0, 0, 0, 0, 0, 0, 0} {
+    }
+
+    IrradianceCache::IrradianceCache(const BBox &bounds, float accuracy)
+            : bounds(bounds), accuracy(accuracy),
+              min_radius(MIN_RADIUS_FRACTION * Length(bounds.Max() - bounds.Min())),
+              max_radius(MAX_RADIUS_FRACTION * Length(bounds.Max() - bounds.Min())), nodes(1) {
+    }
+
+    IrradianceRecord IrradianceCache::Gather(const SurfaceInteraction &interaction, const SSEVector &n,
+                                             const std::function<SSESpectrum(const Ray &, float *const)> &Li,
+                                             RandomGenerator *const rng) const {
+        const uint32_t M = THETA_STRATA, N = PHI_STRATA;
+        SSEVector u, v;
+        CoordinateSystem(n, &u, &v);
+        IrradianceRecord record;
+        record.p = interaction.hit_point;
+        record.n = n;
+        // Trace one cosine weighted direction per stratum, stratum (j, k) covers sin^2 theta in [j, j + 1] / M
+        // and phi in [k, k + 1] 2 pi / N
+        SSESpectrum L[THETA_STRATA][PHI_STRATA];
+        float r[THETA_STRATA][PHI_STRATA];
+        float inv_r = 0.f;
+        for (uint32_t j = 0; j < M; j++) {
+            for (uint32_t k = 0; k < N; k++) {
+                const float sin_theta = std::sqrt((j + (*rng)()) / M);
+                const float cos_theta = std::sqrt(std::max(0.f, 1.f - sin_theta * sin_theta));
+                const float phi = TWO_PI * (k + (*rng)()) / N;
+                L[j][k] = Li(interaction.SpawnRay(SphericalDirection(sin_theta, cos_theta, phi, u, n, v)), &r[j][k]);
+                r[j][k] = std::max(r[j][k], EPS);
+                inv_r += 1.f / r[j][k];
+                record.E += L[j][k];
+                // Tilting the normal towards the sample direction raises its cosine by tan theta
+                const float tan_theta = sin_theta / std::max(cos_theta, EPS);
+                const SSEVector w(-std::sin(phi) * u + std::cos(phi) * v);
+                AddGradient(record.rotation_gradient, w, SSESpectrum(-tan_theta * L[j][k]));
+            }
+        }
+        const float scale = PI / (M * N);
+        record.E *= scale;
+        for (uint32_t a = 0; a < 3; a++) {
+            record.rotation_gradient[a] *= scale;
+        }
+        // Translational gradient of Ward and Heckbert, from the change of the radiance across the boundaries of
+        // the strata, moving as the point moves depending on the distance to the surfaces seen
+        for (uint32_t k = 0; k < N; k++) {
+            const float phi = TWO_PI * (k + 0.5f) / N;
+            const float phi_min = TWO_PI * k / N;
+            const SSEVector u_k(std::cos(phi) * u + std::sin(phi) * v);
+            const SSEVector v_k(-std::sin(phi_min) * u + std::cos(phi_min) * v);
+            SSESpectrum dtheta, dphi;
+            for (uint32_t j = 1; j < M; j++) {
+                const float sin_2 = static_cast<float>(j) / M;
+                dtheta += SSESpectrum((std::sqrt(sin_2) * (1.f - sin_2) / std::min(r[j][k], r[j - 1][k])) *
+                                      SSESpectrum(L[j][k] - L[j - 1][k]));
+            }
+            dtheta *= TWO_PI / N;
+            const uint32_t k_prev = (k + N - 1) % N;
+            for (uint32_t j = 0; j < M; j++) {
+                const float sin_delta = std::sqrt(static_cast<float>(j + 1) / M) - std::sqrt(static_cast<float>(j) / M);
+                dphi += SSESpectrum((sin_delta / std::min(r[j][k], r[j][k_prev])) *
+                                    SSESpectrum(L[j][k] - L[j][k_prev]));
+            }
+            AddGradient(record.translation_gradient, u_k, dtheta);
+            AddGradient(record.translation_gradient, v_k, dphi);
+        }
+        // Harmonic mean distance, limited so that the gradient does not extrapolate past the irradiance itself
+        record.radius = inv_r > 0.f ? (M * N) / inv_r : INFINITY;
+        const SSEVector gradient(record.translation_gradient[0].r + record.translation_gradient[0].g +
+                                 record.translation_gradient[0].b,
+                                 record.translation_gradient[1].r + record.translation_gradient[1].g +
+                                 record.translation_gradient[1].b,
+                                 record.translation_gradient[2].r + record.translation_gradient[2].g +
+                                 record.translation_gradient[2].b, 0.f);
+        const float gradient_length = Length(gradient);
+        if (gradient_length > 0.f) {
+            record.radius = std::min(record.radius, (record.E.r + record.E.g + record.E.b) / gradient_length);
+        }
+        record.radius = Clamp(record.radius, min_radius, max_radius);
+
+        return record;
+    }
+
+    bool IrradianceCache::Interpolate(const SSEVector &p, const SSEVector &n, SSESpectrum *const E) const {
+        std::shared_lock<std::shared_timed_mutex> lock(mutex);
+        SSESpectrum sum;
+        float weight_sum = 0.f;
+        uint32_t node = 0;
+        BBox node_bounds(bounds);
+        while (true) {
+            for (uint32_t i : nodes[node].records) {
+                const IrradianceRecord &record = records[i];
+                const SSEVector d(p - record.p);
+                const float error = Length(d) / record.radius +
+                                    std::sqrt(std::max(0.f, 1.f - DotProduct(n, record.n)));
+                if (error >= accuracy) {
+                    continue;
+                }
+                // Records in front of the point see surfaces that may hide it
+                if (0.5f * DotProduct(d, n + record.n) < -0.01f * record.radius) {
+                    continue;
+                }
+                const float weight = 1.f / std::max(error, EPS) - 1.f / accuracy;
+                const SSESpectrum Ei(record.E + GradientDot(record.rotation_gradient, CrossProduct(record.n, n)) +
+                                     GradientDot(record.translation_gradient, d));
+                sum += weight * Ei;
+                weight_sum += weight;
+            }
+            // Go down to the child holding the point
+            const SSEVector center = node_bounds.Centroid();
+            const uint32_t c = (p.x > center.x ? 1 : 0) | (p.y > center.y ? 2 : 0) | (p.z > center.z ? 4 : 0);
+            if (nodes[node].child[c] == 0) {
+                break;
+            }
+            node = nodes[node].child[c];
+            node_bounds = ChildBound(node_bounds, c);
+        }
+        if (weight_sum == 0.f) {
+            return false;
+        }
+        // The gradients may extrapolate below zero
+        *E = SSESpectrum(_mm_max_ps(SSESpectrum(sum / weight_sum).xmm, _mm_setzero_ps()));
+
+        return true;
+    }
+
+    void IrradianceCache::Insert(const IrradianceRecord &record) {
+        std::unique_lock<std::shared_timed_mutex> lock(mutex);
+        const uint32_t i = static_cast<uint32_t>(records.size());
+        records.push_back(record);
+        // The record is used up to accuracy times its radius away
+        const float extent = accuracy * record.radius;
+        const SSEVector offset(extent, extent, extent, 0.f);
+        Insert(0, bounds, 0, i, BBox(SSEVector(record.p - offset), SSEVector(record.p + offset)));
+    }
+
+    void IrradianceCache::Insert(uint32_t node, const BBox &node_bounds, uint32_t depth, uint32_t record,
+                                 const BBox &record_bounds) {
+        // Keep the record here when the children would be smaller than it
+        if (depth == MAX_OCTREE_DEPTH || 0.25f * SqrdLength(node_bounds.Max() - node_bounds.Min()) <
+                                         SqrdLength(record_bounds.Max() - record_bounds.Min())) {
+            nodes[node].records.push_back(record);
+            return;
+        }
+        const SSEVector center = node_bounds.Centroid();
+        for (uint32_t c = 0; c < 8; c++) {
+            // Skip the children the record does not overlap
+            if ((c & 1) ? record_bounds.Max().x < center.x : record_bounds.Min().x > center.x) {
+                continue;
+            }
+            if ((c & 2) ? record_bounds.Max().y < center.y : record_bounds.Min().y > center.y) {
+                continue;
+            }
+            if ((c & 4) ? record_bounds.Max().z < center.z : record_bounds.Min().z > center.z) {
+                continue;
+            }
+            if (nodes[node].child[c] == 0) {
+                nodes[node].child[c] = static_cast<uint32_t>(nodes.size());
+                nodes.emplace_back();
+            }
+            Insert(nodes[node].child[c], ChildBound(node_bounds, c), depth + 1, record, record_bounds);
+        }
+    }
+
+    BBox IrradianceCache::ChildBound(const BBox &bounds, uint32_t c) {
+        const SSEVector center = bounds.Centroid();
+        return BBox(SSEVector((c & 1) ? center.x : bounds.Min().x, (c & 2) ? center.y : bounds.Min().y,
+                              (c & 4) ? center.z : bounds.Min().z, 1.f),
+                    SSEVector((c & 1) ? bounds.Max().x : center.x, (c & 2) ? bounds.Max().y : center.y,
+                              (c & 4) ? bounds.Max().z : center.z, 1.f));
+    }
+
+    uint32_t IrradianceCache::Size() const {
+        std::shared_lock<std::shared_timed_mutex> lock(mutex);
+        return static_cast<uint32_t>(records.size());
+    }
+
+}
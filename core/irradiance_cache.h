@@ -0,0 +1,113 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2016 simon.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * File:   irradiance_cache.h
+ * Author: simon
+ *
+ * Created on October 20, 2026, 1:40 AM
+ */
+
+#ifndef PIXEL_IRRADIANCE_CACHE_H
+#define PIXEL_IRRADIANCE_CACHE_H
+
+#include "pixel.h"
+#include "sse_vector.h"
+#include "sse_spectrum.h"
+#include "bbox.h"
+
+#include <functional>
+#include <shared_mutex>
+#include <vector>
+
+namespace pixel {
+
+    // Indirect irradiance gathered at a point of a diffuse surface
+    struct IrradianceRecord {
+        // Position and normal
+        SSEVector p, n;
+        // Harmonic mean distance to the surfaces seen from the point
+        float radius;
+        // Irradiance
+        SSESpectrum E;
+        // Change of the irradiance for a rotation of the normal and a translation of the point, along each axis
+        SSESpectrum rotation_gradient[3], translation_gradient[3];
+    };
+
+    // Define IrradianceCache class, an octree over the scene bounds holding irradiance records. Each record is
+    // used within the distance given by the error metric of Ward and is stored in the nodes about that size
+    // overlapping it, so a lookup only checks the records of the nodes on the way down to the point. Records
+    // may be inserted while other threads look up the cache
+    class IrradianceCache {
+    public:
+        // Constructor, records are used while the error metric of Ward stays below accuracy
+        IrradianceCache(const BBox &bounds, float accuracy);
+
+        // Gather a new record at an interaction, over the hemisphere around n. Li returns the incident radiance
+        // along a ray and the distance to its first hit. The directions are jittered with the caller generator
+        IrradianceRecord Gather(const SurfaceInteraction &interaction, const SSEVector &n,
+                                const std::function<SSESpectrum(const Ray &, float *const)> &Li,
+                                RandomGenerator *const rng) const;
+
+        // Interpolate the irradiance at p with normal n, returns false when no record is close enough
+        bool Interpolate(const SSEVector &p, const SSEVector &n, SSESpectrum *const E) const;
+
+        // Add a record
+        void Insert(const IrradianceRecord &record);
+
+        // Number of records
+        uint32_t Size() const;
+
+    private:
+        // Node of the octree, child c covers the octant on the maximum side along the axes of its set bits
+        struct Node {
+            Node();
+
+            // Records overlapping the node, and its children, 0 when missing
+            std::vector<uint32_t> records;
+            uint32_t child[8];
+        };
+
+        // Bounds of a child of a node
+        static BBox ChildBound(const BBox &bounds, uint32_t c);
+
+        // Store a record in a node or in its children overlapping the record bounds
+        void Insert(uint32_t node, const BBox &bounds, uint32_t depth, uint32_t record, const BBox &record_bounds);
+
+        // Scene bounds
+        const BBox bounds;
+        // Largest error of the records used
+        const float accuracy;
+        // Smallest and largest radius of the records
+        const float min_radius, max_radius;
+        // Nodes, the root is first, and records
+        std::vector<Node> nodes;
+        std::vector<IrradianceRecord> records;
+        // Lookups share the cache, insertions own it
+        mutable std::shared_timed_mutex mutex;
+    };
+
+}
+
+#endif //PIXEL_IRRADIANCE_CACHE_H
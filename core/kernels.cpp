@@ -0,0 +1,87 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2016 simon.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "kernels.h"
+#include <cstdlib>
+#include <cstring>
+
+namespace pixel {
+
+    // Kernel tables, one per translation unit built with different target flags
+    namespace kernels_sse42 {
+        extern const KernelTable KERNEL_TABLE;
+    }
+
+    namespace kernels_avx2 {
+        extern const KernelTable KERNEL_TABLE;
+    }
+
+    namespace kernels_avx512 {
+        extern const KernelTable KERNEL_TABLE;
+    }
+
+    ISA DetectISA() {
+        // The CPU checks include the operating system support of the wider registers
+        __builtin_cpu_init();
+        ISA isa = ISA::SSE42;
+        // The wider targets also convert half precision values
+        if (__builtin_cpu_supports("f16c")) {
+            if (__builtin_cpu_supports("avx512f")) {
+                isa = ISA::AVX512;
+            } else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+                isa = ISA::AVX2;
+            }
+        }
+        // Allow a lower instruction set to be forced, useful to compare targets on the same machine
+        const char *const forced = std::getenv("PIXEL_ISA");
+        if (forced != nullptr) {
+            if (std::strcmp(forced, "sse4.2") == 0) {
+                isa = ISA::SSE42;
+            } else if (std::strcmp(forced, "avx2") == 0 && isa == ISA::AVX512) {
+                isa = ISA::AVX2;
+            }
+        }
+
+        return isa;
+    }
+
+    // Table of the best supported instruction set
+    static const KernelTable &SelectKernels() {
+        switch (DetectISA()) {
+            case ISA::AVX512:
+                return kernels_avx512::KERNEL_TABLE;
+            case ISA::AVX2:
+                return kernels_avx2::KERNEL_TABLE;
+            default:
+                return kernels_sse42::KERNEL_TABLE;
+        }
+    }
+
+    const KernelTable &Kernels() {
+        static const KernelTable &kernels = SelectKernels();
+
+        return kernels;
+    }
+
+}
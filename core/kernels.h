@@ -0,0 +1,99 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2016 simon.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * File:   kernels.h
+ * Author: simon
+ *
+ * Created on October 19, 2026, 5:20 PM
+ */
+
+#ifndef PIXEL_KERNELS_H
+#define PIXEL_KERNELS_H
+
+#include <cstdint>
+
+// Hot loops compiled once per instruction set, the best one supported by the CPU is picked at startup.
+// The kernels only take plain arrays so that no inline function of the renderer is compiled for a
+// wider instruction set than the baseline
+
+namespace pixel {
+
+    // Instruction sets with a kernel build, ordered from the baseline
+    enum class ISA {
+        SSE42, AVX2, AVX512
+    };
+
+    // Intersect a ray with sphere_packet_width spheres stored as SoA. Returns the mask of the spheres hit, their
+    // nearest distances in [t_min, t_max] are stored in t_hit
+    typedef uint32_t (*IntersectSpheresKernel)(const float *x, const float *y, const float *z, const float *r,
+                                               const float *origin, const float *direction,
+                                               float t_min, float t_max, float *t_hit);
+
+    // Clamp values to [0, 1], correct gamma and scale them to [0, 255]
+    typedef void (*ToneMapKernel)(const float *values, uint32_t count, float gamma, int32_t *out);
+
+    // Planar images read by the denoising kernel, each plane holds width * height floats
+    struct DenoiseImages {
+        const float *color[3];
+        const float *albedo[3];
+        const float *normal[3];
+        // Inverse of the color variance of each pixel
+        const float *inv_variance;
+        uint32_t width, height;
+    };
+
+    // One a-trous iteration over a row, a 5x5 B3 spline with holes of step pixels. The neighbors are weighted
+    // by 2^-(|dc|^2 inv_variance color_weight + |da|^2 albedo_weight + |dn|^2 normal_weight), the filtered
+    // colors are stored in the three planes of out
+    typedef void (*AtrousRowKernel)(const DenoiseImages &images, uint32_t row, uint32_t step, float color_weight,
+                                    float albedo_weight, float normal_weight, float *const *out);
+
+    // Convert floats to IEEE half precision, rounding to nearest even, and back
+    typedef void (*FloatToHalfKernel)(const float *values, uint32_t count, uint16_t *out);
+
+    typedef void (*HalfToFloatKernel)(const uint16_t *values, uint32_t count, float *out);
+
+    // Define the kernels of an instruction set
+    struct KernelTable {
+        ISA isa;
+        const char *name;
+        IntersectSpheresKernel intersect_spheres;
+        uint32_t sphere_packet_width;
+        ToneMapKernel tone_map;
+        AtrousRowKernel atrous_row;
+        FloatToHalfKernel float_to_half;
+        HalfToFloatKernel half_to_float;
+    };
+
+    // Best instruction set supported by the CPU, the PIXEL_ISA environment variable (sse4.2, avx2 or
+    // avx512) can lower it
+    ISA DetectISA();
+
+    // Kernels selected on first use
+    const KernelTable &Kernels();
+
+}
+
+#endif //PIXEL_KERNELS_H
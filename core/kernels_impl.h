@@ -0,0 +1,232 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2016 simon.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * File:   kernels_impl.h
+ * Author: simon
+ *
+ * Created on October 19, 2026, 5:20 PM
+ */
+
+// Kernel bodies, included once per instruction set by kernels_sse42.cpp, kernels_avx2.cpp and
+// kernels_avx512.cpp which define PIXEL_KERNEL_NAMESPACE and PIXEL_KERNEL_ISA. Only the wide types, the SoA
+// vectors built on them and the functions of this file can be used here, anything else would be compiled for
+// the wrong target
+
+#ifndef PIXEL_KERNEL_NAMESPACE
+#error "kernels_impl.h must be included by a kernel translation unit"
+#endif
+
+#include "kernels.h"
+#include "simd_float.h"
+#include "soa_vector.h"
+#include "half.h"
+
+namespace pixel {
+namespace PIXEL_KERNEL_NAMESPACE {
+
+    // Spheres intersected together, AVX-512 tests 16 of them in one register and the other targets 8
+#ifdef PIXEL_SIMD_AVX512
+    typedef Floatx16 SphereFloat;
+    typedef Vec3x16 SphereVector;
+#else
+    typedef Floatx8 SphereFloat;
+    typedef Vec3x8 SphereVector;
+#endif
+
+    static uint32_t IntersectSpheres(const float *const x, const float *const y, const float *const z,
+                                     const float *const r, const float *const origin,
+                                     const float *const direction, float t_min, float t_max,
+                                     float *const t_hit) {
+        const SphereVector d = SphereVector(SphereFloat(direction[0]), SphereFloat(direction[1]),
+                                            SphereFloat(direction[2]));
+        // Vector from the centers to the ray origin
+        const SphereVector oc = SphereVector(SphereFloat(origin[0]), SphereFloat(origin[1]), SphereFloat(origin[2])) -
+                                SphereVector::Load(x, y, z);
+        const SphereFloat radius = SphereFloat::Load(r);
+        // Quadratic a t^2 + 2 b t + c = 0. The kernels are built without contraction to fused operations so
+        // that all targets find the same hits
+        const SphereFloat a = DotProduct(d, d);
+        const SphereFloat b = DotProduct(oc, d);
+        const SphereFloat c = DotProduct(oc, oc) - radius * radius;
+        const SphereFloat discriminant = b * b - a * c;
+        // Stable roots, q = -(b + sign(b) sqrt(discriminant))
+        const SphereFloat root = Sqrt(Max(discriminant, SphereFloat(0.f)));
+        const SphereFloat q = Select(b < SphereFloat(0.f), root - b, -(b + root));
+        const SphereFloat t0 = q / a;
+        const SphereFloat t1 = c / q;
+        const SphereFloat t_near = Min(t0, t1);
+        const SphereFloat t_far = Max(t0, t1);
+        // Use the far root when the near one is behind the ray minimum
+        const SphereFloat minimum(t_min);
+        const SphereFloat t = Select(t_near >= minimum, t_near, t_far);
+        const auto hit = (discriminant >= SphereFloat(0.f)) & (t >= minimum) & (t <= SphereFloat(t_max));
+        t.Store(t_hit);
+
+        return MoveMask(hit);
+    }
+
+    static void ToneMap(const float *const values, uint32_t count, float gamma, int32_t *const out) {
+        const Floatx16 g(gamma);
+        float lanes[Floatx16::WIDTH];
+        for (uint32_t begin = 0; begin < count; begin += Floatx16::WIDTH) {
+            const uint32_t n = (count - begin < Floatx16::WIDTH) ? count - begin : Floatx16::WIDTH;
+            // Pad the last group with zeros
+            const float *source = values + begin;
+            if (n < Floatx16::WIDTH) {
+                for (uint32_t i = 0; i < Floatx16::WIDTH; i++) {
+                    lanes[i] = (i < n) ? source[i] : 0.f;
+                }
+                source = lanes;
+            }
+            const Floatx16 v = Min(Max(Floatx16::Load(source), Floatx16(0.f)), Floatx16(1.f));
+            (Pow(v, g) * Floatx16(255.f)).Store(lanes);
+            for (uint32_t i = 0; i < n; i++) {
+                out[begin + i] = static_cast<int32_t>(lanes[i]);
+            }
+        }
+    }
+
+    // Clamp v to [0, last], written out so that no standard library template is compiled for this target
+    static inline int32_t ClampIndex(int32_t v, int32_t last) {
+        return (v < 0) ? 0 : ((v > last) ? last : v);
+    }
+
+    // Load 8 values of a row starting at x, the pixels outside of the row repeat its border
+    static inline Floatx8 LoadClamped(const float *const row, int32_t x, int32_t width) {
+        if (x >= 0 && x + static_cast<int32_t>(Floatx8::WIDTH) <= width) {
+            return Floatx8::Load(row + x);
+        }
+        float lanes[Floatx8::WIDTH];
+        for (int32_t i = 0; i < static_cast<int32_t>(Floatx8::WIDTH); i++) {
+            lanes[i] = row[ClampIndex(x + i, width - 1)];
+        }
+
+        return Floatx8::Load(lanes);
+    }
+
+    static void AtrousRow(const DenoiseImages &images, uint32_t row, uint32_t step, float color_weight,
+                          float albedo_weight, float normal_weight, float *const *out) {
+        // B3 spline taps
+        static const float taps[5] = {1.f / 16.f, 1.f / 4.f, 3.f / 8.f, 1.f / 4.f, 1.f / 16.f};
+        const int32_t width = static_cast<int32_t>(images.width);
+        const int32_t height = static_cast<int32_t>(images.height);
+        const Floatx8 wc(color_weight);
+        const Floatx8 wa(albedo_weight);
+        const Floatx8 wn(normal_weight);
+        float lanes[Floatx8::WIDTH];
+        for (int32_t x = 0; x < width; x += Floatx8::WIDTH) {
+            // Center pixels
+            const uint32_t center = row * images.width;
+            Floatx8 c[3], a[3], n[3];
+            for (uint32_t k = 0; k < 3; k++) {
+                c[k] = LoadClamped(images.color[k] + center, x, width);
+                a[k] = LoadClamped(images.albedo[k] + center, x, width);
+                n[k] = LoadClamped(images.normal[k] + center, x, width);
+            }
+            const Floatx8 color_scale = LoadClamped(images.inv_variance + center, x, width) * wc;
+            Floatx8 sum_weights(0.f);
+            Floatx8 sum[3] = {Floatx8(0.f), Floatx8(0.f), Floatx8(0.f)};
+            for (int32_t dy = -2; dy <= 2; dy++) {
+                const int32_t y = ClampIndex(static_cast<int32_t>(row) + dy * static_cast<int32_t>(step), height - 1);
+                const uint32_t offset = static_cast<uint32_t>(y) * images.width;
+                for (int32_t dx = -2; dx <= 2; dx++) {
+                    const int32_t xq = x + dx * static_cast<int32_t>(step);
+                    Floatx8 cq[3];
+                    Floatx8 color_distance(0.f), albedo_distance(0.f), normal_distance(0.f);
+                    for (uint32_t k = 0; k < 3; k++) {
+                        cq[k] = LoadClamped(images.color[k] + offset, xq, width);
+                        const Floatx8 dc = cq[k] - c[k];
+                        const Floatx8 da = LoadClamped(images.albedo[k] + offset, xq, width) - a[k];
+                        const Floatx8 dn = LoadClamped(images.normal[k] + offset, xq, width) - n[k];
+                        color_distance = MulAdd(dc, dc, color_distance);
+                        albedo_distance = MulAdd(da, da, albedo_distance);
+                        normal_distance = MulAdd(dn, dn, normal_distance);
+                    }
+                    const Floatx8 exponent = color_distance * color_scale + albedo_distance * wa +
+                                             normal_distance * wn;
+                    const Floatx8 w = Floatx8(taps[dx + 2] * taps[dy + 2]) * Exp2(-exponent);
+                    sum_weights = sum_weights + w;
+                    for (uint32_t k = 0; k < 3; k++) {
+                        sum[k] = MulAdd(w, cq[k], sum[k]);
+                    }
+                }
+            }
+            // The center always has a weight of 9 / 64, so the sum is never 0
+            const uint32_t left = static_cast<uint32_t>(width - x);
+            const uint32_t n_lanes = (left < Floatx8::WIDTH) ? left : Floatx8::WIDTH;
+            for (uint32_t k = 0; k < 3; k++) {
+                const Floatx8 filtered = sum[k] / sum_weights;
+                if (n_lanes == Floatx8::WIDTH) {
+                    filtered.Store(out[k] + center + x);
+                } else {
+                    filtered.Store(lanes);
+                    for (uint32_t i = 0; i < n_lanes; i++) {
+                        out[k][center + x + i] = lanes[i];
+                    }
+                }
+            }
+        }
+    }
+
+    static void FloatToHalf(const float *const values, uint32_t count, uint16_t *const out) {
+        uint32_t i = 0;
+#ifdef __F16C__
+        for (; i + 8 <= count; i += 8) {
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i),
+                             _mm256_cvtps_ph(_mm256_loadu_ps(values + i), _MM_FROUND_TO_NEAREST_INT));
+        }
+        for (; i < count; i++) {
+            out[i] = static_cast<uint16_t>(_cvtss_sh(values[i], _MM_FROUND_TO_NEAREST_INT));
+        }
+#else
+        for (; i < count; i++) {
+            out[i] = HalfFromFloat(values[i]);
+        }
+#endif
+    }
+
+    static void HalfToFloat(const uint16_t *const values, uint32_t count, float *const out) {
+        uint32_t i = 0;
+#ifdef __F16C__
+        for (; i + 8 <= count; i += 8) {
+            _mm256_storeu_ps(out + i, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(values + i))));
+        }
+        for (; i < count; i++) {
+            out[i] = _cvtsh_ss(values[i]);
+        }
+#else
+        for (; i < count; i++) {
+            out[i] = FloatFromHalf(values[i]);
+        }
+#endif
+    }
+
+    extern const KernelTable KERNEL_TABLE;
+
+    const KernelTable KERNEL_TABLE = {PIXEL_KERNEL_ISA, PIXEL_KERNEL_NAME, IntersectSpheres, SphereFloat::WIDTH,
+                                      ToneMap, AtrousRow, FloatToHalf, HalfToFloat};
+
+}
+}
@@ -34,15 +34,42 @@ namespace pixel {
         return false;
     }
 
+    bool LightInterface::IsInfiniteLight() const {
+        return false;
+    }
+
+    SSESpectrum LightInterface::Le(const Ray &) const {
+        return SSESpectrum(0.f);
+    }
+
+    SSESpectrum LightInterface::Sample_Le(float, float, float, float, Ray *const, SSEVector *const,
+                                          float *const pdf_pos, float *const pdf_dir) const {
+        *pdf_pos = *pdf_dir = 0.f;
+
+        return SSESpectrum(0.f);
+    }
+
+    void LightInterface::Pdf_Le(const Ray &, const SSEVector &, float *const pdf_pos, float *const pdf_dir) const {
+        *pdf_pos = *pdf_dir = 0.f;
+    }
+
     OcclusionTester::OcclusionTester(const SSEVector &from, const SSEVector &p)
-            : from(from), p(p) {
+            : from(from), direction(p - from), t_max(1.f - EPS) {
+    }
+
+    OcclusionTester::OcclusionTester(const SSEVector &from, const SSEVector &direction, float t_max)
+            : from(from), direction(direction), t_max(t_max) {
     }
 
     bool OcclusionTester::Unoccluded(const Scene &scene) const {
         // Create test ray
-        Ray occ_ray = Ray(from, p - from, EPS, 1.f - EPS);
+        Ray occ_ray = Ray(from, direction, EPS, t_max);
 
         return !scene.IntersectP(occ_ray);
     }
 
+    SSEVector OcclusionTester::End() const {
+        return SSEVector(from + direction);
+    }
+
 }
\ No newline at end of file
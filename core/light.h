@@ -35,6 +35,7 @@
 #include "pixel.h"
 #include "sse_matrix.h"
 #include "interaction.h"
+#include "sse_spectrum.h"
 
 namespace pixel {
 
@@ -47,12 +48,28 @@ namespace pixel {
         // Returns true if light is delta light
         virtual bool IsDeltaLight() const;
 
+        // Returns true if the light is at infinity and only reached by rays leaving the scene
+        virtual bool IsInfiniteLight() const;
+
+        // Radiance reaching a ray that leaves the scene, zero for lights with a finite position
+        virtual SSESpectrum Le(const Ray &ray) const;
+
         // Sample incoming light at a given SurfaceInteraction
         virtual SSESpectrum Sample_Li(const SurfaceInteraction &from, float u1, float u2,
                                       SSEVector *const wi, float *const pdf, OcclusionTester *const occ) const = 0;
 
         // Compute directional PDF to sample the given light direction from a given SurfaceInteraction
         virtual float Pdf_Li(const SurfaceInteraction &from, const SSEVector &wi) const = 0;
+
+        // Sample a ray leaving the light for paths traced from it, with the normal at its origin. The origin pdf
+        // is with respect to area and the direction one to solid angle, both are zero for lights that cannot
+        // start paths
+        virtual SSESpectrum Sample_Le(float u1, float u2, float u3, float u4, Ray *const ray,
+                                      SSEVector *const normal, float *const pdf_pos, float *const pdf_dir) const;
+
+        // Compute the pdfs of Sample_Le generating a given ray
+        virtual void Pdf_Le(const Ray &ray, const SSEVector &normal, float *const pdf_pos,
+                            float *const pdf_dir) const;
     };
 
     // Define occlusion tester class
@@ -63,12 +80,19 @@ namespace pixel {
 
         OcclusionTester(const SSEVector &from, const SSEVector &p);
 
+        // Test the ray from a point along a direction up to t_max, used for lights at infinity
+        OcclusionTester(const SSEVector &from, const SSEVector &direction, float t_max);
+
         // Check if the ray between the two interaction is occluded or not
         bool Unoccluded(const Scene &scene) const;
 
+        // Point tested against, only meaningful for testers between two points
+        SSEVector End() const;
+
     private:
         SSEVector from;
-        SSEVector p;
+        SSEVector direction;
+        float t_max;
     };
 
 }
@@ -35,6 +35,7 @@
 #include "pixel.h"
 #include "sse_spectrum.h"
 #include "interaction.h"
+#include <atomic>
 
 namespace pixel {
 
@@ -47,7 +48,7 @@ namespace pixel {
     public:
         // Constructor
         MaterialInterface(const MATERIAL_TYPE type)
-                : type(type) {
+                : type(type), id(NextID()) {
         }
 
         // Destructor
@@ -57,6 +58,14 @@ namespace pixel {
         // Creates the BSDF for a given SurfaceInteraction
         virtual std::unique_ptr<BSDF> GetBSDF(const SurfaceInteraction &interaction) const = 0;
 
+        // Creates the BSDFs of a group of interactions with this material. Materials override it to create them
+        // without virtual calls, evaluating their constant textures once
+        virtual void GetBSDFs(SurfaceInteraction *const *const interactions, uint32_t count) const {
+            for (uint32_t i = 0; i < count; i++) {
+                interactions[i]->bsdf = GetBSDF(*interactions[i]);
+            }
+        }
+
         // Evaluate the emission of the material at a given SurfaceInteraction in a given direction
         virtual SSESpectrum Emission(const SurfaceInteraction &, const SSEVector &) const {
             return SSESpectrum(0.f);
@@ -64,6 +73,15 @@ namespace pixel {
 
         // Material type
         const MATERIAL_TYPE type;
+        // Identifier of the material, given in order of creation from 1 on
+        const uint32_t id;
+
+    private:
+        static uint32_t NextID() {
+            static std::atomic<uint32_t> next_id(1);
+
+            return next_id++;
+        }
     };
 
 }
@@ -0,0 +1,364 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2016 simon.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "mipmap.h"
+#include "image_io.h"
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <unordered_map>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace pixel {
+
+    // Identifies tiled texture files, the version must be increased whenever the layout changes
+    static const char TILED_TEXTURE_MAGIC[8] = {'P', 'I', 'X', 'E', 'L', 'T', 'E', 'X'};
+    static const uint32_t TILED_TEXTURE_VERSION = 1;
+    static const uint32_t TEXTURE_TILE_SIZE = 32;
+
+    // Header at the beginning of a tiled file. It is followed by the tiles of each level from the finest one,
+    // in rows from the bottom. Each tile holds tile_size x tile_size RGB float texels, the ones past the
+    // border of the level repeat the last row and column
+    struct TiledTextureHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t width, height;
+        uint32_t n_levels;
+        uint32_t tile_size;
+        uint32_t pad;
+        // Modification time of the source image
+        int64_t source_time;
+    };
+
+    // Ratio of the footprint axes above which the minor one is widened
+    static const float MAX_ANISOTROPY = 8.f;
+
+    // Modification time of a file, -1 if it does not exist
+    static int64_t FileTime(const std::string &file_name) {
+        struct stat file_stat;
+        if (stat(file_name.c_str(), &file_stat) != 0) { return -1; }
+
+        return static_cast<int64_t>(file_stat.st_mtime);
+    }
+
+    // Halve one axis of an RGB image with a box filter. Odd sizes are handled by weighting the source texels by
+    // how much of them each destination texel covers, so that the average of the image is preserved
+    static std::vector<float> Downsample(const std::vector<float> &texels, uint32_t width, uint32_t height,
+                                         bool horizontal) {
+        const uint32_t size = horizontal ? width : height;
+        const uint32_t half = std::max(1u, size / 2);
+        const uint32_t w = horizontal ? half : width;
+        const uint32_t h = horizontal ? height : half;
+        const float ratio = static_cast<float>(size) / half;
+        std::vector<float> result(3 * w * h, 0.f);
+        for (uint32_t i = 0; i < half; i++) {
+            // Source interval covered by the destination texel
+            const float begin = i * ratio, end = (i + 1) * ratio;
+            for (uint32_t s = static_cast<uint32_t>(begin); s < size && s < end; s++) {
+                const float weight = (std::min(end, s + 1.f) - std::max(begin, static_cast<float>(s))) / ratio;
+                const uint32_t n = horizontal ? height : width;
+                for (uint32_t j = 0; j < n; j++) {
+                    const uint32_t src = horizontal ? j * width + s : s * width + j;
+                    const uint32_t dst = horizontal ? j * w + i : i * w + j;
+                    for (uint32_t c = 0; c < 3; c++) {
+                        result[3 * dst + c] += weight * texels[3 * src + c];
+                    }
+                }
+            }
+        }
+
+        return result;
+    }
+
+    // Convert an image to a tiled file, returns false if it cannot be read or written
+    static bool BuildTiledFile(const std::string &source, const std::string &tiled_file, int64_t source_time) {
+        uint32_t width, height;
+        std::vector<SSESpectrum> pixels;
+        if (!ReadPFM(source, &width, &height, &pixels)) { return false; }
+
+        // Store rows from the bottom so that v grows upwards
+        std::vector<float> texels(3 * width * height);
+        for (uint32_t y = 0; y < height; y++) {
+            for (uint32_t x = 0; x < width; x++) {
+                const SSESpectrum &p = pixels[(height - 1 - y) * width + x];
+                const float rgb[3] = {p.r, p.g, p.b};
+                std::copy(rgb, rgb + 3, &texels[3 * (y * width + x)]);
+            }
+        }
+        pixels.clear();
+
+        TiledTextureHeader header;
+        std::memcpy(header.magic, TILED_TEXTURE_MAGIC, sizeof(TILED_TEXTURE_MAGIC));
+        header.version = TILED_TEXTURE_VERSION;
+        header.width = width;
+        header.height = height;
+        header.n_levels = 1;
+        while ((std::max(width, height) >> header.n_levels) > 0) {
+            header.n_levels++;
+        }
+        header.tile_size = TEXTURE_TILE_SIZE;
+        header.pad = 0;
+        header.source_time = source_time;
+
+        // Write to a temporary file first so that a concurrent render never sees a partial one. Its name is unique
+        // to the process and the conversion, as other processes or threads may convert the same texture
+        static std::atomic<uint32_t> n_conversions(0);
+        const std::string temporary_file = tiled_file + "." + std::to_string(getpid()) + "." +
+                                           std::to_string(n_conversions.fetch_add(1)) + ".tmp";
+        std::ofstream out(temporary_file, std::ios::binary | std::ios::trunc);
+        if (!out) { return false; }
+        out.write(reinterpret_cast<const char *>(&header), sizeof(TiledTextureHeader));
+        const uint32_t t = TEXTURE_TILE_SIZE;
+        std::vector<float> tile(3 * t * t);
+        uint32_t w = width, h = height;
+        for (uint32_t level = 0; level < header.n_levels; level++) {
+            for (uint32_t ty = 0; ty < (h + t - 1) / t; ty++) {
+                for (uint32_t tx = 0; tx < (w + t - 1) / t; tx++) {
+                    for (uint32_t y = 0; y < t; y++) {
+                        for (uint32_t x = 0; x < t; x++) {
+                            const uint32_t sx = std::min(tx * t + x, w - 1);
+                            const uint32_t sy = std::min(ty * t + y, h - 1);
+                            std::copy(&texels[3 * (sy * w + sx)], &texels[3 * (sy * w + sx)] + 3,
+                                      &tile[3 * (y * t + x)]);
+                        }
+                    }
+                    out.write(reinterpret_cast<const char *>(tile.data()), tile.size() * sizeof(float));
+                }
+            }
+            if (level + 1 < header.n_levels) {
+                texels = Downsample(texels, w, h, true);
+                w = std::max(1u, w / 2);
+                texels = Downsample(texels, w, h, false);
+                h = std::max(1u, h / 2);
+            }
+        }
+        out.close();
+        if (!out) {
+            std::remove(temporary_file.c_str());
+            return false;
+        }
+
+        if (std::rename(temporary_file.c_str(), tiled_file.c_str()) != 0) {
+            std::remove(temporary_file.c_str());
+            return false;
+        }
+
+        return true;
+    }
+
+    TiledMIPMap::TiledMIPMap(const std::string &file_name, TextureCache *const cache)
+            : cache(cache), id(cache->NewTextureId()), fd(-1), tile_size(0), tile_shift(0) {
+        // The file can be a tiled one already, otherwise it is converted once
+        if (Open(file_name, -1)) { return; }
+        const int64_t source_time = FileTime(file_name);
+        const std::string tiled_file = file_name + ".tiled";
+        if (!Open(tiled_file, source_time)) {
+            if (!BuildTiledFile(file_name, tiled_file, source_time) || !Open(tiled_file, source_time)) {
+                std::cerr << "Cannot load texture " << file_name << std::endl;
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+
+    TiledMIPMap::~TiledMIPMap() {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+
+    bool TiledMIPMap::Open(const std::string &tiled_file, int64_t source_time) {
+        const int file = open(tiled_file.c_str(), O_RDONLY);
+        if (file < 0) { return false; }
+        TiledTextureHeader header;
+        const bool valid = pread(file, &header, sizeof(TiledTextureHeader), 0) == sizeof(TiledTextureHeader) &&
+                           std::memcmp(header.magic, TILED_TEXTURE_MAGIC, sizeof(TILED_TEXTURE_MAGIC)) == 0 &&
+                           header.version == TILED_TEXTURE_VERSION &&
+                           (source_time < 0 || header.source_time == source_time) &&
+                           (header.tile_size & (header.tile_size - 1)) == 0 && header.tile_size > 0 &&
+                           header.n_levels > 0 && header.n_levels < 32;
+        if (!valid) {
+            close(file);
+            return false;
+        }
+
+        fd = file;
+        tile_size = header.tile_size;
+        while ((1u << tile_shift) < tile_size) {
+            tile_shift++;
+        }
+        uint32_t w = header.width, h = header.height;
+        uint64_t first_tile = 0;
+        levels.resize(header.n_levels);
+        for (Level &level : levels) {
+            level.width = w;
+            level.height = h;
+            level.tiles_x = (w + tile_size - 1) / tile_size;
+            level.tiles_y = (h + tile_size - 1) / tile_size;
+            level.first_tile = first_tile;
+            first_tile += static_cast<uint64_t>(level.tiles_x) * level.tiles_y;
+            w = std::max(1u, w / 2);
+            h = std::max(1u, h / 2);
+        }
+
+        return true;
+    }
+
+    std::shared_ptr<const TextureTile> TiledMIPMap::LoadTile(uint32_t level, uint32_t x, uint32_t y) const {
+        auto tile = std::make_shared<TextureTile>(tile_size * tile_size);
+        const uint64_t index = levels[level].first_tile + static_cast<uint64_t>(y) * levels[level].tiles_x + x;
+        const off_t offset = static_cast<off_t>(sizeof(TiledTextureHeader) + index * tile->bytes);
+        if (pread(fd, tile->texels.get(), tile->bytes, offset) != static_cast<ssize_t>(tile->bytes)) {
+            std::cerr << "Cannot read texture tile" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+
+        return tile;
+    }
+
+    const float *TiledMIPMap::TexelData(uint32_t level, int32_t x, int32_t y, TileCursor *const cursor) const {
+        const Level &l = levels[level];
+        // Repeat the texture, most lookups are already inside
+        if (static_cast<uint32_t>(x) >= l.width) {
+            x %= static_cast<int32_t>(l.width);
+            if (x < 0) { x += l.width; }
+        }
+        if (static_cast<uint32_t>(y) >= l.height) {
+            y %= static_cast<int32_t>(l.height);
+            if (y < 0) { y += l.height; }
+        }
+
+        const uint32_t tx = x >> tile_shift, ty = y >> tile_shift;
+        const uint64_t key = TextureCache::TileKey(id, level, tx, ty);
+        if (cursor->key != key) {
+            std::shared_ptr<const TextureTile> tile = cache->Find(key);
+            if (!tile) {
+                tile = cache->Insert(key, LoadTile(level, tx, ty));
+            }
+            cursor->key = key;
+            cursor->tile = std::move(tile);
+        }
+
+        const uint32_t mask = tile_size - 1;
+
+        return &cursor->tile->texels[3 * (((y & mask) << tile_shift) + (x & mask))];
+    }
+
+    SSESpectrum TiledMIPMap::Texel(uint32_t level, int32_t x, int32_t y) const {
+        TileCursor cursor;
+        const float *const t = TexelData(level, x, y, &cursor);
+
+        return SSESpectrum(t[0], t[1], t[2]);
+    }
+
+    SSESpectrum TiledMIPMap::Bilerp(uint32_t level, float u, float v, TileCursor *const cursor) const {
+        const float x = u * levels[level].width - 0.5f;
+        const float y = v * levels[level].height - 0.5f;
+        const float fx = std::floor(x), fy = std::floor(y);
+        const int32_t x0 = static_cast<int32_t>(fx), y0 = static_cast<int32_t>(fy);
+        const float dx = x - fx, dy = y - fy;
+
+        const float weights[4] = {(1.f - dx) * (1.f - dy), dx * (1.f - dy), (1.f - dx) * dy, dx * dy};
+        float rgb[3] = {0.f, 0.f, 0.f};
+        for (uint32_t i = 0; i < 4; i++) {
+            const float *const t = TexelData(level, x0 + (i & 1), y0 + (i >> 1), cursor);
+            for (uint32_t c = 0; c < 3; c++) {
+                rgb[c] += weights[i] * t[c];
+            }
+        }
+
+        return SSESpectrum(rgb[0], rgb[1], rgb[2]);
+    }
+
+    SSESpectrum TiledMIPMap::Trilinear(float u, float v, float level, TileCursor cursors[2]) const {
+        const uint32_t n_levels = Levels();
+        if (level <= 0.f) {
+            return Bilerp(0, u, v, &cursors[0]);
+        }
+        if (level >= n_levels - 1) {
+            return Bilerp(n_levels - 1, u, v, &cursors[0]);
+        }
+        const uint32_t l = static_cast<uint32_t>(level);
+        const float d = level - l;
+
+        return SSESpectrum((1.f - d) * Bilerp(l, u, v, &cursors[0]) + d * Bilerp(l + 1, u, v, &cursors[1]));
+    }
+
+    SSESpectrum TiledMIPMap::Lookup(float u, float v, float width) const {
+        TileCursor cursors[2];
+        // The coarsest level covers the whole texture with one texel
+        const float level = Levels() - 1 + std::log2(std::max(width, 1e-8f));
+
+        return Trilinear(u, v, level, cursors);
+    }
+
+    SSESpectrum TiledMIPMap::Lookup(float u, float v, float dudx, float dvdx, float dudy, float dvdy) const {
+        // Find the major axis of the footprint
+        float major_u = dudx, major_v = dvdx;
+        float major = std::sqrt(dudx * dudx + dvdx * dvdx);
+        float minor = std::sqrt(dudy * dudy + dvdy * dvdy);
+        if (minor > major) {
+            std::swap(major, minor);
+            major_u = dudy;
+            major_v = dvdy;
+        }
+        if (major == 0.f) {
+            return Lookup(u, v, 0.f);
+        }
+        // Bound the number of probes by widening the minor axis of very thin footprints
+        if (minor * MAX_ANISOTROPY < major) {
+            minor = major / MAX_ANISOTROPY;
+        }
+
+        TileCursor cursors[2];
+        const float level = Levels() - 1 + std::log2(std::max(minor, 1e-8f));
+        const uint32_t n = static_cast<uint32_t>(std::ceil(major / minor));
+        SSESpectrum sum(0.f);
+        for (uint32_t i = 0; i < n; i++) {
+            const float t = (i + 0.5f) / n - 0.5f;
+            sum = sum + Trilinear(u + t * major_u, v + t * major_v, level, cursors);
+        }
+
+        return SSESpectrum(sum / static_cast<float>(n));
+    }
+
+    std::shared_ptr<const TiledMIPMap> OpenMIPMap(const std::string &file_name) {
+        static std::mutex mutex;
+        static std::unordered_map<std::string, std::shared_ptr<const TiledMIPMap>> mipmaps;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto &mipmap = mipmaps[file_name];
+        if (!mipmap) {
+            mipmap = std::make_shared<const TiledMIPMap>(file_name, &GlobalTextureCache());
+        }
+
+        return mipmap;
+    }
+
+}
@@ -0,0 +1,115 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2016 simon.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * File:   mipmap.h
+ * Author: simon
+ *
+ * Created on October 19, 2026, 9:40 PM
+ */
+
+#ifndef PIXEL_MIPMAP_H
+#define PIXEL_MIPMAP_H
+
+#include "pixel.h"
+#include "sse_spectrum.h"
+#include "texture_cache.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace pixel {
+
+    // Image pyramid stored in a tiled file and paged in through a texture cache, so that only the tiles
+    // actually looked up are kept in memory. Images are converted once to a .tiled file written next to them,
+    // which is rebuilt when the source changes. Texture coordinates repeat and v = 0 is the bottom row
+    class TiledMIPMap {
+    public:
+        TiledMIPMap(const std::string &file_name, TextureCache *const cache);
+
+        ~TiledMIPMap();
+
+        uint32_t Levels() const {
+            return static_cast<uint32_t>(levels.size());
+        }
+
+        uint32_t Width(uint32_t level = 0) const {
+            return levels[level].width;
+        }
+
+        uint32_t Height(uint32_t level = 0) const {
+            return levels[level].height;
+        }
+
+        // Texel of a level, coordinates wrap around
+        SSESpectrum Texel(uint32_t level, int32_t x, int32_t y) const;
+
+        // Trilinear lookup of a square footprint of the given width in texture space, bilinear on the finest
+        // level for a zero width
+        SSESpectrum Lookup(float u, float v, float width = 0.f) const;
+
+        // Anisotropic lookup of the footprint spanned by the texture coordinates differentials, averaging
+        // trilinear probes along its major axis
+        SSESpectrum Lookup(float u, float v, float dudx, float dvdx, float dudy, float dvdy) const;
+
+    private:
+        struct Level {
+            uint32_t width, height;
+            uint32_t tiles_x, tiles_y;
+            // Index in the file of the first tile of the level
+            uint64_t first_tile;
+        };
+
+        // Tile used by the last texel of a lookup, neighbor texels mostly fall in the same one
+        struct TileCursor {
+            uint64_t key = ~0ULL;
+            std::shared_ptr<const TextureTile> tile;
+        };
+
+        const float *TexelData(uint32_t level, int32_t x, int32_t y, TileCursor *const cursor) const;
+
+        std::shared_ptr<const TextureTile> LoadTile(uint32_t level, uint32_t x, uint32_t y) const;
+
+        SSESpectrum Bilerp(uint32_t level, float u, float v, TileCursor *const cursor) const;
+
+        // Blend the two levels around a fractional one, each level keeps its own cursor
+        SSESpectrum Trilinear(float u, float v, float level, TileCursor cursors[2]) const;
+
+        bool Open(const std::string &tiled_file, int64_t source_time);
+
+        TextureCache *const cache;
+        const uint32_t id;
+        // Descriptor of the tiled file, tiles are read concurrently with pread
+        int fd;
+        // Tiles are square with a power of two size
+        uint32_t tile_size, tile_shift;
+        std::vector<Level> levels;
+    };
+
+    // Open an image as a mipmap in the global texture cache, textures using the same file share it
+    std::shared_ptr<const TiledMIPMap> OpenMIPMap(const std::string &file_name);
+
+}
+
+#endif //PIXEL_MIPMAP_H
@@ -22,7 +22,99 @@
  * THE SOFTWARE.
  */
 
+#include "montecarlo.h"
+#include <algorithm>
+#include <atomic>
+
 namespace pixel {
 
+    RandomGenerator &ThreadRandomGenerator() {
+        static std::atomic<uint32_t> n_threads(0);
+        thread_local RandomGenerator generator(n_threads.fetch_add(1, std::memory_order_relaxed) + 1);
+
+        return generator;
+    }
+
+    Distribution1D::Distribution1D(const float *const f, uint32_t n)
+            : func(f, f + n), cdf(n + 1) {
+        // Integrate the step function
+        cdf[0] = 0.f;
+        for (uint32_t i = 1; i <= n; i++) {
+            cdf[i] = cdf[i - 1] + func[i - 1] / n;
+        }
+        func_int = cdf[n];
+        // Normalize the CDF
+        for (uint32_t i = 1; i <= n; i++) {
+            cdf[i] = (func_int == 0.f) ? static_cast<float>(i) / n : cdf[i] / func_int;
+        }
+    }
+
+    float Distribution1D::SampleContinuous(float u, float *const pdf, uint32_t *const offset) const {
+        // Find the last CDF entry not above u
+        const uint32_t i = static_cast<uint32_t>(std::upper_bound(cdf.begin(), cdf.end(), u) - cdf.begin());
+        const uint32_t segment = Clamp(i, 1u, Count()) - 1;
+        if (offset != nullptr) {
+            *offset = segment;
+        }
+        *pdf = Pdf(segment);
+        // Position inside the segment
+        float du = u - cdf[segment];
+        const float width = cdf[segment + 1] - cdf[segment];
+        if (width > 0.f) {
+            du /= width;
+        }
+
+        return FMin((segment + du) / Count(), 0.99999994f);
+    }
+
+    float Distribution1D::Pdf(uint32_t i) const {
+        return (func_int == 0.f) ? 1.f : func[i] / func_int;
+    }
+
+    uint32_t Distribution1D::Count() const {
+        return static_cast<uint32_t>(func.size());
+    }
+
+    float Distribution1D::Integral() const {
+        return func_int;
+    }
+
+    // Integral of each row of f
+    static std::vector<float> RowIntegrals(const float *const f, uint32_t nu, uint32_t nv) {
+        std::vector<float> integrals(nv, 0.f);
+        for (uint32_t v = 0; v < nv; v++) {
+            for (uint32_t u = 0; u < nu; u++) {
+                integrals[v] += f[v * nu + u] / nu;
+            }
+        }
+
+        return integrals;
+    }
+
+    Distribution2D::Distribution2D(const float *const f, uint32_t nu, uint32_t nv)
+            : marginal(RowIntegrals(f, nu, nv).data(), nv) {
+        conditional.reserve(nv);
+        for (uint32_t v = 0; v < nv; v++) {
+            conditional.emplace_back(f + v * nu, nu);
+        }
+    }
+
+    void Distribution2D::SampleContinuous(float u1, float u2, float *const u, float *const v,
+                                          float *const pdf) const {
+        float pdf_u, pdf_v;
+        uint32_t row;
+        *v = marginal.SampleContinuous(u2, &pdf_v, &row);
+        *u = conditional[row].SampleContinuous(u1, &pdf_u);
+        *pdf = pdf_u * pdf_v;
+    }
+
+    float Distribution2D::Pdf(float u, float v) const {
+        const uint32_t nu = conditional[0].Count();
+        const uint32_t nv = marginal.Count();
+        const uint32_t iu = Clamp(static_cast<uint32_t>(u * nu), 0u, nu - 1);
+        const uint32_t iv = Clamp(static_cast<uint32_t>(v * nv), 0u, nv - 1);
+
+        return conditional[iv].Pdf(iu) * marginal.Pdf(iv);
+    }
 
 }
\ No newline at end of file
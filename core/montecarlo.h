@@ -34,6 +34,8 @@
 
 #include "pixel.h"
 #include "sse_vector.h"
+#include <random>
+#include <vector>
 
 namespace pixel {
 
@@ -41,8 +43,10 @@ namespace pixel {
     inline SSEVector CosineSampleHemisphere(float u1, float u2) {
         // Sample phi
         float phi = u2 * TWO_PI;
-        float x = std::cos(phi) * std::sqrt(u1);
-        float z = std::sin(phi) * std::sqrt(u1);
+        float sin_phi, cos_phi;
+        SinCos(phi, &sin_phi, &cos_phi);
+        float x = cos_phi * std::sqrt(u1);
+        float z = sin_phi * std::sqrt(u1);
         float y = std::sqrt(1.f - u1);
 
         return SSEVector(x, y, z, 0.f);
@@ -58,8 +62,10 @@ namespace pixel {
         float y = u1;
         float r = std::sqrt(FMax(0.f, 1.f - y * y));
         float phi = TWO_PI * u2;
+        float sin_phi, cos_phi;
+        SinCos(phi, &sin_phi, &cos_phi);
 
-        return SSEVector(r * std::cos(phi), y, r * std::sin(phi), 0.f);
+        return SSEVector(r * cos_phi, y, r * sin_phi, 0.f);
     }
 
     // Uniform hemisphere pdf
@@ -72,8 +78,10 @@ namespace pixel {
         float y = 1.f - 2.f * u1;
         float r = std::sqrt(FMax(0.f, 1.f - y * y));
         float phi = TWO_PI * u2;
+        float sin_phi, cos_phi;
+        SinCos(phi, &sin_phi, &cos_phi);
 
-        return SSEVector(r * std::cos(phi), y, r * std::sin(phi), 0.f);
+        return SSEVector(r * cos_phi, y, r * sin_phi, 0.f);
     }
 
     // Uniform sphere pdf
@@ -96,6 +104,73 @@ namespace pixel {
         return (1.f / (TWO_PI * (1.f - cos_theta_max)));
     }
 
+    // Power heuristic weight of a strategy with pdf f against one with pdf g, one sample each
+    inline float PowerHeuristic(float f_pdf, float g_pdf) {
+        const float f2 = f_pdf * f_pdf;
+        const float g2 = g_pdf * g_pdf;
+
+        return (f2 + g2 > 0.f) ? f2 / (f2 + g2) : 0.f;
+    }
+
+    // Define RandomGenerator class, uniform random numbers in [0, 1)
+    class RandomGenerator {
+    public:
+        explicit RandomGenerator(uint32_t seed) : engine(seed), distribution(0.f, 1.f) {}
+
+        float operator()() { return distribution(engine); }
+
+    private:
+        std::default_random_engine engine;
+        std::uniform_real_distribution<float> distribution;
+    };
+
+    // Generator owned by the calling thread, each thread draws its own sequence
+    RandomGenerator &ThreadRandomGenerator();
+
+    // Define Distribution1D class, piecewise constant distribution over [0, 1] sampled by inverting its CDF
+    class Distribution1D {
+    public:
+        // Constructor, a function that is zero everywhere is sampled uniformly
+        Distribution1D(const float *const f, uint32_t n);
+
+        // Sample a value in [0, 1), the segment it falls in is returned in offset. O(log n)
+        float SampleContinuous(float u, float *const pdf, uint32_t *const offset = nullptr) const;
+
+        // Pdf of sampling a value in the i-th segment
+        float Pdf(uint32_t i) const;
+
+        // Number of segments
+        uint32_t Count() const;
+
+        // Integral of the function over [0, 1]
+        float Integral() const;
+
+    private:
+        // Function values and CDF, which has one more entry
+        std::vector<float> func, cdf;
+        // Function integral
+        float func_int;
+    };
+
+    // Define Distribution2D class, piecewise constant distribution over [0, 1]^2. Samples v from the
+    // marginal distribution of the rows and then u from the conditional one of the row
+    class Distribution2D {
+    public:
+        // Constructor, f holds nv rows of nu values
+        Distribution2D(const float *const f, uint32_t nu, uint32_t nv);
+
+        // Sample a point, its pdf with respect to the area of [0, 1]^2 is returned in pdf
+        void SampleContinuous(float u1, float u2, float *const u, float *const v, float *const pdf) const;
+
+        // Pdf of sampling a given point
+        float Pdf(float u, float v) const;
+
+    private:
+        // Distributions of each row and of the rows
+        std::vector<Distribution1D> conditional;
+        Distribution1D marginal;
+    };
+
 }
 
 #endif /* MONTECARLO_H */
@@ -0,0 +1,68 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2016 simon.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "parallel.h"
+#include <thread>
+#include <atomic>
+
+namespace pixel {
+
+    uint32_t NumSystemCores() {
+        uint32_t cores = std::thread::hardware_concurrency();
+
+        return (cores == 0) ? 1 : cores;
+    }
+
+    void ParallelFor(uint32_t count, const std::function<void(uint32_t, uint32_t)> &func, uint32_t chunk_size) {
+        if (count == 0) { return; }
+        chunk_size = FMax(chunk_size, 1u);
+        uint32_t num_chunks = (count + chunk_size - 1) / chunk_size;
+        uint32_t num_threads = FMin(NumSystemCores(), num_chunks);
+        // Avoid spawning threads for small ranges
+        if (num_threads == 1) {
+            func(0, count);
+            return;
+        }
+        // Each worker keeps fetching the next chunk until the range is exhausted
+        std::atomic<uint32_t> next_chunk(0);
+        auto worker = [&]() {
+            uint32_t chunk;
+            while ((chunk = next_chunk.fetch_add(1)) < num_chunks) {
+                uint32_t begin = chunk * chunk_size;
+                func(begin, FMin(begin + chunk_size, count));
+            }
+        };
+        std::vector<std::thread> threads;
+        threads.reserve(num_threads - 1);
+        for (uint32_t t = 0; t < num_threads - 1; t++) {
+            threads.emplace_back(worker);
+        }
+        // The calling thread works as well
+        worker();
+        for (auto &thread : threads) {
+            thread.join();
+        }
+    }
+
+}
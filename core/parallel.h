@@ -0,0 +1,50 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2016 simon.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * File:   parallel.h
+ * Author: simon
+ *
+ * Created on October 19, 2026, 10:05 AM
+ */
+
+#ifndef PIXEL_PARALLEL_H
+#define PIXEL_PARALLEL_H
+
+#include "pixel.h"
+#include <functional>
+
+namespace pixel {
+
+    // Number of hardware threads available
+    uint32_t NumSystemCores();
+
+    // Split the range [0, count) in chunks and process them over all the available cores.
+    // The function is called with the [begin, end) range of each chunk and blocks until all of them are done
+    void ParallelFor(uint32_t count, const std::function<void(uint32_t, uint32_t)> &func,
+                     uint32_t chunk_size = 1024);
+
+}
+
+#endif //PIXEL_PARALLEL_H
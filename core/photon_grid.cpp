@@ -0,0 +1,69 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2016 simon.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "photon_grid.h"
+
+namespace pixel {
+
+    PhotonGrid::PhotonGrid()
+            : radius(0.f), inv_cell_width(0.f), mask(0) {
+    }
+
+    void PhotonGrid::Build(std::vector<Photon> *const in, float r) {
+        radius = r;
+        inv_cell_width = 0.5f / r;
+        const uint32_t n = static_cast<uint32_t>(in->size());
+        // About one bucket per photon
+        uint32_t n_buckets = 1;
+        while (n_buckets < n) {
+            n_buckets <<= 1;
+        }
+        mask = n_buckets - 1;
+        // Count the photons of each bucket
+        std::vector<uint32_t> buckets(n);
+        bucket_start.assign(n_buckets + 1, 0);
+        for (uint32_t i = 0; i < n; i++) {
+            const SSEVector &p = (*in)[i].p;
+            buckets[i] = Bucket(static_cast<int32_t>(std::floor(p.x * inv_cell_width)),
+                                static_cast<int32_t>(std::floor(p.y * inv_cell_width)),
+                                static_cast<int32_t>(std::floor(p.z * inv_cell_width)));
+            bucket_start[buckets[i] + 1]++;
+        }
+        for (uint32_t b = 0; b < n_buckets; b++) {
+            bucket_start[b + 1] += bucket_start[b];
+        }
+        // Scatter them in bucket order
+        photons.resize(n);
+        std::vector<uint32_t> offset(bucket_start.begin(), bucket_start.end() - 1);
+        for (uint32_t i = 0; i < n; i++) {
+            photons[offset[buckets[i]]++] = (*in)[i];
+        }
+        in->clear();
+    }
+
+    uint32_t PhotonGrid::Size() const {
+        return static_cast<uint32_t>(photons.size());
+    }
+
+}
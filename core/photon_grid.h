@@ -0,0 +1,124 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2016 simon.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * File:   photon_grid.h
+ * Author: simon
+ *
+ * Created on October 20, 2026, 12:40 AM
+ */
+
+
+#ifndef PIXEL_PHOTON_GRID_H
+#define PIXEL_PHOTON_GRID_H
+
+#include "pixel.h"
+#include "sse_vector.h"
+#include "sse_spectrum.h"
+
+#include <algorithm>
+
+namespace pixel {
+
+    // Photon left on a surface
+    struct Photon {
+        // Position and direction it arrived from
+        SSEVector p, wi;
+        // Flux carried
+        SSESpectrum beta;
+    };
+
+    // Define PhotonGrid class, a spatial hash grid over photons. Cells are twice the lookup radius wide so a
+    // lookup visits at most eight of them, and the photons are sorted by hash bucket so that each bucket is
+    // read contiguously
+    class PhotonGrid {
+    public:
+        // Constructor
+        PhotonGrid();
+
+        // Build the grid for lookups of the given radius, the photons are moved into the grid
+        void Build(std::vector<Photon> *const photons, float radius);
+
+        // Call func with every photon within the lookup radius of p
+        template<typename F>
+        void Lookup(const SSEVector &p, F &&func) const;
+
+        // Number of photons in the grid
+        uint32_t Size() const;
+
+    private:
+        // Bucket of a cell
+        uint32_t Bucket(int32_t x, int32_t y, int32_t z) const;
+
+        // Photons sorted by bucket, and the start of each bucket with one past the last
+        std::vector<Photon> photons;
+        std::vector<uint32_t> bucket_start;
+        // Lookup radius and inverse of the cell width
+        float radius, inv_cell_width;
+        // Number of buckets minus one, a power of two minus one
+        uint32_t mask;
+    };
+
+    inline uint32_t PhotonGrid::Bucket(int32_t x, int32_t y, int32_t z) const {
+        return ((static_cast<uint32_t>(x) * 73856093u) ^ (static_cast<uint32_t>(y) * 19349663u) ^
+                (static_cast<uint32_t>(z) * 83492791u)) & mask;
+    }
+
+    template<typename F>
+    void PhotonGrid::Lookup(const SSEVector &p, F &&func) const {
+        if (photons.empty()) {
+            return;
+        }
+        // Cells overlapped by the lookup sphere, at most two along each axis
+        const int32_t x0 = static_cast<int32_t>(std::floor((p.x - radius) * inv_cell_width));
+        const int32_t y0 = static_cast<int32_t>(std::floor((p.y - radius) * inv_cell_width));
+        const int32_t z0 = static_cast<int32_t>(std::floor((p.z - radius) * inv_cell_width));
+        const int32_t x1 = static_cast<int32_t>(std::floor((p.x + radius) * inv_cell_width));
+        const int32_t y1 = static_cast<int32_t>(std::floor((p.y + radius) * inv_cell_width));
+        const int32_t z1 = static_cast<int32_t>(std::floor((p.z + radius) * inv_cell_width));
+        // Cells hashed to the same bucket are only visited once
+        uint32_t visited[8];
+        uint32_t n_visited = 0;
+        const float radius_2 = radius * radius;
+        for (int32_t z = z0; z <= z1; z++) {
+            for (int32_t y = y0; y <= y1; y++) {
+                for (int32_t x = x0; x <= x1; x++) {
+                    const uint32_t bucket = Bucket(x, y, z);
+                    if (std::find(visited, visited + n_visited, bucket) != visited + n_visited) {
+                        continue;
+                    }
+                    visited[n_visited++] = bucket;
+                    for (uint32_t i = bucket_start[bucket]; i < bucket_start[bucket + 1]; i++) {
+                        if (SqrdLength(photons[i].p - p) <= radius_2) {
+                            func(photons[i]);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+}
+
+#endif //PIXEL_PHOTON_GRID_H
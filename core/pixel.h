@@ -51,12 +51,20 @@ namespace pixel {
 
     class Film;
 
+    class FilmPlanes;
+
     class BoxFilterFilm;
 
+    class ImageFilm;
+
+    struct AOVSample;
+
     class ToneMapperInterface;
 
     class ClampToneMapper;
 
+    class Denoiser;
+
     class SSEVector;
 
     class SSEMatrix;
@@ -77,6 +85,14 @@ namespace pixel {
 
     class PrimitiveList;
 
+    class BVHAccelerator;
+
+    class ObjectInstance;
+
+    class SpherePacket;
+
+    class SphereSet;
+
     // class ShapeList;
 
     class IntegratorInterface;
@@ -91,12 +107,28 @@ namespace pixel {
 
     class PathTracerIntegrator;
 
+    class BDPTIntegrator;
+
+    class PPMIntegrator;
+
     class Scene;
 
+    class ShadingBatch;
+
+    class DTree;
+
+    class SDTree;
+
+    class PhotonGrid;
+
+    class IrradianceCache;
+
     class RendererInterface;
 
     class SamplerRenderer;
 
+    class ReSTIRRenderer;
+
     class BBox;
 
     class BRDF;
@@ -107,7 +139,7 @@ namespace pixel {
 
     class SpecularTransmission;
 
-    // class FresnelSpecular;
+    class OrenNayar;
 
     class BSDF;
 
@@ -129,6 +161,14 @@ namespace pixel {
 
     class AreaLight;
 
+    class EnvironmentLight;
+
+    class Distribution1D;
+
+    class Distribution2D;
+
+    class RandomGenerator;
+
     template<typename T>
     class TextureInterface;
 
@@ -141,15 +181,18 @@ namespace pixel {
     template<typename T>
     class GridTexture;
 
-    class TextureMapping2DInterface;
+    template<typename T>
+    class ImageTexture;
 
-    class UVMapping2D;
+    class TiledMIPMap;
 
-    class FresnelInterface;
+    class TextureCache;
 
-    class FresnelDielectric;
+    class TextureMapping2DInterface;
+
+    class UVMapping2D;
 
-    class FresnelIdeal;
+    class Fresnel;
 
     // Declare constant values
     static float EPS = 10e-5f;
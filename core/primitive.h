@@ -43,9 +43,14 @@ namespace pixel {
         virtual ~PrimitiveInterface() = default;
 
         // Check if a ray interacts with the primitive and possibly fill a
-        // surface_interaction class
+        // surface_interaction class. Only the primitive hit and its parametric data are recorded,
+        // the ray maximum is set to the hit distance
         virtual bool Intersect(const Ray &ray, SurfaceInteraction *const interaction) const = 0;
 
+        // Complete the surface_interaction of the closest hit found by Intersect, the ray maximum
+        // is the hit distance. Aggregates never record hits so they do not need it
+        virtual void ComputeSurfaceInteraction(const Ray &, SurfaceInteraction *const) const {}
+
         // Check if a ray interacts with the primitive
         virtual bool IntersectP(const Ray &ray) const = 0;
 
@@ -29,7 +29,14 @@ namespace pixel {
 
     Ray::Ray(const SSEVector &o, const SSEVector &d, float tmin, float tmax, uint32_t depth)
             : o(o), d(d), tmin(tmin), tmax(tmax), depth(depth),
-              inv_d(1.f / d.x, 1.f / d.y, 1.f / d.z, 0.f) {
+              inv_d(1.f / d.x, 1.f / d.y, 1.f / d.z, 0.f), has_differentials(false) {
+    }
+
+    void Ray::ScaleDifferentials(float scale) {
+        differentials.rx_origin = o + (differentials.rx_origin - o) * scale;
+        differentials.ry_origin = o + (differentials.ry_origin - o) * scale;
+        differentials.rx_direction = d + (differentials.rx_direction - d) * scale;
+        differentials.ry_direction = d + (differentials.ry_direction - d) * scale;
     }
 
     void PrintRay(const Ray &r) {
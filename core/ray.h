@@ -37,6 +37,13 @@
 
 namespace pixel {
 
+    // Rays offset by one pixel in x and y on the image plane, they follow the main ray through specular
+    // bounces to estimate the footprint of a sample on the surfaces it hits
+    struct RayDifferential {
+        SSEVector rx_origin, rx_direction;
+        SSEVector ry_origin, ry_direction;
+    };
+
     // Ray class
     class Ray {
     public:
@@ -91,6 +98,23 @@ namespace pixel {
             return depth;
         }
 
+        // Check if the ray carries differentials
+        inline bool HasDifferentials() const {
+            return has_differentials;
+        }
+
+        inline const RayDifferential &Differentials() const {
+            return differentials;
+        }
+
+        inline void SetDifferentials(const RayDifferential &diff) {
+            differentials = diff;
+            has_differentials = true;
+        }
+
+        // Scale the differentials to the spacing of the samples when there are several per pixel
+        void ScaleDifferentials(float scale);
+
         // Find point at a given parameter
         inline SSEVector operator()(float t) const {
             return (o + t * d);
@@ -108,13 +132,16 @@ namespace pixel {
         uint32_t depth;
         // Ray inverse direction
         SSEVector inv_d;
+        // Differentials, if any
+        bool has_differentials;
+        RayDifferential differentials;
     };
 
     // Print ray to std::cout
 
     void PrintRay(const Ray &r);
 
-    // Transform ray for a given matrix
+    // Transform ray for a given matrix, the differentials are dropped as they are only used in world space
     Ray TransformRay(const Ray &ray, const SSEMatrix &mat);
 
 }
@@ -53,39 +53,24 @@ namespace pixel {
         return (r_parl * r_parl + r_perp * r_perp) * 0.5f;
     }
 
-    FresnelInterface::~FresnelInterface() {
+    BSDF::BSDF(const SurfaceInteraction &interaction, float eta)
+            : eta(eta), geometric_normal(interaction.normal), s(interaction.s), t(interaction.t), n_brdfs(0),
+              all_types(BRDF_TYPE(0)) {
     }
 
-    FresnelDielectric::FresnelDielectric(float eta_i, float eta_t)
-            : eta_i(eta_i), eta_t(eta_t) {
-    }
-
-    SSESpectrum FresnelDielectric::Evaluate(float cos_theta_i) const {
-        return SSESpectrum(FrDielectric(cos_theta_i, eta_i, eta_t));
-    }
-
-    SSESpectrum FresnelIdeal::Evaluate(float) const {
-        return SSESpectrum(1.f);
-    }
-
-    BSDF::BSDF(const SurfaceInteraction &interaction)
-            : geometric_normal(interaction.normal), s(interaction.s), t(interaction.t), brdfs() {
-    }
-
-    BSDF::~BSDF() {
-        for (auto brdf : brdfs) {
-            delete brdf;
-        }
-    }
-
-    void BSDF::AddBRDF(const BRDF *brdf) {
-        brdfs.push_back(brdf);
+    void BSDF::AddBRDF(const BRDF &brdf) {
+        assert(n_brdfs < MAX_BRDFS);
+        brdfs[n_brdfs++] = brdf;
+        all_types = BRDF_TYPE(all_types | brdf.type);
     }
 
     uint32_t BSDF::NumMatchingBRDF(BRDF_TYPE types) const {
+        if ((all_types & types) == all_types) {
+            return n_brdfs;
+        }
         uint32_t num = 0;
-        for (auto brdf : brdfs) {
-            if (brdf->MatchesTypes(types)) {
+        for (uint32_t i = 0; i < n_brdfs; i++) {
+            if (brdfs[i].MatchesTypes(types)) {
                 ++num;
             }
         }
@@ -99,12 +84,12 @@ namespace pixel {
         if (wo_local.y == 0.f) {
             return SSESpectrum();
         }
+        // Only the lobes on the side of wi contribute
+        const BRDF_TYPE side = SameHemisphere(wi_local, wo_local) ? BRDF_REFLECTION : BRDF_TRANSMISSION;
         SSESpectrum f;
-        for (auto brdf : brdfs) {
-            if (brdf->MatchesTypes(types) &&
-                ((SameHemisphere(wi_local, wo_local) && (brdf->type & BRDF_REFLECTION)) ||
-                 (!SameHemisphere(wi_local, wo_local) && (brdf->type & BRDF_TRANSMISSION)))) {
-                f += brdf->f(wo_local, wi_local);
+        for (uint32_t i = 0; i < n_brdfs; i++) {
+            if (brdfs[i].MatchesTypes(types) && (brdfs[i].type & side)) {
+                f += brdfs[i].f(wo_local, wi_local);
             }
         }
 
@@ -125,18 +110,15 @@ namespace pixel {
         // Choose component
         uint32_t sampled_comp = FMin(static_cast<uint32_t> (u1 * matching_brdf), matching_brdf - 1);
 
-        // Get pointer to chosen BRDF
-        const BRDF *sampled_brdf = nullptr;
-        uint32_t count = sampled_comp;
-        for (auto brdf : brdfs) {
-            if (brdf->MatchesTypes(types) && count-- == 0) {
-                sampled_brdf = brdf;
+        // Get the chosen BRDF
+        uint32_t sampled = 0;
+        for (uint32_t count = sampled_comp; sampled < n_brdfs; sampled++) {
+            if (brdfs[sampled].MatchesTypes(types) && count-- == 0) {
                 break;
             }
         }
-#ifdef DEBUG
-        assert(sampled_brdf != nullptr);
-#endif
+        assert(sampled < n_brdfs);
+        const BRDF &sampled_brdf = brdfs[sampled];
 
         // Sample the chosen BRDF
         SSEVector wo_local = WorldToLocal(wo_world);
@@ -146,11 +128,9 @@ namespace pixel {
         }
         *pdf = 0.f;
         if (sampled_type) {
-            *sampled_type = sampled_brdf->type;
+            *sampled_type = sampled_brdf.type;
         }
-        // Sample the BRDF
-        if (sampled_type) { *sampled_type = sampled_brdf->type; }
-        SSESpectrum f = sampled_brdf->Sample_f(wo_local, &wi_local, pdf, u1, u2, sampled_type);
+        SSESpectrum f = sampled_brdf.Sample_f(wo_local, &wi_local, pdf, u1, u2);
         if (*pdf == 0.f) {
             if (sampled_type) {
                 *sampled_type = BRDF_TYPE(0);
@@ -158,11 +138,17 @@ namespace pixel {
             return SSESpectrum(0.f);
         }
         *wi_world = LocalToWorld(wi_local);
-        // Compute overall PDF for all matching BRDFs, unless specular
-        if (!(sampled_brdf->type & BRDF_SPECULAR) && matching_brdf > 1) {
-            for (auto brdf : brdfs) {
-                if (brdf != sampled_brdf && brdf->MatchesTypes(types)) {
-                    *pdf += brdf->Pdf(wo_local, wi_local);
+        // Compute overall PDF and value for all matching BRDFs, unless specular
+        if (!(sampled_brdf.type & BRDF_SPECULAR) && matching_brdf > 1) {
+            const BRDF_TYPE side = SameHemisphere(wi_local, wo_local) ? BRDF_REFLECTION : BRDF_TRANSMISSION;
+            f = SSESpectrum(0.f);
+            for (uint32_t i = 0; i < n_brdfs; i++) {
+                if (!brdfs[i].MatchesTypes(types)) { continue; }
+                if (i != sampled) {
+                    *pdf += brdfs[i].Pdf(wo_local, wi_local);
+                }
+                if (brdfs[i].type & side) {
+                    f += brdfs[i].f(wo_local, wi_local);
                 }
             }
         }
@@ -170,23 +156,32 @@ namespace pixel {
             *pdf /= static_cast<float> (matching_brdf);
         }
 
-        // Compute value of BSDF for sampled direction, unless specular
-        if (!(sampled_brdf->type & BRDF_SPECULAR) && matching_brdf > 1) {
-            f = SSESpectrum(0.f);
-            for (auto brdf : brdfs) {
-                if (brdf->MatchesTypes(types) &&
-                    ((SameHemisphere(wi_local, wo_local) && (brdf->type & BRDF_REFLECTION)) ||
-                     (!SameHemisphere(wi_local, wo_local) && (brdf->type & BRDF_TRANSMISSION)))) {
-                    f += brdf->f(wo_local, wi_local);
-                }
+        return f;
+    }
+
+    SSESpectrum BSDF::Rho(const SSEVector &wo_world) const {
+        SSEVector wo_local = WorldToLocal(wo_world);
+        if (wo_local.y == 0.f) {
+            return SSESpectrum(0.f);
+        }
+        // A single sample of each lobe, their distributions follow the cosine up to a constant. Specular lobes
+        // already leave the cosine out of their value, as the integrators do
+        SSESpectrum rho(0.f);
+        for (uint32_t i = 0; i < n_brdfs; i++) {
+            SSEVector wi_local;
+            float pdf = 0.f;
+            const SSESpectrum f = brdfs[i].Sample_f(wo_local, &wi_local, &pdf, 0.5f, 0.5f);
+            if (pdf > 0.f) {
+                const float cos_wi = (brdfs[i].type & BRDF_SPECULAR) ? 1.f : std::abs(wi_local.y);
+                rho += f * (cos_wi / pdf);
             }
         }
 
-        return f;
+        return rho;
     }
 
     float BSDF::Pdf(const SSEVector &wo_world, const SSEVector &wi_world, BRDF_TYPE types) const {
-        if (brdfs.size() == 0) {
+        if (n_brdfs == 0) {
             return 0.f;
         }
         SSEVector wo_local = WorldToLocal(wo_world);
@@ -196,95 +191,18 @@ namespace pixel {
         }
         float pdf = 0.f;
         uint32_t matching_brdf = 0;
-        for (auto brdf : brdfs) {
-            if (brdf->MatchesTypes(types)) {
+        for (uint32_t i = 0; i < n_brdfs; i++) {
+            if (brdfs[i].MatchesTypes(types)) {
                 matching_brdf++;
-                pdf += brdf->Pdf(wo_local, wi_local);
+                pdf += brdfs[i].Pdf(wo_local, wi_local);
             }
         }
 
         return matching_brdf > 0 ? (pdf / static_cast<float> (matching_brdf)) : 0.f;
     }
 
-    BRDF::BRDF(const BRDF_TYPE type)
-            : type(type) {
-    }
-
-    BRDF::~BRDF() {
-    }
-
-    bool BRDF::MatchesTypes(BRDF_TYPE types) const {
-        if (type <= types) {
-            return ((type & types) == type);
-        } else {
-            return ((type & types) == types);
-        }
-    }
-
-    SSESpectrum BRDF::Sample_f(const SSEVector &wo, SSEVector *const wi, float *const pdf,
-                               float u1, float u2, BRDF_TYPE *const) const {
-        // Cosine sample the hemisphere
-        *wi = CosineSampleHemisphere(u1, u2);
-        if (wo.y < 0.f) {
-            wi->y *= -1.f;
-        }
-        *pdf = Pdf(wo, *wi);
-
-        return f(wo, *wi);
-    }
-
-    float BRDF::Pdf(const SSEVector &wo, const SSEVector &wi) const {
-        return SameHemisphere(wo, wi) ? AbsCosTheta(wi) * ONE_OVER_PI : 0.f;
-    }
-
-    LambertianReflection::LambertianReflection(const SSESpectrum &r)
-            : BRDF(BRDF_TYPE(BRDF_REFLECTION | BRDF_DIFFUSE)), rho(r) {
-    }
-
-    SSESpectrum LambertianReflection::f(const SSEVector &, const SSEVector &) const {
-        return SSESpectrum(rho * ONE_OVER_PI);
-    }
-
-    SpecularReflection::SpecularReflection(const SSESpectrum &R, FresnelInterface *const f)
-            : BRDF(BRDF_TYPE(BRDF_REFLECTION | BRDF_SPECULAR)), R(R), fresnel(f) {
-    }
-
-    SpecularReflection::~SpecularReflection() {
-        delete fresnel;
-    }
-
-    SSESpectrum SpecularReflection::f(const SSEVector &, const SSEVector &) const {
-        return SSESpectrum(0.f);
-    }
-
-    SSESpectrum SpecularReflection::Sample_f(const SSEVector &wo, SSEVector *const wi,
-                                             float *const pdf, float, float,
-                                             BRDF_TYPE *const) const {
-        // Compute perfect specular direction
-        *wi = SSEVector(-wo.x, wo.y, -wo.z, 0.f);
-        *pdf = 1.f;
-
-        // Note that there is not division by cosine term!
-        return SSESpectrum(fresnel->Evaluate(CosTheta(*wi)) * R);
-    }
-
-    float SpecularReflection::Pdf(const SSEVector &, const SSEVector &) const {
-        return 0.f;
-    }
-
-    SpecularTransmission::SpecularTransmission(const SSESpectrum &T, float eta_a, float eta_b)
-            : BRDF(BRDF_TYPE(BRDF_TRANSMISSION | BRDF_SPECULAR)),
-              T(T), eta_a(eta_a), eta_b(eta_b),
-              fresnel(eta_a, eta_b) {
-    }
-
-    SSESpectrum SpecularTransmission::f(const SSEVector &, const SSEVector &) const {
-        return SSESpectrum(0.f);
-    }
-
-    SSESpectrum SpecularTransmission::Sample_f(const SSEVector &wo, SSEVector *const wi,
-                                               float *const pdf, float, float,
-                                               BRDF_TYPE *const) const {
+    SSESpectrum SpecularTransmission::Sample_f(const SSEVector &wo, SSEVector *const wi, float *const pdf,
+                                               float, float) const {
         // Find out if we are entering or exiting
         bool entering = CosTheta(wo) > 0.f;
         float eta_i = entering ? eta_a : eta_b;
@@ -302,12 +220,8 @@ namespace pixel {
                 (eta_i * eta_i) / (eta_t * eta_t) * T * (SSESpectrum(1.f) - fresnel.Evaluate(CosTheta(*wi))));
     }
 
-    float SpecularTransmission::Pdf(const SSEVector &, const SSEVector &) const {
-        return 0.f;
-    }
-
     OrenNayar::OrenNayar(const SSESpectrum &r, float sigma)
-    : BRDF(BRDF_TYPE(BRDF_REFLECTION | BRDF_DIFFUSE)), rho(r) {
+            : rho(r) {
         sigma = DegToRad(sigma);
         float sigma_2 = sigma * sigma;
         A = 1.f - (sigma_2 / (2.f * (sigma_2 + 0.33f)));
@@ -338,67 +252,4 @@ namespace pixel {
         return SSESpectrum(rho * ONE_OVER_PI * (A + B * max_cos * sin_alpha * tan_beta));
     }
 
-//    FresnelSpecular::FresnelSpecular(const SSESpectrum &R, const SSESpectrum &T, float eta_a, float eta_b)
-//            : BRDF(BRDF_TYPE(BRDF_REFLECTION | BRDF_TRANSMISSION | BRDF_SPECULAR)),
-//              R(R), T(T),
-//              eta_a(eta_a), eta_b(eta_b),
-//              fresnel(eta_a, eta_b) {
-//    }
-//
-//    SSESpectrum FresnelSpecular::f(const SSEVector &, const SSEVector &) const {
-//        return SSESpectrum(0.f);
-//    }
-//
-//    SSESpectrum FresnelSpecular::Sample_f(const SSEVector &wo, SSEVector *const wi,
-//                                          float *const pdf, float u1, float,
-//                                          BRDF_TYPE *const sampled_type) const {
-//        // Find out if we are entering or exiting
-//        bool entering = CosTheta(wo) > 0.f;
-//        float eta_i = entering ? eta_a : eta_b;
-//        float eta_t = entering ? eta_b : eta_a;
-//        // Find normal
-//        SSEVector normal = entering ? SSEVector(0.f, 1.f, 0.f, 0.f) : SSEVector(0.f, -1.f, 0.f, 0.f);
-//
-//        // Check for refraction
-//        if (!Refract(wo, normal, eta_i / eta_t, wi)) {
-//            // Reflect ray
-//            *wi = SSEVector(-wo.x, wo.y, -wo.z, 0.f);
-//            *pdf = 1.f;
-//            if (sampled_type) {
-//                *sampled_type = BRDF_TYPE(BRDF_SPECULAR | BRDF_REFLECTION);
-//            }
-//
-//            return R;
-//        }
-//
-//        // Evaluate Fresnel term
-//        float F = FrDielectric(CosTheta(wo), eta_i, eta_t);
-//        if (u1 < F) {
-//            // Compute perfect specular direction
-//            *wi = SSEVector(-wo.x, wo.y, -wo.z, 0.f);
-//            *pdf = F;
-//            if (sampled_type) {
-//                *sampled_type = BRDF_TYPE(BRDF_SPECULAR | BRDF_REFLECTION);
-//            }
-//
-//            return (F * R);
-//        } else {
-//            // Find normal
-////            SSEVector normal = entering ? SSEVector(0.f, 1.f, 0.f, 0.f) : SSEVector(0.f, -1.f, 0.f, 0.f);
-//            // Check if we have total internal refraction
-//            if (!Refract(wo, normal, eta_i / eta_t, wi)) {
-//                return SSESpectrum(0.f);
-//            }
-//            *pdf = 1.f - F;
-//            if (sampled_type) {
-//                *sampled_type = BRDF_TYPE(BRDF_SPECULAR | BRDF_TRANSMISSION);
-//            }
-//
-//            return (eta_i * eta_i) / (eta_t * eta_t) * T * (SSESpectrum(1.f) - fresnel.Evaluate(CosTheta(*wi)));
-//        }
-//    }
-//
-//    float FresnelSpecular::Pdf(const SSEVector &, const SSEVector &) const {
-//        return 0.f;
-//    }
 }
@@ -35,6 +35,7 @@
 #include "pixel.h"
 #include "sse_vector.h"
 #include "sse_spectrum.h"
+#include "montecarlo.h"
 
 namespace pixel {
 
@@ -105,34 +106,27 @@ namespace pixel {
     // Evaluate Fresnel term for dielectric material
     float FrDielectric(float cos_theta_i, float eta_i, float eta_t);
 
-    // Define Fresnel interface
-    class FresnelInterface {
+    // Fresnel term of a specular lobe, either a dielectric interface or an ideal mirror reflecting everything
+    class Fresnel {
     public:
-        // Destructor
-        virtual ~FresnelInterface();
+        // Ideal mirror
+        Fresnel()
+                : dielectric(false), eta_i(1.f), eta_t(1.f) {}
 
-        // Evaluate Fresnel term
-        virtual SSESpectrum Evaluate(float cos_theta_i) const = 0;
-    };
+        // Dielectric interface
+        Fresnel(float eta_i, float eta_t)
+                : dielectric(true), eta_i(eta_i), eta_t(eta_t) {}
 
-    // Dielectric Fresnel class
-    class FresnelDielectric : public FresnelInterface {
-    public:
-        // Constructor
-        FresnelDielectric(float eta_i, float eta_t);
-
-        SSESpectrum Evaluate(float cos_theta_i) const;
+        // Evaluate Fresnel term
+        SSESpectrum Evaluate(float cos_theta_i) const {
+            return SSESpectrum(dielectric ? FrDielectric(cos_theta_i, eta_i, eta_t) : 1.f);
+        }
 
     private:
+        bool dielectric;
         float eta_i, eta_t;
     };
 
-    // Ideal Fresnel class
-    class FresnelIdeal : public FresnelInterface {
-    public:
-        SSESpectrum Evaluate(float cos_theta_i) const;
-    };
-
     // Define different type of BRDF
     enum BRDF_TYPE {
         // One of these two
@@ -145,171 +139,306 @@ namespace pixel {
         ALL_BRDF = BRDF_REFLECTION | BRDF_TRANSMISSION | BRDF_DIFFUSE | BRDF_GLOSSY | BRDF_SPECULAR
     };
 
-    // Define BSDF class, which represents a combination of multiple BRDFs
-    class BSDF {
-    public:
-        // Constructor
-        BSDF(const SurfaceInteraction &interaction);
+    // Check if a BRDF type matches the given types
+    inline bool MatchesTypes(BRDF_TYPE type, BRDF_TYPE types) {
+        if (type <= types) {
+            return ((type & types) == type);
+        } else {
+            return ((type & types) == types);
+        }
+    }
 
-        // Destructor
-        ~BSDF();
+    // The lobes are closed types without virtual functions, the BRDF below dispatches between them with a
+    // switch so that the compiler can inline their evaluation
 
-        // Add BRDF
-        void AddBRDF(const BRDF *brdf);
+    // Cosine sample the hemisphere of wo, used by the diffuse lobes
+    inline SSEVector CosineSampleLobe(const SSEVector &wo, float u1, float u2) {
+        SSEVector wi = CosineSampleHemisphere(u1, u2);
+        if (wo.y < 0.f) {
+            wi.y *= -1.f;
+        }
 
-        // Number of matching BRDF
-        uint32_t NumMatchingBRDF(BRDF_TYPE types = ALL_BRDF) const;
+        return wi;
+    }
 
-        // Evaluate BSDF
-        SSESpectrum f(const SSEVector &wo_world, const SSEVector &wi_world, BRDF_TYPE types = ALL_BRDF) const;
+    inline float CosineLobePdf(const SSEVector &wo, const SSEVector &wi) {
+        return SameHemisphere(wo, wi) ? AbsCosTheta(wi) * ONE_OVER_PI : 0.f;
+    }
 
-        // Sample BRDF
-        SSESpectrum Sample_f(const SSEVector &wo_world, SSEVector *const wi_world, float *const pdf,
-                             float u1, float u2,
-                             BRDF_TYPE types = ALL_BRDF,
-                             BRDF_TYPE *const sampled_type = nullptr) const;
+    // Lambertian BRDF
+    class LambertianReflection {
+    public:
+        static const BRDF_TYPE TYPE = BRDF_TYPE(BRDF_REFLECTION | BRDF_DIFFUSE);
 
-        // BSDF pdf
-        float Pdf(const SSEVector &wo_world, const SSEVector &wi_world, BRDF_TYPE types = ALL_BRDF) const;
+        LambertianReflection(const SSESpectrum &r)
+                : rho(r) {}
 
-    private:
-        // Transform vector to local space
-        SSEVector WorldToLocal(const SSEVector &v) const {
-            return SSEVector(DotProduct(v, s), DotProduct(v, geometric_normal), DotProduct(v, t), v.w);
+        SSESpectrum f(const SSEVector &, const SSEVector &) const {
+            return SSESpectrum(rho * ONE_OVER_PI);
         }
 
-        SSEVector LocalToWorld(const SSEVector &v) const {
-            return (v.x * s + v.y * geometric_normal + v.z * t);
+        SSESpectrum Sample_f(const SSEVector &wo, SSEVector *const wi, float *const pdf, float u1, float u2) const {
+            *wi = CosineSampleLobe(wo, u1, u2);
+            *pdf = Pdf(wo, *wi);
+
+            return f(wo, *wi);
         }
 
-        // Local base
-        const SSEVector geometric_normal;
-        const SSEVector s, t;
-        // Added BRDFs
-        std::vector<const BRDF *> brdfs;
-    };
+        float Pdf(const SSEVector &wo, const SSEVector &wi) const {
+            return CosineLobePdf(wo, wi);
+        }
 
-    // Define base BRDF class
+    private:
+        // Reflectance
+        SSESpectrum rho;
+    };
 
-    class BRDF {
+    // Define Oren-Nayar class
+    class OrenNayar {
     public:
-        // Constructor
-        BRDF(const BRDF_TYPE type);
-
-        // Destructor
-        virtual ~BRDF();
-
-        // Check if BRDF matches given type
-        bool MatchesTypes(BRDF_TYPE types) const;
-
-        // Evaluate BRDF
-        virtual SSESpectrum f(const SSEVector &wo, const SSEVector &wi) const = 0;
+        static const BRDF_TYPE TYPE = BRDF_TYPE(BRDF_REFLECTION | BRDF_DIFFUSE);
 
-        // Sample BRDF
-        virtual SSESpectrum Sample_f(const SSEVector &wo, SSEVector *const wi,
-                                     float *const pdf, float u1, float u2,
-                                     BRDF_TYPE *const sampled_type = nullptr) const;
+        OrenNayar(const SSESpectrum &r, float sigma);
 
-        // Pdf of the BRDF
-        virtual float Pdf(const SSEVector &wo, const SSEVector &wi) const;
+        SSESpectrum f(const SSEVector &wo, const SSEVector &wi) const;
 
-        // BRDF type
-        const BRDF_TYPE type;
-    };
+        SSESpectrum Sample_f(const SSEVector &wo, SSEVector *const wi, float *const pdf, float u1, float u2) const {
+            *wi = CosineSampleLobe(wo, u1, u2);
+            *pdf = Pdf(wo, *wi);
 
-    // Lambertian BRDF
-
-    class LambertianReflection : public BRDF {
-    public:
-        // Constructor
-        LambertianReflection(const SSESpectrum &r);
+            return f(wo, *wi);
+        }
 
-        SSESpectrum f(const SSEVector &wo, const SSEVector &wi) const override;
+        float Pdf(const SSEVector &wo, const SSEVector &wi) const {
+            return CosineLobePdf(wo, wi);
+        }
 
     private:
-        // Reflectance
-        const SSESpectrum rho;
+        SSESpectrum rho;
+        float A, B;
     };
 
     // Specular reflection BRDF
-
-    class SpecularReflection : public BRDF {
+    class SpecularReflection {
     public:
-        // Constructor
-        SpecularReflection(const SSESpectrum &R, FresnelInterface *const f);
+        static const BRDF_TYPE TYPE = BRDF_TYPE(BRDF_REFLECTION | BRDF_SPECULAR);
 
-        ~SpecularReflection();
+        SpecularReflection(const SSESpectrum &R, const Fresnel &fresnel)
+                : R(R), fresnel(fresnel) {}
 
-        SSESpectrum f(const SSEVector &wo, const SSEVector &wi) const override;
+        SSESpectrum f(const SSEVector &, const SSEVector &) const {
+            return SSESpectrum(0.f);
+        }
+
+        SSESpectrum Sample_f(const SSEVector &wo, SSEVector *const wi, float *const pdf, float, float) const {
+            // Compute perfect specular direction
+            *wi = SSEVector(-wo.x, wo.y, -wo.z, 0.f);
+            *pdf = 1.f;
 
-        SSESpectrum Sample_f(const SSEVector &wo, SSEVector *const wi,
-                             float *const pdf, float u1, float u2,
-                             BRDF_TYPE *const sampled_type) const override;
+            // Note that there is not division by cosine term!
+            return SSESpectrum(fresnel.Evaluate(CosTheta(*wi)) * R);
+        }
 
-        float Pdf(const SSEVector &wo, const SSEVector &wi) const override;
+        float Pdf(const SSEVector &, const SSEVector &) const {
+            return 0.f;
+        }
 
     private:
         // Reflection
-        const SSESpectrum R;
-        const FresnelInterface *fresnel;
+        SSESpectrum R;
+        Fresnel fresnel;
     };
 
     // Specular transmission BRDF
-
-    class SpecularTransmission : public BRDF {
+    class SpecularTransmission {
     public:
-        // Constructor
-        SpecularTransmission(const SSESpectrum &T, float eta_a, float eta_b);
+        static const BRDF_TYPE TYPE = BRDF_TYPE(BRDF_TRANSMISSION | BRDF_SPECULAR);
 
-        SSESpectrum f(const SSEVector &wo, const SSEVector &wi) const override;
+        SpecularTransmission(const SSESpectrum &T, float eta_a, float eta_b)
+                : T(T), eta_a(eta_a), eta_b(eta_b), fresnel(eta_a, eta_b) {}
 
-        SSESpectrum Sample_f(const SSEVector &wo, SSEVector *const wi,
-                             float *const pdf, float u1, float u2,
-                             BRDF_TYPE *const sampled_type) const override;
+        SSESpectrum f(const SSEVector &, const SSEVector &) const {
+            return SSESpectrum(0.f);
+        }
 
-        float Pdf(const SSEVector &wo, const SSEVector &wi) const override;
+        SSESpectrum Sample_f(const SSEVector &wo, SSEVector *const wi, float *const pdf, float, float) const;
+
+        float Pdf(const SSEVector &, const SSEVector &) const {
+            return 0.f;
+        }
 
     private:
         // Transmission
-        const SSESpectrum T;
-        const float eta_a, eta_b;
-        const FresnelDielectric fresnel;
+        SSESpectrum T;
+        float eta_a, eta_b;
+        Fresnel fresnel;
     };
 
+    // Define BRDF class, a tagged union of the lobes
+    class BRDF {
+    public:
+        BRDF()
+                : type(LambertianReflection::TYPE), kind(LAMBERTIAN), lambertian(SSESpectrum(0.f)) {}
 
-    // Combined Fresnel specular BRDF
-
-//    class FresnelSpecular : public BRDF {
-//    public:
-//        // Constructor
-//        FresnelSpecular(const SSESpectrum &R, const SSESpectrum &T, float eta_a, float eta_b);
-//
-//        SSESpectrum f(const SSEVector &wo, const SSEVector &wi) const override;
-//
-//        SSESpectrum Sample_f(const SSEVector &wo, SSEVector *const wi,
-//                             float *const pdf, float u1, float u2,
-//                             BRDF_TYPE *const sampled_type) const override;
-//
-//        float Pdf(const SSEVector &wo, const SSEVector &wi) const override;
-//
-//    private:
-//        // Reflection and transmission
-//        const SSESpectrum R, T;
-//        const float eta_a, eta_b;
-//        const FresnelDielectric fresnel;
-//    };
+        BRDF(const LambertianReflection &lobe)
+                : type(LambertianReflection::TYPE), kind(LAMBERTIAN), lambertian(lobe) {}
 
-    // Define Oren-Nayar class
-    class OrenNayar : public BRDF {
+        BRDF(const OrenNayar &lobe)
+                : type(OrenNayar::TYPE), kind(OREN_NAYAR), oren_nayar(lobe) {}
+
+        BRDF(const SpecularReflection &lobe)
+                : type(SpecularReflection::TYPE), kind(SPECULAR_REFLECTION), specular_reflection(lobe) {}
+
+        BRDF(const SpecularTransmission &lobe)
+                : type(SpecularTransmission::TYPE), kind(SPECULAR_TRANSMISSION), specular_transmission(lobe) {}
+
+        BRDF(const BRDF &other)
+                : type(other.type), kind(other.kind) {
+            CopyLobe(other);
+        }
+
+        BRDF &operator=(const BRDF &other) {
+            type = other.type;
+            kind = other.kind;
+            CopyLobe(other);
+
+            return *this;
+        }
+
+        // Check if BRDF matches given type
+        bool MatchesTypes(BRDF_TYPE types) const {
+            return pixel::MatchesTypes(type, types);
+        }
+
+        // Evaluate BRDF
+        SSESpectrum f(const SSEVector &wo, const SSEVector &wi) const {
+            switch (kind) {
+                case LAMBERTIAN:
+                    return lambertian.f(wo, wi);
+                case OREN_NAYAR:
+                    return oren_nayar.f(wo, wi);
+                case SPECULAR_REFLECTION:
+                    return specular_reflection.f(wo, wi);
+                default:
+                    return specular_transmission.f(wo, wi);
+            }
+        }
+
+        // Sample BRDF
+        SSESpectrum Sample_f(const SSEVector &wo, SSEVector *const wi, float *const pdf, float u1, float u2) const {
+            switch (kind) {
+                case LAMBERTIAN:
+                    return lambertian.Sample_f(wo, wi, pdf, u1, u2);
+                case OREN_NAYAR:
+                    return oren_nayar.Sample_f(wo, wi, pdf, u1, u2);
+                case SPECULAR_REFLECTION:
+                    return specular_reflection.Sample_f(wo, wi, pdf, u1, u2);
+                default:
+                    return specular_transmission.Sample_f(wo, wi, pdf, u1, u2);
+            }
+        }
+
+        // Pdf of the BRDF
+        float Pdf(const SSEVector &wo, const SSEVector &wi) const {
+            switch (kind) {
+                case LAMBERTIAN:
+                    return lambertian.Pdf(wo, wi);
+                case OREN_NAYAR:
+                    return oren_nayar.Pdf(wo, wi);
+                case SPECULAR_REFLECTION:
+                    return specular_reflection.Pdf(wo, wi);
+                default:
+                    return specular_transmission.Pdf(wo, wi);
+            }
+        }
+
+        // BRDF type
+        BRDF_TYPE type;
+
+    private:
+        enum Kind : uint8_t {
+            LAMBERTIAN, OREN_NAYAR, SPECULAR_REFLECTION, SPECULAR_TRANSMISSION
+        };
+
+        // Copy construct the active lobe in place
+        void CopyLobe(const BRDF &other) {
+            switch (kind) {
+                case LAMBERTIAN:
+                    new(&lambertian) LambertianReflection(other.lambertian);
+                    break;
+                case OREN_NAYAR:
+                    new(&oren_nayar) OrenNayar(other.oren_nayar);
+                    break;
+                case SPECULAR_REFLECTION:
+                    new(&specular_reflection) SpecularReflection(other.specular_reflection);
+                    break;
+                default:
+                    new(&specular_transmission) SpecularTransmission(other.specular_transmission);
+                    break;
+            }
+        }
+
+        Kind kind;
+
+        union {
+            LambertianReflection lambertian;
+            OrenNayar oren_nayar;
+            SpecularReflection specular_reflection;
+            SpecularTransmission specular_transmission;
+        };
+    };
+
+    // Define BSDF class, which represents a combination of up to MAX_BRDFS lobes stored in place
+    class BSDF {
     public:
-        // Constructor
-        OrenNayar(const SSESpectrum &r, float sigma);
+        static const uint32_t MAX_BRDFS = 4;
+
+        // Constructor, eta is the relative index of refraction for transmissive surfaces
+        BSDF(const SurfaceInteraction &interaction, float eta = 1.f);
+
+        // Add BRDF
+        void AddBRDF(const BRDF &brdf);
+
+        // Number of matching BRDF
+        uint32_t NumMatchingBRDF(BRDF_TYPE types = ALL_BRDF) const;
+
+        // Evaluate BSDF
+        SSESpectrum f(const SSEVector &wo_world, const SSEVector &wi_world, BRDF_TYPE types = ALL_BRDF) const;
 
-        SSESpectrum f(const SSEVector &wo, const SSEVector &wi) const override;
+        // Sample BRDF
+        SSESpectrum Sample_f(const SSEVector &wo_world, SSEVector *const wi_world, float *const pdf,
+                             float u1, float u2,
+                             BRDF_TYPE types = ALL_BRDF,
+                             BRDF_TYPE *const sampled_type = nullptr) const;
+
+        // BSDF pdf
+        float Pdf(const SSEVector &wo_world, const SSEVector &wi_world, BRDF_TYPE types = ALL_BRDF) const;
+
+        // Estimate the fraction of the light reflected or transmitted towards wo, exact for the Lambertian and
+        // specular lobes
+        SSESpectrum Rho(const SSEVector &wo_world) const;
+
+        // Relative index of refraction
+        const float eta;
 
     private:
-        const SSESpectrum rho;
-        float A, B;
+        // Transform vector to local space
+        SSEVector WorldToLocal(const SSEVector &v) const {
+            return SSEVector(DotProduct(v, s), DotProduct(v, geometric_normal), DotProduct(v, t), v.w);
+        }
+
+        SSEVector LocalToWorld(const SSEVector &v) const {
+            return (v.x * s + v.y * geometric_normal + v.z * t);
+        }
+
+        // Local base
+        const SSEVector geometric_normal;
+        const SSEVector s, t;
+        // Added BRDFs
+        BRDF brdfs[MAX_BRDFS];
+        uint32_t n_brdfs;
+        // Union of the types of the BRDFs, when all of them match there is no need to check them one by one
+        BRDF_TYPE all_types;
     };
 }
 
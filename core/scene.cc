@@ -25,6 +25,8 @@
 #include "scene.h"
 #include "primitive.h"
 #include "interaction.h"
+#include "light.h"
+#include "bbox.h"
 
 namespace pixel {
 
@@ -34,6 +36,9 @@ namespace pixel {
 
     void Scene::AddLight(const LightInterface *const l) {
         lights.push_back(l);
+        if (l->IsInfiniteLight()) {
+            infinite_lights.push_back(l);
+        }
     }
 
     std::vector<const LightInterface *> const &Scene::GetLights() const {
@@ -41,11 +46,30 @@ namespace pixel {
     }
 
     bool Scene::Intersect(const Ray &r, SurfaceInteraction *const interaction) const {
-        return root->Intersect(r, interaction);
+        if (!root->Intersect(r, interaction)) { return false; }
+        // Instanced hits are completed by their instance, which transforms the ray to object space
+        const PrimitiveInterface *hit = interaction->instance_ptr ? interaction->instance_ptr : interaction->prim_ptr;
+        hit->ComputeSurfaceInteraction(r, interaction);
+        interaction->ComputeDifferentials(r);
+
+        return true;
     }
 
     bool Scene::IntersectP(const Ray &r) const {
         return root->IntersectP(r);
     }
 
+    BBox Scene::WorldBound() const {
+        return root->PrimitiveBounding();
+    }
+
+    SSESpectrum Scene::EnvironmentRadiance(const Ray &r) const {
+        SSESpectrum L(0.f);
+        for (const LightInterface *light : infinite_lights) {
+            L += light->Le(r);
+        }
+
+        return L;
+    }
+
 }
\ No newline at end of file
@@ -49,17 +49,25 @@ namespace pixel {
         // Access the list of lights
         std::vector<const LightInterface *> const &GetLights() const;
 
-        // Compute intersection of a ray with scene
+        // Compute intersection of a ray with scene, the surface_interaction is completed only for the closest hit
         bool Intersect(const Ray &r, SurfaceInteraction *const interaction) const;
 
         // Check for intersection with scene
         bool IntersectP(const Ray &r) const;
 
+        // Bounds of the scene geometry
+        BBox WorldBound() const;
+
+        // Radiance of the lights at infinity reaching a ray that leaves the scene
+        SSESpectrum EnvironmentRadiance(const Ray &r) const;
+
     private:
         // Scene root primitive
         const PrimitiveInterface *const root;
         // List of lights in the scene
         std::vector<const LightInterface *> lights;
+        // Lights at infinity, also in lights
+        std::vector<const LightInterface *> infinite_lights;
     };
 
 }
@@ -0,0 +1,254 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2016 simon.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "sd_tree.h"
+#include "fast_math.h"
+
+#include <algorithm>
+
+namespace pixel {
+
+    // Fraction of the total radiance above which a quadrant is subdivided, and maximum depth of a DTree
+    static const float DTREE_ENERGY_FRACTION = 0.01f;
+    static const uint32_t DTREE_MAX_DEPTH = 20;
+
+    // Estimates a region records in the first pass before it is split, the threshold grows with the
+    // square root of the number of estimates per pass, which doubles each pass
+    static const float SDTREE_SPLIT_THRESHOLD = 12000.f;
+
+    // Largest float below 1
+    static const float ONE_MINUS_EPSILON = 0.99999994f;
+
+    // Map a direction to [0, 1]^2 and back, through its cylindrical coordinates
+    static void DirectionToSquare(const SSEVector &w, float *const x, float *const y) {
+        const float cos_theta = Clamp(w.z, -1.f, 1.f);
+        float phi = Atan2(w.y, w.x);
+        if (phi < 0.f) {
+            phi += TWO_PI;
+        }
+        *x = std::min((cos_theta + 1.f) * 0.5f, ONE_MINUS_EPSILON);
+        *y = std::min(phi * ONE_OVER_2_PI, ONE_MINUS_EPSILON);
+    }
+
+    static SSEVector SquareToDirection(float x, float y) {
+        const float cos_theta = 2.f * x - 1.f;
+        const float sin_theta = std::sqrt(std::max(0.f, 1.f - cos_theta * cos_theta));
+        float sin_phi, cos_phi;
+        SinCos(TWO_PI * y, &sin_phi, &cos_phi);
+
+        return SSEVector(sin_theta * cos_phi, sin_theta * sin_phi, cos_theta, 0.f);
+    }
+
+    DTree::Node::Node()
+            : sum{0.f, 0.f, 0.f, 0.f}, child{0, 0, 0, 0} {
+    }
+
+    uint32_t DTree::Node::Quadrant(float *const x, float *const y) {
+        const uint32_t qx = *x >= 0.5f;
+        const uint32_t qy = *y >= 0.5f;
+        *x = *x * 2.f - qx;
+        *y = *y * 2.f - qy;
+
+        return qx | (qy << 1);
+    }
+
+    DTree::DTree()
+            : nodes(1), n_samples(0) {
+    }
+
+    void DTree::Record(const SSEVector &w, float radiance) {
+        if (!std::isfinite(radiance)) {
+            return;
+        }
+        float x, y;
+        DirectionToSquare(w, &x, &y);
+        // Every level keeps the radiance of its quadrants
+        uint32_t node = 0;
+        while (true) {
+            const uint32_t q = Node::Quadrant(&x, &y);
+            nodes[node].sum[q] += radiance;
+            if (!nodes[node].child[q]) {
+                break;
+            }
+            node = nodes[node].child[q];
+        }
+        n_samples++;
+    }
+
+    SSEVector DTree::Sample(float u1, float u2, float *const pdf) const {
+        float x = 0.f, y = 0.f, size = 1.f;
+        float p = 1.f;
+        uint32_t node = 0;
+        while (true) {
+            const Node &n = nodes[node];
+            const float total = n.Sum();
+            // Choose the column of the quadrant and then its row, reusing the samples
+            const float left = n.sum[0] + n.sum[2];
+            const float p_left = left / total;
+            uint32_t qx = 0;
+            if (u1 < p_left) {
+                u1 = u1 / p_left;
+            } else {
+                qx = 1;
+                u1 = (u1 - p_left) / (1.f - p_left);
+            }
+            const float column = qx ? total - left : left;
+            const float p_bottom = n.sum[qx] / column;
+            uint32_t qy = 0;
+            if (u2 < p_bottom) {
+                u2 = u2 / p_bottom;
+            } else {
+                qy = 1;
+                u2 = (u2 - p_bottom) / (1.f - p_bottom);
+            }
+            u1 = std::min(u1, ONE_MINUS_EPSILON);
+            u2 = std::min(u2, ONE_MINUS_EPSILON);
+            const uint32_t q = qx | (qy << 1);
+            p *= 4.f * n.sum[q] / total;
+            size *= 0.5f;
+            x += qx * size;
+            y += qy * size;
+            if (!n.child[q]) {
+                break;
+            }
+            node = n.child[q];
+        }
+        // Uniform within the leaf quadrant, the square maps to the sphere with a constant jacobian
+        *pdf = p * ONE_OVER_4_PI;
+
+        return SquareToDirection(x + u1 * size, y + u2 * size);
+    }
+
+    float DTree::Pdf(const SSEVector &w) const {
+        float x, y;
+        DirectionToSquare(w, &x, &y);
+        float p = ONE_OVER_4_PI;
+        uint32_t node = 0;
+        while (true) {
+            const Node &n = nodes[node];
+            const float total = n.Sum();
+            if (total <= 0.f) {
+                return 0.f;
+            }
+            const uint32_t q = Node::Quadrant(&x, &y);
+            p *= 4.f * n.sum[q] / total;
+            if (!n.child[q] || p == 0.f) {
+                break;
+            }
+            node = n.child[q];
+        }
+
+        return p;
+    }
+
+    float DTree::Flux() const {
+        return nodes[0].Sum();
+    }
+
+    void DTree::Refine(const DTree &other) {
+        nodes.assign(1, Node());
+        n_samples = 0;
+        const float total = other.Flux();
+        if (!(total > 0.f)) {
+            return;
+        }
+        // Node to refine, its counterpart in the other tree, 0 past its leaves except for the root, and its
+        // radiance
+        struct Entry {
+            uint32_t node, other_node;
+            float radiance;
+            uint32_t depth;
+        };
+        std::vector<Entry> stack;
+        stack.push_back({0, 0, total, 1});
+        while (!stack.empty()) {
+            const Entry e = stack.back();
+            stack.pop_back();
+            const bool has_other = e.node == 0 || e.other_node != 0;
+            for (uint32_t q = 0; q < 4; q++) {
+                // Past the leaves of the other tree, the radiance is spread evenly
+                const float radiance = has_other ? other.nodes[e.other_node].sum[q] : e.radiance * 0.25f;
+                if (e.depth < DTREE_MAX_DEPTH && radiance > total * DTREE_ENERGY_FRACTION) {
+                    const uint32_t child = static_cast<uint32_t>(nodes.size());
+                    nodes.emplace_back();
+                    nodes[e.node].child[q] = child;
+                    stack.push_back({child, has_other ? other.nodes[e.other_node].child[q] : 0, radiance,
+                                     e.depth + 1});
+                }
+            }
+        }
+    }
+
+    SDTree::SDTree(const BBox &bounds)
+            : bounds(bounds), nodes(1, Node{0, 0, 0}), regions(1), pass(0) {
+    }
+
+    SDTree::Region *SDTree::Lookup(const SSEVector &p) {
+        const SSEVector o = bounds.Offset(p);
+        float c[3] = {Clamp(o.x, 0.f, 1.f), Clamp(o.y, 0.f, 1.f), Clamp(o.z, 0.f, 1.f)};
+        uint32_t node = 0;
+        while (nodes[node].child) {
+            float &ca = c[nodes[node].axis];
+            const uint32_t side = ca >= 0.5f;
+            ca = ca * 2.f - side;
+            node = nodes[node].child + side;
+        }
+
+        return &regions[nodes[node].region];
+    }
+
+    void SDTree::Split(uint32_t node, float threshold) {
+        Region &region = regions[nodes[node].region];
+        if (region.building.SampleCount() <= threshold) {
+            return;
+        }
+        // Each half is assumed to have recorded half of the estimates
+        region.building.ScaleSampleCount(0.5f);
+        const Region half = region;
+        const uint32_t axis = (nodes[node].axis + 1) % 3;
+        const uint32_t child = static_cast<uint32_t>(nodes.size());
+        nodes.push_back(Node{0, nodes[node].region, axis});
+        nodes.push_back(Node{0, static_cast<uint32_t>(regions.size()), axis});
+        regions.push_back(half);
+        nodes[node].child = child;
+        Split(child, threshold);
+        Split(child + 1, threshold);
+    }
+
+    void SDTree::Refine() {
+        const float threshold = SDTREE_SPLIT_THRESHOLD * std::sqrt(std::pow(2.f, static_cast<float>(pass)));
+        const uint32_t n_nodes = static_cast<uint32_t>(nodes.size());
+        for (uint32_t i = 0; i < n_nodes; i++) {
+            if (!nodes[i].child) {
+                Split(i, threshold);
+            }
+        }
+        for (Region &region : regions) {
+            region.sampling = region.building;
+            region.building.Refine(region.sampling);
+        }
+        pass++;
+    }
+
+}
@@ -0,0 +1,148 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2016 simon.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * File:   sd_tree.h
+ * Author: simon
+ *
+ * Created on October 19, 2026, 11:50 PM
+ */
+
+#ifndef PIXEL_SD_TREE_H
+#define PIXEL_SD_TREE_H
+
+#include "pixel.h"
+#include "sse_vector.h"
+#include "bbox.h"
+
+#include <vector>
+
+namespace pixel {
+
+    // Define DTree class, quadtree over the directions of the sphere. Directions are mapped to [0, 1]^2 by
+    // their cylindrical coordinates (cos theta, phi), which preserves areas, and each node keeps the radiance
+    // recorded in its four quadrants
+    class DTree {
+    public:
+        // Constructor, a single node with empty quadrants
+        DTree();
+
+        // Add a radiance estimate for a direction, already divided by the pdf it was sampled with
+        void Record(const SSEVector &w, float radiance);
+
+        // Sample a direction proportionally to the recorded radiance, the pdf is in solid angle
+        SSEVector Sample(float u1, float u2, float *const pdf) const;
+
+        // Pdf of sampling a direction
+        float Pdf(const SSEVector &w) const;
+
+        // Total recorded radiance, zero when nothing can be sampled
+        float Flux() const;
+
+        // Number of recorded estimates
+        uint32_t SampleCount() const {
+            return n_samples;
+        }
+
+        // Scale the number of recorded estimates, when a spatial region is split
+        void ScaleSampleCount(float s) {
+            n_samples = static_cast<uint32_t>(n_samples * s);
+        }
+
+        // Rebuild the quadrants following the radiance recorded in another tree: quadrants holding more than
+        // a fraction of the total are subdivided, the others merged. Recorded radiance is cleared
+        void Refine(const DTree &other);
+
+    private:
+        // Node of the tree, quadrant q covers [x, x + 1/2] x [y, y + 1/2] of the node with x = q & 1, y = q >> 1
+        struct Node {
+            Node();
+
+            // Quadrant of a point of the node, which is moved to the quadrant coordinates
+            static uint32_t Quadrant(float *const x, float *const y);
+
+            float Sum() const {
+                return sum[0] + sum[1] + sum[2] + sum[3];
+            }
+
+            // Recorded radiance of the quadrants
+            float sum[4];
+            // Child node of the quadrants, 0 for leaves
+            uint32_t child[4];
+        };
+
+        // Nodes, the root is first
+        std::vector<Node> nodes;
+        // Number of recorded estimates
+        uint32_t n_samples;
+    };
+
+    // Define SDTree class, binary tree over the scene bounds, split along one axis after the other, whose
+    // leaves hold the directional distribution of the incident radiance. The distribution is learned over
+    // passes: each pass samples the one recorded in the previous pass while recording the next
+    class SDTree {
+    public:
+        // Leaf of the spatial tree
+        struct Region {
+            // Distribution sampled in this pass and the one being recorded
+            DTree sampling, building;
+        };
+
+        // Constructor
+        SDTree(const BBox &bounds);
+
+        // Region holding a point
+        Region *Lookup(const SSEVector &p);
+
+        // End a pass: split the regions that recorded many estimates, then sample the recorded distributions
+        // and rebuild the ones to record
+        void Refine();
+
+    private:
+        // Node of the spatial tree
+        struct Node {
+            // First of the two children, 0 for leaves
+            uint32_t child;
+            // Region of a leaf
+            uint32_t region;
+            // Split axis
+            uint32_t axis;
+        };
+
+        // Split the leaf of a node until its regions hold fewer estimates than threshold
+        void Split(uint32_t node, float threshold);
+
+        // Scene bounds
+        const BBox bounds;
+        // Nodes, the root is first
+        std::vector<Node> nodes;
+        // Regions of the leaves
+        std::vector<Region> regions;
+        // Number of finished passes
+        uint32_t pass;
+    };
+
+}
+
+#endif //PIXEL_SD_TREE_H
@@ -0,0 +1,90 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2016 simon.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "shading_batch.h"
+#include "interaction.h"
+#include "material.h"
+
+namespace pixel {
+
+    void ShadingBatch::Clear() {
+        entries.clear();
+    }
+
+    void ShadingBatch::Add(SurfaceInteraction *const interaction, uint32_t path) {
+        entries.push_back({reinterpret_cast<uint64_t>(interaction->mat_ptr), path, interaction});
+    }
+
+    void ShadingBatch::Sort() {
+        const uint32_t bits_per_pass = 8;
+        const uint32_t n_buckets = 1 << bits_per_pass;
+        const uint32_t n = Size();
+        if (n < 2) { return; }
+        // Digits shared by all the keys do not change the order, scenes have few materials so most of the
+        // address bits are the same
+        uint64_t varying = 0;
+        for (const Entry &e : entries) {
+            varying |= e.key ^ entries[0].key;
+        }
+
+        temp.resize(n);
+        uint32_t histogram[n_buckets];
+        for (uint32_t low_bit = 0; low_bit < 64 && (varying >> low_bit) != 0; low_bit += bits_per_pass) {
+            if (((varying >> low_bit) & (n_buckets - 1)) == 0) { continue; }
+            // Count bucket sizes
+            std::fill(histogram, histogram + n_buckets, 0);
+            for (const Entry &e : entries) {
+                histogram[(e.key >> low_bit) & (n_buckets - 1)]++;
+            }
+            // Compute output offsets
+            uint32_t offset = 0;
+            for (uint32_t b = 0; b < n_buckets; b++) {
+                const uint32_t count = histogram[b];
+                histogram[b] = offset;
+                offset += count;
+            }
+            // Scatter entries, stable so hits of a material stay in path order
+            for (const Entry &e : entries) {
+                temp[histogram[(e.key >> low_bit) & (n_buckets - 1)]++] = e;
+            }
+            entries.swap(temp);
+        }
+    }
+
+    void ShadingBatch::GenerateBSDFs() {
+        Sort();
+        interactions.resize(Size());
+        for (uint32_t i = 0; i < Size(); i++) {
+            interactions[i] = entries[i].interaction;
+        }
+        // Shade each run of hits with the same material
+        for (uint32_t begin = 0, end = 0; begin < Size(); begin = end) {
+            while (end < Size() && entries[end].key == entries[begin].key) {
+                end++;
+            }
+            entries[begin].interaction->mat_ptr->GetBSDFs(&interactions[begin], end - begin);
+        }
+    }
+
+}
@@ -0,0 +1,80 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2016 simon.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * File:   shading_batch.h
+ * Author: simon
+ *
+ * Created on October 19, 2026, 11:20 PM
+ */
+
+#ifndef PIXEL_SHADING_BATCH_H
+#define PIXEL_SHADING_BATCH_H
+
+#include "pixel.h"
+#include <vector>
+
+namespace pixel {
+
+    // Hits gathered from a batch of paths before shading. The hits are sorted by material so that each
+    // material creates the BSDFs of all its hits in one loop, keeping its code and textures in cache
+    class ShadingBatch {
+    public:
+        // Remove all hits, keeping the storage
+        void Clear();
+
+        // Add the hit of a path
+        void Add(SurfaceInteraction *const interaction, uint32_t path);
+
+        // Sort the hits by material and generate their BSDFs
+        void GenerateBSDFs();
+
+        uint32_t Size() const {
+            return static_cast<uint32_t>(entries.size());
+        }
+
+        // Path of the i-th hit, in material order after GenerateBSDFs
+        uint32_t Path(uint32_t i) const {
+            return entries[i].path;
+        }
+
+    private:
+        struct Entry {
+            // Sort key, the address of the material
+            uint64_t key;
+            uint32_t path;
+            SurfaceInteraction *interaction;
+        };
+
+        // Sort the entries by key with a least significant digit radix sort
+        void Sort();
+
+        std::vector<Entry> entries, temp;
+        // Interactions of the sorted hits, handed to the materials by group
+        std::vector<SurfaceInteraction *> interactions;
+    };
+
+}
+
+#endif //PIXEL_SHADING_BATCH_H
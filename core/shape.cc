@@ -53,8 +53,10 @@ namespace pixel {
         Ray ray = from.SpawnRay(wi);
         SurfaceInteraction interaction_light;
         float t_hit;
-        // Compute intersection
+        // Compute intersection, the normal is needed to convert the pdf
         if (!Intersect(ray, &t_hit, &interaction_light)) { return 0.f; }
+        ray.SetNewMaximum(t_hit);
+        ComputeSurfaceInteraction(ray, &interaction_light);
 
         // Convert area pdf to solid angle
         float pdf = SqrdLength(interaction_light.hit_point - from.hit_point) /
@@ -66,26 +68,16 @@ namespace pixel {
 
     BBox ShapeInterface::WorldBounding() const {
         // Compute transformed shape BBOX
-        BBox bbox = ShapeBounding();
-        // Compute all eight BBox vertices
-        SSEVector vertices[8];
-        vertices[0] = bbox.Min();
-        vertices[1] = SSEVector(bbox.Max().x, bbox.Min().y, bbox.Min().z, 1.f);
-        vertices[2] = SSEVector(bbox.Max().x, bbox.Min().y, bbox.Max().z, 1.f);
-        vertices[3] = SSEVector(bbox.Min().x, bbox.Min().y, bbox.Max().z, 1.f);
-
-        vertices[4] = SSEVector(bbox.Min().x, bbox.Max().y, bbox.Min().z, 1.f);
-        vertices[5] = SSEVector(bbox.Max().x, bbox.Max().y, bbox.Min().z, 1.f);
-        vertices[6] = bbox.Max();
-        vertices[7] = SSEVector(bbox.Min().x, bbox.Max().y, bbox.Max().z, 1.f);
+        return TransformBBox(ShapeBounding(), local_to_world);
+    }
 
-        // Reset BBox and compute the primitive one
-        bbox = BBox();
-        for (uint32_t i = 0; i < 8; i++) {
-            bbox = BBoxUnion(bbox, vertices[i]);
-        }
+    void ShapeInterface::SetTransform(const SSEMatrix &l2w) {
+        local_to_world = l2w;
+        world_to_local = Inverse(l2w);
+    }
 
-        return bbox;
+    const SSEMatrix &ShapeInterface::LocalToWorld() const {
+        return local_to_world;
     }
 
 }
\ No newline at end of file
@@ -48,10 +48,12 @@ namespace pixel {
         // Virtual destructor
         virtual ~ShapeInterface();
 
-        // Check if a ray interacts with the shape and possibly fill a
-        // surface_interaction class
+        // Check if a ray interacts with the shape, only the hit distance and parametric data are computed
         virtual bool Intersect(const Ray &ray, float *const t_hit, SurfaceInteraction *const interaction) const = 0;
 
+        // Fill the surface_interaction of a hit found by Intersect, the ray maximum is the hit distance
+        virtual void ComputeSurfaceInteraction(const Ray &ray, SurfaceInteraction *const interaction) const = 0;
+
         // Check if a ray interacts with the shape
         virtual bool IntersectP(const Ray &ray) const = 0;
 
@@ -75,6 +77,12 @@ namespace pixel {
         // Returns the world Shape BBOX
         virtual BBox WorldBounding() const;
 
+        // Move the shape, the acceleration structures containing it need to be refitted
+        void SetTransform(const SSEMatrix &l2w);
+
+        // Access the local to world transformation
+        const SSEMatrix &LocalToWorld() const;
+
     protected:
         // Transformation matrices
         SSEMatrix local_to_world, world_to_local;
@@ -0,0 +1,717 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2016 simon.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * File:   simd_float.h
+ * Author: simon
+ *
+ * Created on October 19, 2026, 3:40 PM
+ */
+
+#ifndef PIXEL_SIMD_FLOAT_H
+#define PIXEL_SIMD_FLOAT_H
+
+#include <cstdint>
+#include <immintrin.h>
+
+// Instruction set used by the wide types, selected at build time from the compiler target
+#if defined(__AVX512F__)
+#define PIXEL_SIMD_AVX512
+#elif defined(__AVX2__)
+#define PIXEL_SIMD_AVX2
+#else
+#define PIXEL_SIMD_SSE
+#endif
+
+// The types live in a namespace named after the instruction set, so that translation units built
+// for different targets never share the definition of an inline function
+#if defined(PIXEL_SIMD_AVX512)
+#define PIXEL_SIMD_NAMESPACE simd_avx512
+#elif defined(PIXEL_SIMD_AVX2)
+#define PIXEL_SIMD_NAMESPACE simd_avx2
+#else
+#define PIXEL_SIMD_NAMESPACE simd_sse
+#endif
+
+namespace pixel {
+inline namespace PIXEL_SIMD_NAMESPACE {
+
+    // Define Maskx8 class, result of comparisons between Floatx8
+    class Maskx8 {
+    public:
+        // Constructor
+        Maskx8() = default;
+
+        explicit Maskx8(bool v) {
+#ifdef PIXEL_SIMD_SSE
+            lo = hi = _mm_castsi128_ps(_mm_set1_epi32(v ? -1 : 0));
+#else
+            ymm = _mm256_castsi256_ps(_mm256_set1_epi32(v ? -1 : 0));
+#endif
+        }
+
+#ifdef PIXEL_SIMD_SSE
+
+        Maskx8(const __m128 &lo, const __m128 &hi)
+                : lo(lo), hi(hi) {
+        }
+
+        // Lanes 0-3 and 4-7, each lane all ones or all zeros
+        __m128 lo, hi;
+#else
+
+        explicit Maskx8(const __m256 &ymm)
+                : ymm(ymm) {
+        }
+
+        // Lanes all ones or all zeros
+        __m256 ymm;
+#endif
+    };
+
+    // Define Floatx8 class, 8 floats processed together with AVX or two SSE registers
+    class Floatx8 {
+    public:
+        // Number of lanes
+        static const uint32_t WIDTH = 8;
+
+        // Constructor
+        Floatx8() = default;
+
+        explicit Floatx8(float v) {
+#ifdef PIXEL_SIMD_SSE
+            lo = hi = _mm_set1_ps(v);
+#else
+            ymm = _mm256_set1_ps(v);
+#endif
+        }
+
+#ifdef PIXEL_SIMD_SSE
+
+        Floatx8(const __m128 &lo, const __m128 &hi)
+                : lo(lo), hi(hi) {
+        }
+
+#else
+
+        explicit Floatx8(const __m256 &ymm)
+                : ymm(ymm) {
+        }
+
+#endif
+
+        // Load and store unaligned values
+        static inline Floatx8 Load(const float *const p) {
+#ifdef PIXEL_SIMD_SSE
+            return Floatx8(_mm_loadu_ps(p), _mm_loadu_ps(p + 4));
+#else
+            return Floatx8(_mm256_loadu_ps(p));
+#endif
+        }
+
+        inline void Store(float *const p) const {
+#ifdef PIXEL_SIMD_SSE
+            _mm_storeu_ps(p, lo);
+            _mm_storeu_ps(p + 4, hi);
+#else
+            _mm256_storeu_ps(p, ymm);
+#endif
+        }
+
+        // Access a single lane
+        inline float operator[](uint32_t i) const {
+            float v[WIDTH];
+            Store(v);
+
+            return v[i];
+        }
+
+#ifdef PIXEL_SIMD_SSE
+        // Lanes 0-3 and 4-7
+        __m128 lo, hi;
+#else
+        __m256 ymm;
+#endif
+    };
+
+    // Apply an SSE or AVX operation to the lanes
+#ifdef PIXEL_SIMD_SSE
+#define PIXEL_X8_BINARY(T, sse, avx, a, b) T(sse((a).lo, (b).lo), sse((a).hi, (b).hi))
+#define PIXEL_X8_UNARY(T, sse, avx, a) T(sse((a).lo), sse((a).hi))
+#else
+#define PIXEL_X8_BINARY(T, sse, avx, a, b) T(avx((a).ymm, (b).ymm))
+#define PIXEL_X8_UNARY(T, sse, avx, a) T(avx((a).ymm))
+#endif
+
+    // Arithmetic
+    inline Floatx8 operator+(const Floatx8 &a, const Floatx8 &b) {
+        return PIXEL_X8_BINARY(Floatx8, _mm_add_ps, _mm256_add_ps, a, b);
+    }
+
+    inline Floatx8 operator-(const Floatx8 &a, const Floatx8 &b) {
+        return PIXEL_X8_BINARY(Floatx8, _mm_sub_ps, _mm256_sub_ps, a, b);
+    }
+
+    inline Floatx8 operator*(const Floatx8 &a, const Floatx8 &b) {
+        return PIXEL_X8_BINARY(Floatx8, _mm_mul_ps, _mm256_mul_ps, a, b);
+    }
+
+    inline Floatx8 operator/(const Floatx8 &a, const Floatx8 &b) {
+        return PIXEL_X8_BINARY(Floatx8, _mm_div_ps, _mm256_div_ps, a, b);
+    }
+
+    inline Floatx8 operator-(const Floatx8 &a) {
+        return Floatx8(0.f) - a;
+    }
+
+    inline Floatx8 Min(const Floatx8 &a, const Floatx8 &b) {
+        return PIXEL_X8_BINARY(Floatx8, _mm_min_ps, _mm256_min_ps, a, b);
+    }
+
+    inline Floatx8 Max(const Floatx8 &a, const Floatx8 &b) {
+        return PIXEL_X8_BINARY(Floatx8, _mm_max_ps, _mm256_max_ps, a, b);
+    }
+
+    inline Floatx8 Sqrt(const Floatx8 &a) {
+        return PIXEL_X8_UNARY(Floatx8, _mm_sqrt_ps, _mm256_sqrt_ps, a);
+    }
+
+    inline Floatx8 Abs(const Floatx8 &a) {
+        return Max(a, -a);
+    }
+
+    // Compute a * b + c, fused when the target supports it
+    inline Floatx8 MulAdd(const Floatx8 &a, const Floatx8 &b, const Floatx8 &c) {
+#if defined(__FMA__) && !defined(PIXEL_SIMD_SSE)
+        return Floatx8(_mm256_fmadd_ps(a.ymm, b.ymm, c.ymm));
+#else
+        return a * b + c;
+#endif
+    }
+
+    // Comparisons
+#ifdef PIXEL_SIMD_SSE
+#define PIXEL_X8_COMPARE(a, b, sse, avx) Maskx8(sse((a).lo, (b).lo), sse((a).hi, (b).hi))
+#else
+#define PIXEL_X8_COMPARE(a, b, sse, avx) Maskx8(_mm256_cmp_ps((a).ymm, (b).ymm, avx))
+#endif
+
+    inline Maskx8 operator<(const Floatx8 &a, const Floatx8 &b) {
+        return PIXEL_X8_COMPARE(a, b, _mm_cmplt_ps, _CMP_LT_OQ);
+    }
+
+    inline Maskx8 operator<=(const Floatx8 &a, const Floatx8 &b) {
+        return PIXEL_X8_COMPARE(a, b, _mm_cmple_ps, _CMP_LE_OQ);
+    }
+
+    inline Maskx8 operator>(const Floatx8 &a, const Floatx8 &b) {
+        return PIXEL_X8_COMPARE(a, b, _mm_cmpgt_ps, _CMP_GT_OQ);
+    }
+
+    inline Maskx8 operator>=(const Floatx8 &a, const Floatx8 &b) {
+        return PIXEL_X8_COMPARE(a, b, _mm_cmpge_ps, _CMP_GE_OQ);
+    }
+
+    inline Maskx8 operator==(const Floatx8 &a, const Floatx8 &b) {
+        return PIXEL_X8_COMPARE(a, b, _mm_cmpeq_ps, _CMP_EQ_OQ);
+    }
+
+#undef PIXEL_X8_COMPARE
+
+    // Mask logic
+    inline Maskx8 operator&(const Maskx8 &a, const Maskx8 &b) {
+        return PIXEL_X8_BINARY(Maskx8, _mm_and_ps, _mm256_and_ps, a, b);
+    }
+
+    inline Maskx8 operator|(const Maskx8 &a, const Maskx8 &b) {
+        return PIXEL_X8_BINARY(Maskx8, _mm_or_ps, _mm256_or_ps, a, b);
+    }
+
+    inline Maskx8 operator^(const Maskx8 &a, const Maskx8 &b) {
+        return PIXEL_X8_BINARY(Maskx8, _mm_xor_ps, _mm256_xor_ps, a, b);
+    }
+
+    inline Maskx8 operator~(const Maskx8 &a) {
+        return a ^ Maskx8(true);
+    }
+
+    // Bit i is set if lane i is set
+    inline uint32_t MoveMask(const Maskx8 &m) {
+#ifdef PIXEL_SIMD_SSE
+        return static_cast<uint32_t>(_mm_movemask_ps(m.lo) | (_mm_movemask_ps(m.hi) << 4));
+#else
+        return static_cast<uint32_t>(_mm256_movemask_ps(m.ymm));
+#endif
+    }
+
+    inline bool Any(const Maskx8 &m) {
+        return MoveMask(m) != 0;
+    }
+
+    inline bool All(const Maskx8 &m) {
+        return MoveMask(m) == 0xFF;
+    }
+
+    // Masked blend, lanes of a where the mask is set and of b elsewhere
+    inline Floatx8 Select(const Maskx8 &m, const Floatx8 &a, const Floatx8 &b) {
+#ifdef PIXEL_SIMD_SSE
+        return Floatx8(_mm_blendv_ps(b.lo, a.lo, m.lo), _mm_blendv_ps(b.hi, a.hi, m.hi));
+#else
+        return Floatx8(_mm256_blendv_ps(b.ymm, a.ymm, m.ymm));
+#endif
+    }
+
+    // Round to the nearest integer
+    inline Floatx8 Round(const Floatx8 &a) {
+#ifdef PIXEL_SIMD_SSE
+        return Floatx8(_mm_round_ps(a.lo, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC),
+                       _mm_round_ps(a.hi, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+#else
+        return Floatx8(_mm256_round_ps(a.ymm, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+#endif
+    }
+
+    // Split positive normal values in exponent and mantissa in [1, 2)
+    inline Floatx8 Exponent(const Floatx8 &a, Floatx8 *const mantissa) {
+#ifdef PIXEL_SIMD_SSE
+        const __m128i lo = _mm_castps_si128(a.lo);
+        const __m128i hi = _mm_castps_si128(a.hi);
+        *mantissa = Floatx8(
+                _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(lo, _mm_set1_epi32(0x007FFFFF)),
+                                              _mm_set1_epi32(0x3F800000))),
+                _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(hi, _mm_set1_epi32(0x007FFFFF)),
+                                              _mm_set1_epi32(0x3F800000))));
+
+        return Floatx8(_mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(lo, 23), _mm_set1_epi32(127))),
+                       _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(hi, 23), _mm_set1_epi32(127))));
+#else
+        const __m256i bits = _mm256_castps_si256(a.ymm);
+        *mantissa = Floatx8(_mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007FFFFF)),
+                                                                _mm256_set1_epi32(0x3F800000))));
+
+        return Floatx8(_mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127))));
+#endif
+    }
+
+    // Compute 2^i for integer values in [-126, 127]
+    inline Floatx8 Exp2Integer(const Floatx8 &i) {
+#ifdef PIXEL_SIMD_SSE
+        return Floatx8(_mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(_mm_cvtps_epi32(i.lo), _mm_set1_epi32(127)), 23)),
+                       _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(_mm_cvtps_epi32(i.hi), _mm_set1_epi32(127)), 23)));
+#else
+        return Floatx8(_mm256_castsi256_ps(
+                _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(i.ymm), _mm256_set1_epi32(127)), 23)));
+#endif
+    }
+
+#undef PIXEL_X8_BINARY
+#undef PIXEL_X8_UNARY
+
+#ifdef PIXEL_SIMD_AVX512
+
+    // Define Maskx16 class, result of comparisons between Floatx16
+    class Maskx16 {
+    public:
+        // Constructor
+        Maskx16() = default;
+
+        explicit Maskx16(bool v)
+                : k(v ? 0xFFFF : 0) {
+        }
+
+        explicit Maskx16(__mmask16 k)
+                : k(k) {
+        }
+
+        // One bit per lane
+        __mmask16 k;
+    };
+
+    // Define Floatx16 class, 16 floats processed together with AVX-512
+    class Floatx16 {
+    public:
+        // Number of lanes
+        static const uint32_t WIDTH = 16;
+
+        // Constructor
+        Floatx16() = default;
+
+        explicit Floatx16(float v)
+                : zmm(_mm512_set1_ps(v)) {
+        }
+
+        explicit Floatx16(const __m512 &zmm)
+                : zmm(zmm) {
+        }
+
+        // Load and store unaligned values
+        static inline Floatx16 Load(const float *const p) {
+            return Floatx16(_mm512_loadu_ps(p));
+        }
+
+        inline void Store(float *const p) const {
+            _mm512_storeu_ps(p, zmm);
+        }
+
+        // Access a single lane
+        inline float operator[](uint32_t i) const {
+            float v[WIDTH];
+            Store(v);
+
+            return v[i];
+        }
+
+        __m512 zmm;
+    };
+
+    // Arithmetic
+    inline Floatx16 operator+(const Floatx16 &a, const Floatx16 &b) {
+        return Floatx16(_mm512_add_ps(a.zmm, b.zmm));
+    }
+
+    inline Floatx16 operator-(const Floatx16 &a, const Floatx16 &b) {
+        return Floatx16(_mm512_sub_ps(a.zmm, b.zmm));
+    }
+
+    inline Floatx16 operator*(const Floatx16 &a, const Floatx16 &b) {
+        return Floatx16(_mm512_mul_ps(a.zmm, b.zmm));
+    }
+
+    inline Floatx16 operator/(const Floatx16 &a, const Floatx16 &b) {
+        return Floatx16(_mm512_div_ps(a.zmm, b.zmm));
+    }
+
+    inline Floatx16 operator-(const Floatx16 &a) {
+        return Floatx16(0.f) - a;
+    }
+
+    inline Floatx16 Min(const Floatx16 &a, const Floatx16 &b) {
+        return Floatx16(_mm512_min_ps(a.zmm, b.zmm));
+    }
+
+    inline Floatx16 Max(const Floatx16 &a, const Floatx16 &b) {
+        return Floatx16(_mm512_max_ps(a.zmm, b.zmm));
+    }
+
+    inline Floatx16 Sqrt(const Floatx16 &a) {
+        return Floatx16(_mm512_sqrt_ps(a.zmm));
+    }
+
+    inline Floatx16 Abs(const Floatx16 &a) {
+        return Max(a, -a);
+    }
+
+    inline Floatx16 MulAdd(const Floatx16 &a, const Floatx16 &b, const Floatx16 &c) {
+        return Floatx16(_mm512_fmadd_ps(a.zmm, b.zmm, c.zmm));
+    }
+
+    // Comparisons
+    inline Maskx16 operator<(const Floatx16 &a, const Floatx16 &b) {
+        return Maskx16(_mm512_cmp_ps_mask(a.zmm, b.zmm, _CMP_LT_OQ));
+    }
+
+    inline Maskx16 operator<=(const Floatx16 &a, const Floatx16 &b) {
+        return Maskx16(_mm512_cmp_ps_mask(a.zmm, b.zmm, _CMP_LE_OQ));
+    }
+
+    inline Maskx16 operator>(const Floatx16 &a, const Floatx16 &b) {
+        return Maskx16(_mm512_cmp_ps_mask(a.zmm, b.zmm, _CMP_GT_OQ));
+    }
+
+    inline Maskx16 operator>=(const Floatx16 &a, const Floatx16 &b) {
+        return Maskx16(_mm512_cmp_ps_mask(a.zmm, b.zmm, _CMP_GE_OQ));
+    }
+
+    inline Maskx16 operator==(const Floatx16 &a, const Floatx16 &b) {
+        return Maskx16(_mm512_cmp_ps_mask(a.zmm, b.zmm, _CMP_EQ_OQ));
+    }
+
+    // Mask logic
+    inline Maskx16 operator&(const Maskx16 &a, const Maskx16 &b) {
+        return Maskx16(static_cast<__mmask16>(a.k & b.k));
+    }
+
+    inline Maskx16 operator|(const Maskx16 &a, const Maskx16 &b) {
+        return Maskx16(static_cast<__mmask16>(a.k | b.k));
+    }
+
+    inline Maskx16 operator^(const Maskx16 &a, const Maskx16 &b) {
+        return Maskx16(static_cast<__mmask16>(a.k ^ b.k));
+    }
+
+    inline Maskx16 operator~(const Maskx16 &a) {
+        return Maskx16(static_cast<__mmask16>(~a.k));
+    }
+
+    inline uint32_t MoveMask(const Maskx16 &m) {
+        return static_cast<uint32_t>(m.k);
+    }
+
+    // Masked blend, lanes of a where the mask is set and of b elsewhere
+    inline Floatx16 Select(const Maskx16 &m, const Floatx16 &a, const Floatx16 &b) {
+        return Floatx16(_mm512_mask_blend_ps(m.k, b.zmm, a.zmm));
+    }
+
+    // Round to the nearest integer
+    inline Floatx16 Round(const Floatx16 &a) {
+        return Floatx16(_mm512_roundscale_ps(a.zmm, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+    }
+
+    // Split positive normal values in exponent and mantissa in [1, 2)
+    inline Floatx16 Exponent(const Floatx16 &a, Floatx16 *const mantissa) {
+        *mantissa = Floatx16(_mm512_getmant_ps(a.zmm, _MM_MANT_NORM_1_2, _MM_MANT_SIGN_zero));
+
+        return Floatx16(_mm512_getexp_ps(a.zmm));
+    }
+
+    // Compute 2^i for integer values in [-126, 127]
+    inline Floatx16 Exp2Integer(const Floatx16 &i) {
+        return Floatx16(_mm512_scalef_ps(_mm512_set1_ps(1.f), i.zmm));
+    }
+
+#else
+
+    // Define Maskx16 class, two Maskx8 without AVX-512
+    class Maskx16 {
+    public:
+        // Constructor
+        Maskx16() = default;
+
+        explicit Maskx16(bool v)
+                : lo(v), hi(v) {
+        }
+
+        Maskx16(const Maskx8 &lo, const Maskx8 &hi)
+                : lo(lo), hi(hi) {
+        }
+
+        // Lanes 0-7 and 8-15
+        Maskx8 lo, hi;
+    };
+
+    // Define Floatx16 class, two Floatx8 without AVX-512
+    class Floatx16 {
+    public:
+        // Number of lanes
+        static const uint32_t WIDTH = 16;
+
+        // Constructor
+        Floatx16() = default;
+
+        explicit Floatx16(float v)
+                : lo(v), hi(v) {
+        }
+
+        Floatx16(const Floatx8 &lo, const Floatx8 &hi)
+                : lo(lo), hi(hi) {
+        }
+
+        // Load and store unaligned values
+        static inline Floatx16 Load(const float *const p) {
+            return Floatx16(Floatx8::Load(p), Floatx8::Load(p + 8));
+        }
+
+        inline void Store(float *const p) const {
+            lo.Store(p);
+            hi.Store(p + 8);
+        }
+
+        // Access a single lane
+        inline float operator[](uint32_t i) const {
+            return (i < 8) ? lo[i] : hi[i - 8];
+        }
+
+        // Lanes 0-7 and 8-15
+        Floatx8 lo, hi;
+    };
+
+    // Arithmetic
+    inline Floatx16 operator+(const Floatx16 &a, const Floatx16 &b) {
+        return Floatx16(a.lo + b.lo, a.hi + b.hi);
+    }
+
+    inline Floatx16 operator-(const Floatx16 &a, const Floatx16 &b) {
+        return Floatx16(a.lo - b.lo, a.hi - b.hi);
+    }
+
+    inline Floatx16 operator*(const Floatx16 &a, const Floatx16 &b) {
+        return Floatx16(a.lo * b.lo, a.hi * b.hi);
+    }
+
+    inline Floatx16 operator/(const Floatx16 &a, const Floatx16 &b) {
+        return Floatx16(a.lo / b.lo, a.hi / b.hi);
+    }
+
+    inline Floatx16 operator-(const Floatx16 &a) {
+        return Floatx16(-a.lo, -a.hi);
+    }
+
+    inline Floatx16 Min(const Floatx16 &a, const Floatx16 &b) {
+        return Floatx16(Min(a.lo, b.lo), Min(a.hi, b.hi));
+    }
+
+    inline Floatx16 Max(const Floatx16 &a, const Floatx16 &b) {
+        return Floatx16(Max(a.lo, b.lo), Max(a.hi, b.hi));
+    }
+
+    inline Floatx16 Sqrt(const Floatx16 &a) {
+        return Floatx16(Sqrt(a.lo), Sqrt(a.hi));
+    }
+
+    inline Floatx16 Abs(const Floatx16 &a) {
+        return Floatx16(Abs(a.lo), Abs(a.hi));
+    }
+
+    inline Floatx16 MulAdd(const Floatx16 &a, const Floatx16 &b, const Floatx16 &c) {
+        return Floatx16(MulAdd(a.lo, b.lo, c.lo), MulAdd(a.hi, b.hi, c.hi));
+    }
+
+    // Comparisons
+    inline Maskx16 operator<(const Floatx16 &a, const Floatx16 &b) {
+        return Maskx16(a.lo < b.lo, a.hi < b.hi);
+    }
+
+    inline Maskx16 operator<=(const Floatx16 &a, const Floatx16 &b) {
+        return Maskx16(a.lo <= b.lo, a.hi <= b.hi);
+    }
+
+    inline Maskx16 operator>(const Floatx16 &a, const Floatx16 &b) {
+        return Maskx16(a.lo > b.lo, a.hi > b.hi);
+    }
+
+    inline Maskx16 operator>=(const Floatx16 &a, const Floatx16 &b) {
+        return Maskx16(a.lo >= b.lo, a.hi >= b.hi);
+    }
+
+    inline Maskx16 operator==(const Floatx16 &a, const Floatx16 &b) {
+        return Maskx16(a.lo == b.lo, a.hi == b.hi);
+    }
+
+    // Mask logic
+    inline Maskx16 operator&(const Maskx16 &a, const Maskx16 &b) {
+        return Maskx16(a.lo & b.lo, a.hi & b.hi);
+    }
+
+    inline Maskx16 operator|(const Maskx16 &a, const Maskx16 &b) {
+        return Maskx16(a.lo | b.lo, a.hi | b.hi);
+    }
+
+    inline Maskx16 operator^(const Maskx16 &a, const Maskx16 &b) {
+        return Maskx16(a.lo ^ b.lo, a.hi ^ b.hi);
+    }
+
+    inline Maskx16 operator~(const Maskx16 &a) {
+        return Maskx16(~a.lo, ~a.hi);
+    }
+
+    inline uint32_t MoveMask(const Maskx16 &m) {
+        return MoveMask(m.lo) | (MoveMask(m.hi) << 8);
+    }
+
+    // Masked blend, lanes of a where the mask is set and of b elsewhere
+    inline Floatx16 Select(const Maskx16 &m, const Floatx16 &a, const Floatx16 &b) {
+        return Floatx16(Select(m.lo, a.lo, b.lo), Select(m.hi, a.hi, b.hi));
+    }
+
+    // Round to the nearest integer
+    inline Floatx16 Round(const Floatx16 &a) {
+        return Floatx16(Round(a.lo), Round(a.hi));
+    }
+
+    // Split positive normal values in exponent and mantissa in [1, 2)
+    inline Floatx16 Exponent(const Floatx16 &a, Floatx16 *const mantissa) {
+        return Floatx16(Exponent(a.lo, &mantissa->lo), Exponent(a.hi, &mantissa->hi));
+    }
+
+    // Compute 2^i for integer values in [-126, 127]
+    inline Floatx16 Exp2Integer(const Floatx16 &i) {
+        return Floatx16(Exp2Integer(i.lo), Exp2Integer(i.hi));
+    }
+
+#endif
+
+    inline bool Any(const Maskx16 &m) {
+        return MoveMask(m) != 0;
+    }
+
+    inline bool All(const Maskx16 &m) {
+        return MoveMask(m) == 0xFFFF;
+    }
+
+    // Wide versions of FastLog2, FastExp2 and FastPow, same polynomials and accuracy.
+    // F is Floatx8 or Floatx16
+    template <typename F>
+    inline F Log2(const F &x) {
+        // Split x in exponent and mantissa in [sqrt(0.5), sqrt(2))
+        F m;
+        F e = Exponent(x, &m);
+        const auto large = m > F(1.41421356237309505f);
+        m = Select(large, m * F(0.5f), m);
+        e = Select(large, e + F(1.f), e);
+        // Minimax polynomial of log(1 + t) from Cephes
+        const F t = m - F(1.f);
+        const F z = t * t;
+        F p(7.0376836292e-2f);
+        p = MulAdd(p, t, F(-1.1514610310e-1f));
+        p = MulAdd(p, t, F(1.1676998740e-1f));
+        p = MulAdd(p, t, F(-1.2420140846e-1f));
+        p = MulAdd(p, t, F(1.4249322787e-1f));
+        p = MulAdd(p, t, F(-1.6668057665e-1f));
+        p = MulAdd(p, t, F(2.0000714765e-1f));
+        p = MulAdd(p, t, F(-2.4999993993e-1f));
+        p = MulAdd(p, t, F(3.3333331174e-1f));
+        p = p * t * z;
+        const F log_m = t + (p - F(0.5f) * z);
+
+        return MulAdd(log_m, F(1.44269504088896341f), e);
+    }
+
+    template <typename F>
+    inline F Exp2(const F &x) {
+        const F clamped = Min(Max(x, F(-126.f)), F(127.f));
+        // Split in integer part and fraction in [-0.5, 0.5]
+        const F i = Round(clamped);
+        const F f = clamped - i;
+        // Minimax polynomial from Cephes
+        F p(1.535336188319500e-4f);
+        p = MulAdd(p, f, F(1.339887440266574e-3f));
+        p = MulAdd(p, f, F(9.618437357674640e-3f));
+        p = MulAdd(p, f, F(5.550332471162809e-2f));
+        p = MulAdd(p, f, F(2.402264791363012e-1f));
+        p = MulAdd(p, f, F(6.931472028550421e-1f));
+        p = MulAdd(p, f, F(1.f));
+
+        return p * Exp2Integer(i);
+    }
+
+    // Compute x^e, 0 for x <= 0
+    template <typename F>
+    inline F Pow(const F &x, const F &e) {
+        return Select(x > F(0.f), Exp2(e * Log2(x)), F(0.f));
+    }
+
+}
+}
+
+#endif //PIXEL_SIMD_FLOAT_H
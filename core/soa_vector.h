@@ -0,0 +1,268 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2016 simon.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * File:   soa_vector.h
+ * Author: simon
+ *
+ * Created on October 19, 2026, 4:05 PM
+ */
+
+#ifndef PIXEL_SOA_VECTOR_H
+#define PIXEL_SOA_VECTOR_H
+
+#include "pixel.h"
+#include "simd_float.h"
+#include "sse_vector.h"
+#include "sse_matrix.h"
+#include "sse_spectrum.h"
+
+// The types live in the namespace of the wide types, so that kernels built for different instruction sets
+// never share the definition of an inline function
+namespace pixel {
+inline namespace PIXEL_SIMD_NAMESPACE {
+
+    // Define Vec3xN class, N vectors stored as one wide register per component.
+    // F is Floatx8 or Floatx16, M the matching mask type
+    template <typename F, typename M>
+    class Vec3xN {
+    public:
+        // Constructor
+        Vec3xN() = default;
+
+        Vec3xN(const F &x, const F &y, const F &z)
+                : x(x), y(y), z(z) {
+        }
+
+        // Broadcast a vector to all lanes
+        explicit Vec3xN(const SSEVector &v)
+                : x(v.x), y(v.y), z(v.z) {
+        }
+
+        // Load from AoS vectors, w is ignored
+        static inline Vec3xN Load(const SSEVector *const v) {
+            float lanes[3][F::WIDTH];
+            for (uint32_t i = 0; i < F::WIDTH; i++) {
+                lanes[0][i] = v[i].x;
+                lanes[1][i] = v[i].y;
+                lanes[2][i] = v[i].z;
+            }
+
+            return Vec3xN(F::Load(lanes[0]), F::Load(lanes[1]), F::Load(lanes[2]));
+        }
+
+        // Load from SoA arrays of WIDTH values
+        static inline Vec3xN Load(const float *const x, const float *const y, const float *const z) {
+            return Vec3xN(F::Load(x), F::Load(y), F::Load(z));
+        }
+
+        // Load the first count values of SoA arrays, the other lanes are 0
+        static inline Vec3xN LoadMasked(const float *const x, const float *const y, const float *const z,
+                                        uint32_t count) {
+            if (count >= F::WIDTH) {
+                return Load(x, y, z);
+            }
+            float lanes[3][F::WIDTH];
+            for (uint32_t i = 0; i < F::WIDTH; i++) {
+                lanes[0][i] = (i < count) ? x[i] : 0.f;
+                lanes[1][i] = (i < count) ? y[i] : 0.f;
+                lanes[2][i] = (i < count) ? z[i] : 0.f;
+            }
+
+            return Load(lanes[0], lanes[1], lanes[2]);
+        }
+
+        // Store to SoA arrays of WIDTH values
+        inline void Store(float *const x, float *const y, float *const z) const {
+            this->x.Store(x);
+            this->y.Store(y);
+            this->z.Store(z);
+        }
+
+        // Store the first count lanes to SoA arrays, the values past them are left untouched
+        inline void StoreMasked(float *const x, float *const y, float *const z, uint32_t count) const {
+            if (count >= F::WIDTH) {
+                Store(x, y, z);
+                return;
+            }
+            float lanes[3][F::WIDTH];
+            Store(lanes[0], lanes[1], lanes[2]);
+            for (uint32_t i = 0; i < count; i++) {
+                x[i] = lanes[0][i];
+                y[i] = lanes[1][i];
+                z[i] = lanes[2][i];
+            }
+        }
+
+        // Extract a single lane, w is set to the given value
+        inline SSEVector Lane(uint32_t i, float w = 0.f) const {
+            return SSEVector(x[i], y[i], z[i], w);
+        }
+
+        // Components
+        F x, y, z;
+    };
+
+    typedef Vec3xN<Floatx8, Maskx8> Vec3x8;
+    typedef Vec3xN<Floatx16, Maskx16> Vec3x16;
+
+    // Arithmetic
+    template <typename F, typename M>
+    inline Vec3xN<F, M> operator+(const Vec3xN<F, M> &a, const Vec3xN<F, M> &b) {
+        return Vec3xN<F, M>(a.x + b.x, a.y + b.y, a.z + b.z);
+    }
+
+    template <typename F, typename M>
+    inline Vec3xN<F, M> operator-(const Vec3xN<F, M> &a, const Vec3xN<F, M> &b) {
+        return Vec3xN<F, M>(a.x - b.x, a.y - b.y, a.z - b.z);
+    }
+
+    template <typename F, typename M>
+    inline Vec3xN<F, M> operator-(const Vec3xN<F, M> &a) {
+        return Vec3xN<F, M>(-a.x, -a.y, -a.z);
+    }
+
+    template <typename F, typename M>
+    inline Vec3xN<F, M> operator*(const Vec3xN<F, M> &a, const F &s) {
+        return Vec3xN<F, M>(a.x * s, a.y * s, a.z * s);
+    }
+
+    template <typename F, typename M>
+    inline Vec3xN<F, M> operator*(const F &s, const Vec3xN<F, M> &a) {
+        return a * s;
+    }
+
+    // Dot and cross products. The dot product is not fused so that every instruction set gets the same result
+    template <typename F, typename M>
+    inline F DotProduct(const Vec3xN<F, M> &a, const Vec3xN<F, M> &b) {
+        return a.x * b.x + a.y * b.y + a.z * b.z;
+    }
+
+    template <typename F, typename M>
+    inline Vec3xN<F, M> CrossProduct(const Vec3xN<F, M> &a, const Vec3xN<F, M> &b) {
+        return Vec3xN<F, M>(a.y * b.z - a.z * b.y,
+                            a.z * b.x - a.x * b.z,
+                            a.x * b.y - a.y * b.x);
+    }
+
+    // Vector length
+    template <typename F, typename M>
+    inline F Length(const Vec3xN<F, M> &a) {
+        return Sqrt(DotProduct(a, a));
+    }
+
+    template <typename F, typename M>
+    inline F SqrdLength(const Vec3xN<F, M> &a) {
+        return DotProduct(a, a);
+    }
+
+    // Normalize vectors
+    template <typename F, typename M>
+    inline Vec3xN<F, M> Normalize(const Vec3xN<F, M> &a) {
+        return a * (F(1.f) / Length(a));
+    }
+
+    // Masked blend, lanes of a where the mask is set and of b elsewhere
+    template <typename F, typename M>
+    inline Vec3xN<F, M> Select(const M &m, const Vec3xN<F, M> &a, const Vec3xN<F, M> &b) {
+        return Vec3xN<F, M>(Select(m, a.x, b.x), Select(m, a.y, b.y), Select(m, a.z, b.z));
+    }
+
+    // Transform points, vectors and normals by a matrix. Normals need the inverse of the matrix
+    template <typename F, typename M>
+    inline Vec3xN<F, M> TransformPoint(const SSEMatrix &m, const Vec3xN<F, M> &p) {
+        return Vec3xN<F, M>(MulAdd(F(m(0, 0)), p.x, MulAdd(F(m(0, 1)), p.y, MulAdd(F(m(0, 2)), p.z, F(m(0, 3))))),
+                            MulAdd(F(m(1, 0)), p.x, MulAdd(F(m(1, 1)), p.y, MulAdd(F(m(1, 2)), p.z, F(m(1, 3))))),
+                            MulAdd(F(m(2, 0)), p.x, MulAdd(F(m(2, 1)), p.y, MulAdd(F(m(2, 2)), p.z, F(m(2, 3))))));
+    }
+
+    template <typename F, typename M>
+    inline Vec3xN<F, M> TransformVector(const SSEMatrix &m, const Vec3xN<F, M> &v) {
+        return Vec3xN<F, M>(MulAdd(F(m(0, 0)), v.x, MulAdd(F(m(0, 1)), v.y, F(m(0, 2)) * v.z)),
+                            MulAdd(F(m(1, 0)), v.x, MulAdd(F(m(1, 1)), v.y, F(m(1, 2)) * v.z)),
+                            MulAdd(F(m(2, 0)), v.x, MulAdd(F(m(2, 1)), v.y, F(m(2, 2)) * v.z)));
+    }
+
+    template <typename F, typename M>
+    inline Vec3xN<F, M> TransformNormal(const SSEMatrix &inverse, const Vec3xN<F, M> &n) {
+        // Multiply by the transpose of the inverse
+        return Vec3xN<F, M>(MulAdd(F(inverse(0, 0)), n.x, MulAdd(F(inverse(1, 0)), n.y, F(inverse(2, 0)) * n.z)),
+                            MulAdd(F(inverse(0, 1)), n.x, MulAdd(F(inverse(1, 1)), n.y, F(inverse(2, 1)) * n.z)),
+                            MulAdd(F(inverse(0, 2)), n.x, MulAdd(F(inverse(1, 2)), n.y, F(inverse(2, 2)) * n.z)));
+    }
+
+    // Define Spectrumx8 class, 8 spectra stored as one wide register per channel
+    class Spectrumx8 {
+    public:
+        // Constructor
+        Spectrumx8() = default;
+
+        Spectrumx8(const Floatx8 &r, const Floatx8 &g, const Floatx8 &b)
+                : r(r), g(g), b(b) {
+        }
+
+        // Broadcast a spectrum to all lanes
+        explicit Spectrumx8(const SSESpectrum &s)
+                : r(s.r), g(s.g), b(s.b) {
+        }
+
+        // Extract a single lane
+        inline SSESpectrum Lane(uint32_t i) const {
+            return SSESpectrum(r[i], g[i], b[i]);
+        }
+
+        // Channels
+        Floatx8 r, g, b;
+    };
+
+    // Arithmetic
+    inline Spectrumx8 operator+(const Spectrumx8 &a, const Spectrumx8 &b) {
+        return Spectrumx8(a.r + b.r, a.g + b.g, a.b + b.b);
+    }
+
+    inline Spectrumx8 operator-(const Spectrumx8 &a, const Spectrumx8 &b) {
+        return Spectrumx8(a.r - b.r, a.g - b.g, a.b - b.b);
+    }
+
+    inline Spectrumx8 operator*(const Spectrumx8 &a, const Spectrumx8 &b) {
+        return Spectrumx8(a.r * b.r, a.g * b.g, a.b * b.b);
+    }
+
+    inline Spectrumx8 operator*(const Spectrumx8 &a, const Floatx8 &s) {
+        return Spectrumx8(a.r * s, a.g * s, a.b * s);
+    }
+
+    inline Spectrumx8 operator*(const Floatx8 &s, const Spectrumx8 &a) {
+        return a * s;
+    }
+
+    // Masked blend, lanes of a where the mask is set and of b elsewhere
+    inline Spectrumx8 Select(const Maskx8 &m, const Spectrumx8 &a, const Spectrumx8 &b) {
+        return Spectrumx8(Select(m, a.r, b.r), Select(m, a.g, b.g), Select(m, a.b, b.b));
+    }
+
+}
+}
+
+#endif //PIXEL_SOA_VECTOR_H
@@ -23,82 +23,155 @@
  */
 
 #include "sse_matrix.h"
+#include <cassert>
 
 namespace pixel {
 
+    // Products of 2x2 matrices stored row major in a register, A B, adj(A) B and A adj(B)
+    static inline __m128 Mat2Mul(const __m128 &a, const __m128 &b) {
+        return _mm_add_ps(_mm_mul_ps(a, _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 3, 0))),
+                          _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)),
+                                     _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 2, 1, 2))));
+    }
+
+    static inline __m128 Mat2AdjMul(const __m128 &a, const __m128 &b) {
+        return _mm_sub_ps(_mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 3, 3)), b),
+                          _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 1, 1)),
+                                     _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 0, 3, 2))));
+    }
+
+    static inline __m128 Mat2MulAdj(const __m128 &a, const __m128 &b) {
+        return _mm_sub_ps(_mm_mul_ps(a, _mm_shuffle_ps(b, b, _MM_SHUFFLE(0, 3, 0, 3))),
+                          _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)),
+                                     _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 2, 1, 2))));
+    }
+
     SSEMatrix Inverse(const SSEMatrix &m) {
+        // Transforms are almost always affine
+        if (m(3, 0) == 0.f && m(3, 1) == 0.f && m(3, 2) == 0.f && m(3, 3) == 1.f) {
+            return AffineInverse(m);
+        }
 
+        // Blockwise inversion with 2x2 cofactors. The method is written for rows, applying it to the columns
+        // gives the inverse of the transpose whose rows are the columns of the inverse
+        const __m128 a = _mm_movelh_ps(m.xmm[0], m.xmm[1]);
+        const __m128 b = _mm_movehl_ps(m.xmm[1], m.xmm[0]);
+        const __m128 c = _mm_movelh_ps(m.xmm[2], m.xmm[3]);
+        const __m128 d = _mm_movehl_ps(m.xmm[3], m.xmm[2]);
+        // Determinants of the blocks (|A|, |B|, |C|, |D|)
+        const __m128 det_sub = _mm_sub_ps(
+                _mm_mul_ps(_mm_shuffle_ps(m.xmm[0], m.xmm[2], _MM_SHUFFLE(2, 0, 2, 0)),
+                           _mm_shuffle_ps(m.xmm[1], m.xmm[3], _MM_SHUFFLE(3, 1, 3, 1))),
+                _mm_mul_ps(_mm_shuffle_ps(m.xmm[0], m.xmm[2], _MM_SHUFFLE(3, 1, 3, 1)),
+                           _mm_shuffle_ps(m.xmm[1], m.xmm[3], _MM_SHUFFLE(2, 0, 2, 0))));
+        const __m128 det_a = _mm_shuffle_ps(det_sub, det_sub, _MM_SHUFFLE(0, 0, 0, 0));
+        const __m128 det_b = _mm_shuffle_ps(det_sub, det_sub, _MM_SHUFFLE(1, 1, 1, 1));
+        const __m128 det_c = _mm_shuffle_ps(det_sub, det_sub, _MM_SHUFFLE(2, 2, 2, 2));
+        const __m128 det_d = _mm_shuffle_ps(det_sub, det_sub, _MM_SHUFFLE(3, 3, 3, 3));
+        const __m128 d_c = Mat2AdjMul(d, c);
+        const __m128 a_b = Mat2AdjMul(a, b);
+        // Adjugates of the blocks of the inverse
+        __m128 x = _mm_sub_ps(_mm_mul_ps(det_d, a), Mat2Mul(b, d_c));
+        __m128 w = _mm_sub_ps(_mm_mul_ps(det_a, d), Mat2Mul(c, a_b));
+        __m128 y = _mm_sub_ps(_mm_mul_ps(det_b, c), Mat2MulAdj(d, a_b));
+        __m128 z = _mm_sub_ps(_mm_mul_ps(det_c, b), Mat2MulAdj(a, d_c));
+        // |M| = |A| |D| + |B| |C| - tr(adj(A) B adj(D) C)
+        __m128 trace = _mm_mul_ps(a_b, _mm_shuffle_ps(d_c, d_c, _MM_SHUFFLE(3, 1, 2, 0)));
+        trace = _mm_hadd_ps(trace, trace);
+        trace = _mm_hadd_ps(trace, trace);
+        const __m128 det = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(det_a, det_d), _mm_mul_ps(det_b, det_c)), trace);
+        if (_mm_cvtss_f32(det) == 0.f) {
+            std::cerr << "Singular matrix given to inversion procedure" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        const __m128 inv_det = _mm_div_ps(_mm_setr_ps(1.f, -1.f, -1.f, 1.f), det);
+        x = _mm_mul_ps(x, inv_det);
+        y = _mm_mul_ps(y, inv_det);
+        z = _mm_mul_ps(z, inv_det);
+        w = _mm_mul_ps(w, inv_det);
 
-        // Matrix inversion based on the Gauss method
-        int indxc[4], indxr[4];
-        int ipiv[4] = {0, 0, 0, 0};
-        float minv[4][4];
-        memcpy(minv, Transpose(m).data, 16 * sizeof(float));
-        for (int i = 0; i < 4; i++) {
-            int irow = 0, icol = 0;
-            float big = 0.f;
-            // Choose pivot
-            for (int j = 0; j < 4; j++) {
-                if (ipiv[j] != 1) {
-                    for (int k = 0; k < 4; k++) {
-                        if (ipiv[k] == 0) {
-                            if (std::abs(minv[j][k]) >= big) {
-                                big = std::abs(minv[j][k]);
-                                irow = j;
-                                icol = k;
-                            }
-                        } else if (ipiv[k] > 1) {
-                            std::cerr << "Singular matrix given to inversion procedure" << std::endl;
-                            exit(EXIT_FAILURE);
-                        }
-                    }
-                }
-            }
-            ++ipiv[icol];
-            // Swap rows irow_ and icol_ for pivot
-            if (irow != icol) {
-                for (int k = 0; k < 4; ++k) {
-                    std::swap(minv[irow][k], minv[icol][k]);
-                }
-            }
-            indxr[i] = irow;
-            indxc[i] = icol;
-            if (minv[icol][icol] == 0.f) {
-                std::cerr << "Singular matrix given to inversion procedure" << std::endl;
-                exit(EXIT_FAILURE);
-            }
+        // Apply the adjugate shuffle while storing
+        SSEMatrix result;
+        result.xmm[0] = _mm_shuffle_ps(x, y, _MM_SHUFFLE(1, 3, 1, 3));
+        result.xmm[1] = _mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 2, 0, 2));
+        result.xmm[2] = _mm_shuffle_ps(z, w, _MM_SHUFFLE(1, 3, 1, 3));
+        result.xmm[3] = _mm_shuffle_ps(z, w, _MM_SHUFFLE(0, 2, 0, 2));
 
-            // Set $m[icol][icol]$ to one by scaling row _icol_ appropriately
-            float pivinv = 1.f / minv[icol][icol];
-            minv[icol][icol] = 1.f;
-            for (int j = 0; j < 4; j++) {
-                minv[icol][j] *= pivinv;
-            }
+        return result;
+    }
 
-            // Subtract this row from others to zero out their columns
-            for (int j = 0; j < 4; j++) {
-                if (j != icol) {
-                    float save = minv[j][icol];
-                    minv[j][icol] = 0;
-                    for (int k = 0; k < 4; k++) {
-                        minv[j][k] -= minv[icol][k] * save;
-                    }
-                }
-            }
+    // Cross product of the xyz lanes, w is zero
+    static inline __m128 CrossProductSSE(const __m128 &a, const __m128 &b) {
+        const __m128 a_yzx = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+        const __m128 b_yzx = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+        const __m128 c = _mm_sub_ps(_mm_mul_ps(a, b_yzx), _mm_mul_ps(a_yzx, b));
+
+        return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+    }
+
+    SSEMatrix AffineInverse(const SSEMatrix &m) {
+        // Rows of the inverse of the linear part are the cross products of its columns over the determinant
+        const __m128 c0 = _mm_insert_ps(m.xmm[0], m.xmm[0], 0x08);
+        const __m128 c1 = _mm_insert_ps(m.xmm[1], m.xmm[1], 0x08);
+        const __m128 c2 = _mm_insert_ps(m.xmm[2], m.xmm[2], 0x08);
+        __m128 r0 = CrossProductSSE(c1, c2);
+        __m128 r1 = CrossProductSSE(c2, c0);
+        __m128 r2 = CrossProductSSE(c0, c1);
+        const __m128 det = DotProductSSE(c0, r0);
+        if (_mm_cvtss_f32(det) == 0.f) {
+            std::cerr << "Singular matrix given to inversion procedure" << std::endl;
+            exit(EXIT_FAILURE);
         }
-        // Swap columns to reflect permutation
-        for (int j = 3; j >= 0; j--) {
-            if (indxr[j] != indxc[j]) {
-                for (int k = 0; k < 4; k++) {
-                    std::swap(minv[k][indxr[j]], minv[k][indxc[j]]);
-                }
-            }
+        const __m128 inv_det = _mm_div_ps(_mm_set1_ps(1.f), det);
+        r0 = _mm_mul_ps(r0, inv_det);
+        r1 = _mm_mul_ps(r1, inv_det);
+        r2 = _mm_mul_ps(r2, inv_det);
+        __m128 r3 = _mm_setzero_ps();
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+        // The translation is moved back by the inverse linear part
+        const __m128 t = m.xmm[3];
+        __m128 translation = _mm_mul_ps(r0, _mm_shuffle_ps(t, t, _MM_SHUFFLE(0, 0, 0, 0)));
+        translation = _mm_add_ps(translation, _mm_mul_ps(r1, _mm_shuffle_ps(t, t, _MM_SHUFFLE(1, 1, 1, 1))));
+        translation = _mm_add_ps(translation, _mm_mul_ps(r2, _mm_shuffle_ps(t, t, _MM_SHUFFLE(2, 2, 2, 2))));
+
+        SSEMatrix result;
+        result.xmm[0] = r0;
+        result.xmm[1] = r1;
+        result.xmm[2] = r2;
+        result.xmm[3] = _mm_sub_ps(_mm_setr_ps(0.f, 0.f, 0.f, 1.f), translation);
+
+        return result;
+    }
+
+    void TransformPoints(const SSEMatrix &m, const SSEVector *const in, SSEVector *const out, size_t n) {
+        assert(m(3, 0) == 0.f && m(3, 1) == 0.f && m(3, 2) == 0.f && m(3, 3) == 1.f);
+        for (size_t i = 0; i < n; i++) {
+            const __m128 v = in[i].xmm;
+            // Same order of operations as the product with a single vector
+            __m128 r = _mm_mul_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)), m.xmm[0]);
+            r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)), m.xmm[1]));
+            r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2)), m.xmm[2]));
+            out[i].xmm = _mm_add_ps(r, m.xmm[3]);
         }
+    }
+
+    void TransformVectors(const SSEMatrix &m, const SSEVector *const in, SSEVector *const out, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            const __m128 v = in[i].xmm;
+            __m128 r = _mm_mul_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)), m.xmm[0]);
+            r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)), m.xmm[1]));
+            out[i].xmm = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2)), m.xmm[2]));
+        }
+    }
 
-        return SSEMatrix(minv[0][0], minv[0][1], minv[0][2], minv[0][3],
-                         minv[1][0], minv[1][1], minv[1][2], minv[1][3],
-                         minv[2][0], minv[2][1], minv[2][2], minv[2][3],
-                         minv[3][0], minv[3][1], minv[3][2], minv[3][3]);
+    void TransformNormals(const SSEMatrix &inverse, const SSEVector *const in, SSEVector *const out, size_t n) {
+        // Normals are transformed by the transpose of the inverse, w is cleared
+        SSEMatrix normal_matrix = Transpose(inverse);
+        normal_matrix.xmm[0] = _mm_insert_ps(normal_matrix.xmm[0], normal_matrix.xmm[0], 0x08);
+        normal_matrix.xmm[1] = _mm_insert_ps(normal_matrix.xmm[1], normal_matrix.xmm[1], 0x08);
+        normal_matrix.xmm[2] = _mm_insert_ps(normal_matrix.xmm[2], normal_matrix.xmm[2], 0x08);
+        TransformVectors(normal_matrix, in, out, n);
     }
 
     void PrintSSEMatrix(const SSEMatrix &m) {
@@ -202,6 +202,29 @@ namespace pixel {
     // Compute matrix inverse
     SSEMatrix Inverse(const SSEMatrix &m);
 
+    // Compute the inverse of a matrix whose last row is (0, 0, 0, 1)
+    SSEMatrix AffineInverse(const SSEMatrix &m);
+
+    // Transform a normal by the transpose of the inverse of a matrix, w is set to zero
+    inline SSEVector TransformNormal(const SSEMatrix &inverse, const SSEVector &n) {
+        __m128 x = _mm_mul_ps(inverse.xmm[0], n.xmm);
+        __m128 y = _mm_mul_ps(inverse.xmm[1], n.xmm);
+        __m128 z = _mm_mul_ps(inverse.xmm[2], n.xmm);
+        __m128 w = _mm_setzero_ps();
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+
+        return SSEVector(_mm_add_ps(_mm_add_ps(_mm_add_ps(x, y), z), w));
+    }
+
+    // Transform arrays of points, vectors and normals in one pass, in and out can be the same array.
+    // Points get w = 1 from the matrix, which must be affine as there is no division by w. Vectors and normals
+    // keep w = 0, normals need the inverse matrix
+    void TransformPoints(const SSEMatrix &m, const SSEVector *in, SSEVector *out, size_t n);
+
+    void TransformVectors(const SSEMatrix &m, const SSEVector *in, SSEVector *out, size_t n);
+
+    void TransformNormals(const SSEMatrix &inverse, const SSEVector *in, SSEVector *out, size_t n);
+
     // Transpose matrix
     inline SSEMatrix Transpose(const SSEMatrix &m) {
         return SSEMatrix(m.data[0][0], m.data[0][1], m.data[0][2], m.data[0][3],
@@ -33,7 +33,9 @@
 #define SSE_SPECTRUM_H
 
 #include "pixel.h"
+#include "fast_math.h"
 #include <immintrin.h>
+#include <algorithm>
 
 namespace pixel {
 
@@ -177,9 +179,24 @@ namespace pixel {
         return (s.r == 0.f && s.g == 0.f && s.b == 0.f);
     }
 
+    // Largest color component
+    inline float MaxComponent(const SSESpectrum &s) {
+        return std::max(s.r, std::max(s.g, s.b));
+    }
+
+    // Luminance of a linear RGB spectrum
+    inline float Luminance(const SSESpectrum &s) {
+        return 0.2126f * s.r + 0.7152f * s.g + 0.0722f * s.b;
+    }
+
     // Spectrum power function
     inline SSESpectrum Pow(const SSESpectrum &s, float e) {
+#ifdef PIXEL_FAST_MATH
+        // All channels at once, the unused one stays 0
+        return SSESpectrum(FastPow(s.xmm, _mm_set1_ps(e)));
+#else
         return SSESpectrum(std::pow(s.r, e), std::pow(s.g, e), std::pow(s.b, e));
+#endif
     }
 
     // Print spectrum
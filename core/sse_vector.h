@@ -34,6 +34,7 @@
 
 #include <immintrin.h>
 #include "pixel.h"
+#include "fast_math.h"
 
 namespace pixel {
 
@@ -164,45 +165,48 @@ namespace pixel {
         return _mm_div_ps(v.xmm, _mm_set1_ps(s));
     }
 
-    // SSE dot product
-#define _MM_DOT(c0, c1, c2, c3, r0, r1, r2, r3) \
-        (((c3)<<7) | ((c2)<<6) | ((c1)<<5) | ((c0)<<4) | ((r3)<<3) | ((r2)<<2) | ((r1)<<1) | r0)
+    // Sum the lanes of a register, broadcasting the result. Shuffles are cheaper than _mm_dp_ps
+    // and add the lanes in the same order, (x + y) + (z + w)
+    inline __m128 HorizontalSumSSE(const __m128 &xmm) {
+        const __m128 pairs = _mm_add_ps(xmm, _mm_shuffle_ps(xmm, xmm, _MM_SHUFFLE(2, 3, 0, 1)));
 
-#define _MM_FULL_DOT _MM_DOT(1,1,1,1,1,1,1,1)
+        return _mm_add_ps(pairs, _mm_shuffle_ps(pairs, pairs, _MM_SHUFFLE(1, 0, 3, 2)));
+    }
 
+    // SSE dot product
     inline __m128 DotProductSSE(const SSEVector &v1, const SSEVector &v2) {
-        return _mm_dp_ps(v1.xmm, v2.xmm, _MM_FULL_DOT);
+        return HorizontalSumSSE(_mm_mul_ps(v1.xmm, v2.xmm));
     }
 
     inline __m128 DotProductSSE(const SSEVector &v, const __m128 &xmm) {
-        return _mm_dp_ps(v.xmm, xmm, _MM_FULL_DOT);
+        return HorizontalSumSSE(_mm_mul_ps(v.xmm, xmm));
     }
 
     inline __m128 DotProductSSE(const __m128 &xmm, const SSEVector &v) {
-        return _mm_dp_ps(xmm, v.xmm, _MM_FULL_DOT);
+        return HorizontalSumSSE(_mm_mul_ps(xmm, v.xmm));
     }
 
     inline __m128 DotProductSSE(const __m128 &xmm1, const __m128 &xmm2) {
-        return _mm_dp_ps(xmm1, xmm2, _MM_FULL_DOT);
+        return HorizontalSumSSE(_mm_mul_ps(xmm1, xmm2));
     }
 
     // SSE abs dot product
     static const __m128 SIGN_MASK = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
 
     inline __m128 AbsDotProductSSE(const SSEVector &v1, const SSEVector &v2) {
-        return _mm_andnot_ps(SIGN_MASK, _mm_dp_ps(v1.xmm, v2.xmm, _MM_FULL_DOT));
+        return _mm_andnot_ps(SIGN_MASK, DotProductSSE(v1, v2));
     }
 
     inline __m128 AbsDotProductSSE(const SSEVector &v, const __m128 &xmm) {
-        return _mm_andnot_ps(SIGN_MASK, _mm_dp_ps(v.xmm, xmm, _MM_FULL_DOT));
+        return _mm_andnot_ps(SIGN_MASK, DotProductSSE(v, xmm));
     }
 
     inline __m128 AbsDotProductSSE(const __m128 &xmm, const SSEVector &v) {
-        return _mm_andnot_ps(SIGN_MASK, _mm_dp_ps(xmm, v.xmm, _MM_FULL_DOT));
+        return _mm_andnot_ps(SIGN_MASK, DotProductSSE(xmm, v));
     }
 
     inline __m128 AbsDotProductSSE(const __m128 &xmm1, const __m128 &xmm2) {
-        return _mm_andnot_ps(SIGN_MASK, _mm_dp_ps(xmm1, xmm2, _MM_FULL_DOT));
+        return _mm_andnot_ps(SIGN_MASK, DotProductSSE(xmm1, xmm2));
     }
 
     // Normal dot product
@@ -293,12 +297,18 @@ namespace pixel {
 
     // Compute spherical direction
     inline SSEVector SphericalDirection(float sin_theta, float cos_theta, float phi) {
-        return SSEVector(std::cos(phi) * sin_theta, cos_theta, std::sin(phi) * sin_theta, 0.f);
+        float sin_phi, cos_phi;
+        SinCos(phi, &sin_phi, &cos_phi);
+
+        return SSEVector(cos_phi * sin_theta, cos_theta, sin_phi * sin_theta, 0.f);
     }
 
     inline SSEVector SphericalDirection(float sin_theta, float cos_theta, float phi,
                                         const SSEVector &u, const SSEVector &v, const SSEVector &w) {
-        return (std::cos(phi) * sin_theta * u + cos_theta * v + std::sin(phi) * sin_theta * w);
+        float sin_phi, cos_phi;
+        SinCos(phi, &sin_phi, &cos_phi);
+
+        return (cos_phi * sin_theta * u + cos_theta * v + sin_phi * sin_theta * w);
     }
 
     // Print vector
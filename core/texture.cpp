@@ -31,9 +31,13 @@ namespace pixel {
             : su(su), sv(sv), du(du), dv(dv) {
     }
 
-    void UVMapping2D::Map(const SurfaceInteraction &interaction, float *u, float *v) const {
-        *u = interaction.u * su + du;
-        *v = interaction.v * sv + dv;
+    void UVMapping2D::Map(const SurfaceInteraction &interaction, TextureCoordinates *const coords) const {
+        coords->u = interaction.u * su + du;
+        coords->v = interaction.v * sv + dv;
+        coords->dudx = interaction.dudx * su;
+        coords->dvdx = interaction.dvdx * sv;
+        coords->dudy = interaction.dudy * su;
+        coords->dvdy = interaction.dvdy * sv;
     }
 
 }
\ No newline at end of file
@@ -45,6 +45,17 @@ namespace pixel {
 
         // Evaluate texture at given SurfaceInteraction
         virtual T Evaluate(const SurfaceInteraction &interaction) const = 0;
+
+        // True if the texture has the same value everywhere, materials then evaluate it once per group of hits
+        virtual bool IsConstant() const {
+            return false;
+        }
+    };
+
+    // Texture coordinates and their variation between neighbor pixels, which give the filter footprint
+    struct TextureCoordinates {
+        float u, v;
+        float dudx, dvdx, dudy, dvdy;
     };
 
     // Texture mapping base class
@@ -53,8 +64,8 @@ namespace pixel {
         // Destructor
         virtual ~TextureMapping2DInterface() {}
 
-        // Map UV coordinates
-        virtual void Map(const SurfaceInteraction &interaction, float *u, float *v) const = 0;
+        // Map UV coordinates and their differentials
+        virtual void Map(const SurfaceInteraction &interaction, TextureCoordinates *const coords) const = 0;
     };
 
     // Uv texture mapping
@@ -62,7 +73,7 @@ namespace pixel {
     public:
         UVMapping2D(float su, float sv, float du, float dv);
 
-        void Map(const SurfaceInteraction &interaction, float *u, float *v) const override;
+        void Map(const SurfaceInteraction &interaction, TextureCoordinates *const coords) const override;
 
     private:
         // Scaling
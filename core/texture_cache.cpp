@@ -0,0 +1,112 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2016 simon.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "texture_cache.h"
+#include <cstdlib>
+
+namespace pixel {
+
+    TextureCache::TextureCache(size_t max_bytes)
+            : shard_limit(max_bytes / N_SHARDS), next_id(0), hits(0), misses(0) {
+    }
+
+    void TextureCache::Shard::Evict(size_t max_bytes) {
+        while (bytes > max_bytes && lru.size() > 1) {
+            bytes -= lru.back().second->bytes;
+            tiles.erase(lru.back().first);
+            lru.pop_back();
+        }
+    }
+
+    std::shared_ptr<const TextureTile> TextureCache::Find(uint64_t key) {
+        Shard &shard = ShardOf(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        const auto it = shard.tiles.find(key);
+        if (it == shard.tiles.end()) {
+            misses.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        hits.fetch_add(1, std::memory_order_relaxed);
+        // Move the tile to the front of the list
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+
+        return it->second->second;
+    }
+
+    std::shared_ptr<const TextureTile> TextureCache::Insert(uint64_t key,
+                                                            const std::shared_ptr<const TextureTile> &tile) {
+        Shard &shard = ShardOf(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        const auto it = shard.tiles.find(key);
+        if (it != shard.tiles.end()) {
+            shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+            return it->second->second;
+        }
+        shard.lru.emplace_front(key, tile);
+        shard.tiles[key] = shard.lru.begin();
+        shard.bytes += tile->bytes;
+        shard.Evict(shard_limit);
+
+        return tile;
+    }
+
+    void TextureCache::SetMemoryLimit(size_t max_bytes) {
+        shard_limit = max_bytes / N_SHARDS;
+        for (Shard &shard : shards) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.Evict(shard_limit);
+        }
+    }
+
+    uint32_t TextureCache::NewTextureId() {
+        return next_id++;
+    }
+
+    size_t TextureCache::MemoryUsed() const {
+        size_t bytes = 0;
+        for (const Shard &shard : shards) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            bytes += shard.bytes;
+        }
+
+        return bytes;
+    }
+
+    // Cache limit from the environment, in bytes
+    static size_t DefaultCacheLimit() {
+        const char *const limit = std::getenv("PIXEL_TEXTURE_CACHE_MB");
+        if (limit != nullptr && std::atol(limit) > 0) {
+            return static_cast<size_t>(std::atol(limit)) << 20;
+        }
+
+        return static_cast<size_t>(256) << 20;
+    }
+
+    TextureCache &GlobalTextureCache() {
+        static TextureCache cache(DefaultCacheLimit());
+
+        return cache;
+    }
+
+}
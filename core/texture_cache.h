@@ -0,0 +1,120 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2016 simon.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * File:   texture_cache.h
+ * Author: simon
+ *
+ * Created on October 19, 2026, 9:05 PM
+ */
+
+#ifndef PIXEL_TEXTURE_CACHE_H
+#define PIXEL_TEXTURE_CACHE_H
+
+#include "pixel.h"
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace pixel {
+
+    // Block of texels loaded from a tiled texture file, three floats per texel
+    struct TextureTile {
+        TextureTile(uint32_t n_texels) : texels(new float[3 * n_texels]), bytes(3 * n_texels * sizeof(float)) {}
+
+        std::unique_ptr<float[]> texels;
+        size_t bytes;
+    };
+
+    // Cache of texture tiles shared by all the image textures, bounded by a memory limit. Tiles are spread
+    // over shards by key, each one with its own lock and least recently used list, so that threads looking
+    // up different tiles rarely contend. Tiles are handed out by shared pointer, an evicted tile stays valid
+    // for the lookups still using it
+    class TextureCache {
+    public:
+        TextureCache(size_t max_bytes);
+
+        // Find a tile, returns null when it is not resident
+        std::shared_ptr<const TextureTile> Find(uint64_t key);
+
+        // Insert a loaded tile and evict the least recently used ones above the limit. If another thread
+        // inserted the same tile in the meantime, that one is returned instead
+        std::shared_ptr<const TextureTile> Insert(uint64_t key, const std::shared_ptr<const TextureTile> &tile);
+
+        // Change the memory limit, evicting tiles if needed
+        void SetMemoryLimit(size_t max_bytes);
+
+        // Unique identifier for a texture, used to build the tile keys
+        uint32_t NewTextureId();
+
+        // Memory used by the resident tiles
+        size_t MemoryUsed() const;
+
+        // Statistics
+        uint64_t Hits() const { return hits; }
+
+        uint64_t Misses() const { return misses; }
+
+        // Key of a tile. Texture ids use 27 bits, levels 5 bits and tile coordinates 16 bits each
+        static uint64_t TileKey(uint32_t texture_id, uint32_t level, uint32_t x, uint32_t y) {
+            return (static_cast<uint64_t>(texture_id) << 37) | (static_cast<uint64_t>(level) << 32) |
+                   (static_cast<uint64_t>(y) << 16) | x;
+        }
+
+    private:
+        static const uint32_t N_SHARDS = 16;
+
+        struct Shard {
+            typedef std::pair<uint64_t, std::shared_ptr<const TextureTile>> Entry;
+
+            mutable std::mutex mutex;
+            // Most recently used tile first
+            std::list<Entry> lru;
+            std::unordered_map<uint64_t, std::list<Entry>::iterator> tiles;
+            size_t bytes = 0;
+
+            // Evict tiles from the back until the shard fits, the most recent one is always kept
+            void Evict(size_t max_bytes);
+        };
+
+        Shard &ShardOf(uint64_t key) {
+            // Mix the key so that neighbor tiles land on different shards
+            return shards[((key * 0x9E3779B97F4A7C15ULL) >> 60) % N_SHARDS];
+        }
+
+        Shard shards[N_SHARDS];
+        std::atomic<size_t> shard_limit;
+        std::atomic<uint32_t> next_id;
+        std::atomic<uint64_t> hits, misses;
+    };
+
+    // Cache used by the image textures, its limit defaults to 256 MB or to the PIXEL_TEXTURE_CACHE_MB
+    // environment variable
+    TextureCache &GlobalTextureCache();
+
+}
+
+#endif //PIXEL_TEXTURE_CACHE_H
@@ -22,43 +22,42 @@
  * THE SOFTWARE.
  */
 
-#include <cstdlib>
 #include "box_film.h"
 
 namespace pixel {
 
-    BoxFilterFilm::BoxFilterFilm(uint32_t w, uint32_t h)
-            : Film(w, h) {
-        raster = reinterpret_cast<SSESpectrum *> (malloc(w * h * sizeof(SSESpectrum)));
-        num_samples = reinterpret_cast<uint32_t *> (malloc(w * h * sizeof(uint32_t)));
-    }
+    // Planes of the raster
+    enum RasterPlane : uint32_t {
+        RASTER_R, RASTER_G, RASTER_B, RASTER_SAMPLES, NUM_RASTER_PLANES
+    };
 
-    BoxFilterFilm::~BoxFilterFilm() {
-        free(reinterpret_cast<void *> (raster));
-        free(reinterpret_cast<void *> (num_samples));
+    BoxFilterFilm::BoxFilterFilm(uint32_t w, uint32_t h)
+            : Film(w, h), raster(NUM_RASTER_PLANES, w * h) {
     }
 
     bool BoxFilterFilm::AddSample(const SSESpectrum &s, float x, float y) {
         // Check pixel coordinates
-        if (x < 0.0 || static_cast<uint32_t> (x) > width ||
-            y < 0.0 || static_cast<uint32_t> (y) > height) {
+        if (!(x >= 0.f && y >= 0.f) || static_cast<uint32_t>(x) >= width || static_cast<uint32_t>(y) >= height) {
             return false;
         }
         // Find pixel index
-        uint32_t i = static_cast<uint32_t> (x);
-        uint32_t j = static_cast<uint32_t> (y);
+        const uint32_t p = static_cast<uint32_t>(y) * width + static_cast<uint32_t>(x);
         // Add spectrum value
-        raster[j * width + i] += s;
-
+        raster.Floats(RASTER_R)[p] += s.r;
+        raster.Floats(RASTER_G)[p] += s.g;
+        raster.Floats(RASTER_B)[p] += s.b;
         // Increase number of samples of that pixel
-        num_samples[j * width + i]++;
+        raster.Floats(RASTER_SAMPLES)[p] += 1.f;
 
         return true;
     }
 
     SSESpectrum BoxFilterFilm::GetSpectrum(uint32_t i, uint32_t j) const {
-        return SSESpectrum(raster[j * width + i] / static_cast<float> (num_samples[j * width + i]));
-    }
+        const uint32_t p = j * width + i;
+        const float samples = raster.Floats(RASTER_SAMPLES)[p];
+        const SSESpectrum sum(raster.Floats(RASTER_R)[p], raster.Floats(RASTER_G)[p], raster.Floats(RASTER_B)[p]);
 
+        return SSESpectrum(sum / samples + GetSplat(i, j));
+    }
 
 }
@@ -33,6 +33,7 @@
 #define BOX_FILM_H
 
 #include "film.h"
+#include "film_planes.h"
 
 namespace pixel {
 
@@ -42,9 +43,6 @@ namespace pixel {
         // Constructor
         BoxFilterFilm(uint32_t w, uint32_t h);
 
-        // Destructor
-        ~BoxFilterFilm();
-
         // Add sample to the film
         bool AddSample(const SSESpectrum &s, float x, float y) override;
 
@@ -52,10 +50,8 @@ namespace pixel {
         SSESpectrum GetSpectrum(uint32_t i, uint32_t j) const override;
 
     private:
-        // Unnormalized samples
-        SSESpectrum *raster;
-        // Number of samples added per-pixel
-        uint32_t *num_samples;
+        // Planes of the unnormalized red, green and blue samples, and of the number of samples of each pixel
+        FilmPlanes raster;
     };
 }
 
@@ -0,0 +1,52 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2016 simon.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "image_film.h"
+
+namespace pixel {
+
+    ImageFilm::ImageFilm(uint32_t w, uint32_t h, FILM_STORAGE storage)
+            : Film(w, h), raster(3, w * h, storage) {
+    }
+
+    bool ImageFilm::AddSample(const SSESpectrum &s, float x, float y) {
+        // Check pixel coordinates
+        if (!(x >= 0.f && y >= 0.f) || static_cast<uint32_t>(x) >= width || static_cast<uint32_t>(y) >= height) {
+            return false;
+        }
+        const uint32_t p = static_cast<uint32_t>(y) * width + static_cast<uint32_t>(x);
+        raster.Set(0, p, s.r);
+        raster.Set(1, p, s.g);
+        raster.Set(2, p, s.b);
+
+        return true;
+    }
+
+    SSESpectrum ImageFilm::GetSpectrum(uint32_t i, uint32_t j) const {
+        const uint32_t p = j * width + i;
+
+        return SSESpectrum(SSESpectrum(raster.Get(0, p), raster.Get(1, p), raster.Get(2, p)) + GetSplat(i, j));
+    }
+
+}
@@ -0,0 +1,60 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2016 simon.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * File:   image_film.h
+ * Author: simon
+ *
+ * Created on October 20, 2026, 3:10 AM
+ */
+
+#ifndef PIXEL_IMAGE_FILM_H
+#define PIXEL_IMAGE_FILM_H
+
+#include "film.h"
+#include "film_planes.h"
+
+namespace pixel {
+
+    // Define image film class, which holds a finished image such as the output of the denoiser. A sample
+    // replaces the color of its pixel, stored as planar floats or halves
+    class ImageFilm : public Film {
+    public:
+        // Constructor
+        ImageFilm(uint32_t w, uint32_t h, FILM_STORAGE storage = STORAGE_FLOAT);
+
+        // Set the color of the pixel of the sample
+        bool AddSample(const SSESpectrum &s, float x, float y) override;
+
+        // Get film color at a given coordinate
+        SSESpectrum GetSpectrum(uint32_t i, uint32_t j) const override;
+
+    private:
+        // Planes of the red, green and blue pixel colors
+        FilmPlanes raster;
+    };
+
+}
+
+#endif //PIXEL_IMAGE_FILM_H
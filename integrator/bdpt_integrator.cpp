@@ -0,0 +1,492 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2016 simon.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "bdpt_integrator.h"
+#include "interaction.h"
+#include "scene.h"
+#include "ray.h"
+#include "light.h"
+#include "camera.h"
+#include "film.h"
+#include "scattering.h"
+#include "montecarlo.h"
+
+namespace pixel {
+
+    // Pdf of sampling a direction toward the lights at infinity, the light sampled being chosen uniformly
+    static float InfiniteLightPdf(const Scene &scene, const SurfaceInteraction &from, const SSEVector &wi) {
+        const std::vector<const LightInterface *> &lights = scene.GetLights();
+        float pdf = 0.f;
+        for (const LightInterface *light : lights) {
+            if (light->IsInfiniteLight()) {
+                pdf += light->Pdf_Li(from, wi);
+            }
+        }
+
+        return pdf / lights.size();
+    }
+
+    float BDPTIntegrator::Vertex::ConvertDensity(float pdf, const Vertex &next) const {
+        // Vertices at infinity are sampled by direction
+        if (next.infinite) {
+            return pdf;
+        }
+        const SSEVector w = next.p - p;
+        const float distance_2 = SqrdLength(w);
+        if (distance_2 == 0.f) {
+            return 0.f;
+        }
+        if (next.IsOnSurface()) {
+            pdf *= AbsDotProduct(next.n, w) / std::sqrt(distance_2);
+        }
+
+        return pdf / distance_2;
+    }
+
+    float BDPTIntegrator::Vertex::Pdf(const Vertex *const prev, const Vertex &next) const {
+        if (type == LIGHT_VERTEX) {
+            return PdfLight(next);
+        }
+        const SSEVector wn = Normalize(next.p - p);
+        float pdf;
+        if (type == CAMERA_VERTEX) {
+            float pdf_pos;
+            camera->Pdf_We(Ray(p, wn), &pdf_pos, &pdf);
+        } else {
+            pdf = interaction->bsdf->Pdf(Normalize(prev->p - p), wn);
+        }
+
+        return ConvertDensity(pdf, next);
+    }
+
+    float BDPTIntegrator::Vertex::PdfLight(const Vertex &next) const {
+        // Lights at infinity do not start light subpaths
+        if (!light) {
+            return 0.f;
+        }
+        SSEVector w = next.p - p;
+        const float inv_distance_2 = 1.f / SqrdLength(w);
+        w *= std::sqrt(inv_distance_2);
+        float pdf_pos, pdf_dir;
+        light->Pdf_Le(Ray(p, w), n, &pdf_pos, &pdf_dir);
+        float pdf = pdf_dir * inv_distance_2;
+        if (next.IsOnSurface()) {
+            pdf *= AbsDotProduct(next.n, w);
+        }
+
+        return pdf;
+    }
+
+    float BDPTIntegrator::Vertex::PdfLightOrigin(const Scene &scene, const Vertex &next) const {
+        if (!light) {
+            return 0.f;
+        }
+        float pdf_pos, pdf_dir;
+        light->Pdf_Le(Ray(p, Normalize(next.p - p)), n, &pdf_pos, &pdf_dir);
+
+        return pdf_pos / scene.GetLights().size();
+    }
+
+    SSESpectrum BDPTIntegrator::Vertex::f(const Vertex &next) const {
+        return interaction->bsdf->f(wo, Normalize(next.p - p));
+    }
+
+    bool BDPTIntegrator::Vertex::IsConnectible() const {
+        return type != SURFACE_VERTEX ||
+               interaction->bsdf->NumMatchingBRDF(BRDF_TYPE(ALL_BRDF & ~BRDF_SPECULAR)) > 0;
+    }
+
+    bool BDPTIntegrator::Vertex::IsOnSurface() const {
+        return n.x != 0.f || n.y != 0.f || n.z != 0.f;
+    }
+
+    BDPTIntegrator::BDPTIntegrator(const std::shared_ptr<const CameraInterface> &camera,
+                                   const std::shared_ptr<Film> &film, uint32_t max_depth)
+            : camera(camera), film(film), max_depth(max_depth) {
+        film->EnableSplats();
+    }
+
+    void BDPTIntegrator::Preprocess(const Scene &) const {
+    }
+
+    uint32_t BDPTIntegrator::RandomWalk(const Scene &scene, Ray ray, SSESpectrum beta, float pdf,
+                                        uint32_t max_vertices, bool from_camera, Vertex *const path,
+                                        SurfaceInteraction *const interactions, RandomGenerator *const rng) const {
+        uint32_t bounces = 0;
+        float pdf_fwd = pdf;
+        while (bounces < max_vertices) {
+            Vertex &vertex = path[bounces];
+            Vertex &prev = *(path + bounces - 1);
+            SurfaceInteraction &interaction = interactions[bounces];
+            if (!scene.Intersect(ray, &interaction)) {
+                // Paths from the camera end on the lights at infinity
+                if (from_camera) {
+                    vertex.type = LIGHT_VERTEX;
+                    vertex.beta = beta;
+                    vertex.p = SSEVector(ray.Origin() + Normalize(ray.Direction()));
+                    vertex.n = SSEVector(0.f, 0.f, 0.f, 0.f);
+                    vertex.interaction = nullptr;
+                    vertex.light = nullptr;
+                    vertex.camera = nullptr;
+                    vertex.delta = false;
+                    vertex.infinite = true;
+                    vertex.pdf_fwd = pdf_fwd;
+                    vertex.pdf_rev = 0.f;
+                    bounces++;
+                }
+                break;
+            }
+            interaction.GenerateBSDF();
+            vertex.type = SURFACE_VERTEX;
+            vertex.beta = beta;
+            vertex.p = interaction.hit_point;
+            vertex.n = interaction.normal;
+            vertex.wo = Normalize(-ray.Direction());
+            vertex.interaction = &interaction;
+            vertex.light = dynamic_cast<const LightInterface *>(interaction.prim_ptr);
+            vertex.camera = nullptr;
+            vertex.delta = false;
+            vertex.infinite = false;
+            vertex.pdf_fwd = prev.ConvertDensity(pdf_fwd, vertex);
+            vertex.pdf_rev = 0.f;
+            if (++bounces == max_vertices) {
+                break;
+            }
+            // Sample the BSDF. The radiance scaling of refraction is applied to importance too, which cancels
+            // out for paths leaving the closed dielectrics they enter
+            SSEVector wi;
+            BRDF_TYPE brdf_type;
+            const SSESpectrum f = interaction.bsdf->Sample_f(vertex.wo, &wi, &pdf_fwd, (*rng)(), (*rng)(), ALL_BRDF,
+                                                             &brdf_type);
+            if (IsBlack(f) || pdf_fwd == 0.f) {
+                break;
+            }
+            float pdf_rev = interaction.bsdf->Pdf(wi, vertex.wo);
+            const bool specular = (brdf_type & BRDF_SPECULAR) != 0;
+            beta *= f * ((specular ? 1.f : AbsDotProduct(wi, vertex.n)) / pdf_fwd);
+            // Specular bounces are skipped by the MIS weights
+            if (specular) {
+                vertex.delta = true;
+                pdf_fwd = pdf_rev = 0.f;
+            }
+            prev.pdf_rev = vertex.ConvertDensity(pdf_rev, prev);
+            ray = interaction.SpawnRay(wi);
+        }
+
+        return bounces;
+    }
+
+    uint32_t BDPTIntegrator::CameraSubpath(const Ray &ray, const Scene &scene, Vertex *const path,
+                                           SurfaceInteraction *const interactions,
+                                           RandomGenerator *const rng) const {
+        Vertex &vertex = path[0];
+        vertex.type = CAMERA_VERTEX;
+        vertex.beta = SSESpectrum(1.f);
+        vertex.p = ray.Origin();
+        vertex.n = SSEVector(0.f, 0.f, 0.f, 0.f);
+        vertex.interaction = nullptr;
+        vertex.light = nullptr;
+        vertex.camera = camera.get();
+        vertex.delta = false;
+        vertex.infinite = false;
+        vertex.pdf_fwd = vertex.pdf_rev = 0.f;
+        float pdf_pos, pdf_dir;
+        camera->Pdf_We(ray, &pdf_pos, &pdf_dir);
+
+        return RandomWalk(scene, ray, vertex.beta, pdf_dir, max_depth + 1, true, path + 1, interactions + 1,
+                          rng) + 1;
+    }
+
+    uint32_t BDPTIntegrator::LightSubpath(const Scene &scene, Vertex *const path,
+                                          SurfaceInteraction *const interactions, RandomGenerator *const rng) const {
+        const std::vector<const LightInterface *> &lights = scene.GetLights();
+        if (lights.empty()) {
+            return 0;
+        }
+        // Choose a light uniformly
+        const uint32_t index = std::min(static_cast<uint32_t>((*rng)() * lights.size()),
+                                        static_cast<uint32_t>(lights.size() - 1));
+        const float light_pdf = 1.f / lights.size();
+        const LightInterface *const light = lights[index];
+        // Sample a ray leaving it
+        const float u1 = (*rng)();
+        const float u2 = (*rng)();
+        const float u3 = (*rng)();
+        const float u4 = (*rng)();
+        Ray ray(SSEVector(0.f, 0.f, 0.f, 1.f), SSEVector(0.f, 1.f, 0.f, 0.f));
+        SSEVector normal;
+        float pdf_pos, pdf_dir;
+        const SSESpectrum Le = light->Sample_Le(u1, u2, u3, u4, &ray, &normal, &pdf_pos, &pdf_dir);
+        if (pdf_pos == 0.f || pdf_dir == 0.f || IsBlack(Le)) {
+            return 0;
+        }
+        Vertex &vertex = path[0];
+        vertex.type = LIGHT_VERTEX;
+        vertex.beta = Le;
+        vertex.p = ray.Origin();
+        vertex.n = normal;
+        vertex.interaction = nullptr;
+        vertex.light = light;
+        vertex.camera = nullptr;
+        vertex.delta = false;
+        vertex.infinite = false;
+        vertex.pdf_fwd = pdf_pos * light_pdf;
+        vertex.pdf_rev = 0.f;
+        const float cos_theta = vertex.IsOnSurface() ? AbsDotProduct(normal, ray.Direction()) : 1.f;
+        const SSESpectrum beta(Le * (cos_theta / (light_pdf * pdf_pos * pdf_dir)));
+
+        return RandomWalk(scene, ray, beta, pdf_dir, max_depth, false, path + 1, interactions + 1, rng) + 1;
+    }
+
+    SSESpectrum BDPTIntegrator::Connect(uint32_t s, uint32_t t, const Scene &scene, Vertex *const light_vertices,
+                                        Vertex *const camera_vertices, float *const raster_x,
+                                        float *const raster_y, RandomGenerator *const rng) const {
+        const Vertex &pt = camera_vertices[t - 1];
+        // Vertices at infinity end camera subpaths, they cannot be joined to a light subpath
+        if (t > 1 && s != 0 && pt.type == LIGHT_VERTEX) {
+            return SSESpectrum(0.f);
+        }
+        SSESpectrum L(0.f);
+        // Vertex sampled by the light and camera sampling strategies
+        Vertex sampled;
+        if (s == 0) {
+            // The camera subpath hit an emitter
+            const Vertex &prev = camera_vertices[t - 2];
+            if (pt.infinite) {
+                L = pt.beta * scene.EnvironmentRadiance(Ray(prev.p, pt.p - prev.p));
+            } else if (pt.type == SURFACE_VERTEX) {
+                L = pt.beta * pt.interaction->EmittedRadiance(Normalize(prev.p - pt.p));
+            }
+        } else if (t == 1) {
+            // Join the light subpath to a point of the camera
+            const Vertex &qs = light_vertices[s - 1];
+            if (qs.IsConnectible()) {
+                SSEVector wi;
+                float pdf;
+                OcclusionTester occ;
+                const SSESpectrum Wi = camera->Sample_Wi(*qs.interaction, &wi, &pdf, raster_x, raster_y, &occ);
+                if (pdf > 0.f && !IsBlack(Wi)) {
+                    // Cameras are a single point, the one camera rays leave from
+                    sampled = camera_vertices[0];
+                    sampled.beta = SSESpectrum(Wi / pdf);
+                    L = qs.beta * qs.f(sampled) * sampled.beta;
+                    L *= AbsDotProduct(wi, qs.n);
+                    if (!IsBlack(L) && !occ.Unoccluded(scene)) {
+                        L = SSESpectrum(0.f);
+                    }
+                }
+            }
+        } else if (s == 1) {
+            // Sample a point on a light chosen uniformly
+            const std::vector<const LightInterface *> &lights = scene.GetLights();
+            if (pt.IsConnectible() && !lights.empty()) {
+                const uint32_t index = std::min(static_cast<uint32_t>((*rng)() * lights.size()),
+                                                static_cast<uint32_t>(lights.size() - 1));
+                const LightInterface *const light = lights[index];
+                const float u1 = (*rng)();
+                const float u2 = (*rng)();
+                SSEVector wi;
+                float pdf;
+                OcclusionTester occ;
+                const SSESpectrum Li = light->Sample_Li(*pt.interaction, u1, u2, &wi, &pdf, &occ);
+                if (pdf > 0.f && !IsBlack(Li)) {
+                    sampled.type = LIGHT_VERTEX;
+                    sampled.beta = SSESpectrum(Li / (pdf / lights.size()));
+                    sampled.n = SSEVector(0.f, 0.f, 0.f, 0.f);
+                    sampled.interaction = nullptr;
+                    sampled.light = light;
+                    sampled.camera = nullptr;
+                    sampled.delta = false;
+                    sampled.infinite = light->IsInfiniteLight();
+                    sampled.pdf_rev = 0.f;
+                    bool visible;
+                    if (sampled.infinite) {
+                        sampled.p = SSEVector(pt.p + wi);
+                        visible = occ.Unoccluded(scene);
+                        sampled.pdf_fwd = InfiniteLightPdf(scene, *pt.interaction, wi);
+                    } else if (light->IsDeltaLight()) {
+                        sampled.p = occ.End();
+                        visible = occ.Unoccluded(scene);
+                        sampled.pdf_fwd = sampled.PdfLightOrigin(scene, pt);
+                    } else {
+                        // Find the point sampled on the emitter with its normal, it must be the first hit
+                        SurfaceInteraction hit;
+                        visible = scene.Intersect(pt.interaction->SpawnRay(wi), &hit) &&
+                                  dynamic_cast<const LightInterface *>(hit.prim_ptr) == light;
+                        sampled.p = hit.hit_point;
+                        sampled.n = hit.normal;
+                        sampled.pdf_fwd = sampled.PdfLightOrigin(scene, pt);
+                    }
+                    if (visible) {
+                        L = pt.beta * pt.f(sampled) * sampled.beta;
+                        L *= AbsDotProduct(wi, pt.n);
+                    }
+                }
+            }
+        } else {
+            // Join the two subpaths
+            const Vertex &qs = light_vertices[s - 1];
+            if (qs.IsConnectible() && pt.IsConnectible()) {
+                L = qs.beta * qs.f(pt) * pt.f(qs) * pt.beta;
+                if (!IsBlack(L)) {
+                    // Geometric term between the vertices
+                    SSEVector d = qs.p - pt.p;
+                    const float inv_distance_2 = 1.f / SqrdLength(d);
+                    d *= std::sqrt(inv_distance_2);
+                    L *= inv_distance_2 * AbsDotProduct(qs.n, d) * AbsDotProduct(pt.n, d);
+                    if (!OcclusionTester(pt.p, qs.p).Unoccluded(scene)) {
+                        L = SSESpectrum(0.f);
+                    }
+                }
+            }
+        }
+        if (IsBlack(L)) {
+            return L;
+        }
+        L *= MISWeight(s, t, scene, light_vertices, camera_vertices, sampled);
+
+        return L;
+    }
+
+    float BDPTIntegrator::MISWeight(uint32_t s, uint32_t t, const Scene &scene, Vertex *const light_vertices,
+                                    Vertex *const camera_vertices, const Vertex &sampled) const {
+        if (s + t == 2) {
+            return 1.f;
+        }
+        Vertex *const pt = &camera_vertices[t - 1];
+        // Lights at infinity do not start light subpaths, the paths ending there are only found by sampling the
+        // BSDF or the lights at the last camera vertex
+        if (s == 0 && pt->infinite) {
+            const Vertex &prev = camera_vertices[t - 2];
+            if (prev.delta) {
+                return 1.f;
+            }
+            const float pdf_light = InfiniteLightPdf(scene, *prev.interaction, Normalize(pt->p - prev.p));
+
+            return pt->pdf_fwd / (pt->pdf_fwd + pdf_light);
+        }
+        if (s == 1 && sampled.infinite) {
+            const float pdf_bsdf = pt->interaction->bsdf->Pdf(pt->wo, Normalize(sampled.p - pt->p));
+
+            return sampled.pdf_fwd / (sampled.pdf_fwd + pdf_bsdf);
+        }
+        // Emitters that are not lights are only found by hitting them
+        if (s == 0 && !pt->light) {
+            return 1.f;
+        }
+        Vertex *const qs = s > 0 ? &light_vertices[s - 1] : nullptr;
+        Vertex *const pt_minus = t > 1 ? &camera_vertices[t - 2] : nullptr;
+        Vertex *const qs_minus = s > 1 ? &light_vertices[s - 2] : nullptr;
+        // The vertices around the connection are updated for this path and restored once done
+        Vertex *const updated[4] = {pt, pt_minus, qs, qs_minus};
+        Vertex saved[4];
+        for (uint32_t i = 0; i < 4; i++) {
+            if (updated[i]) {
+                saved[i] = *updated[i];
+            }
+        }
+        if (s == 1) {
+            *qs = sampled;
+        } else if (t == 1) {
+            *pt = sampled;
+        }
+        // The connection vertices are joined whatever their lobes
+        pt->delta = false;
+        if (qs) {
+            qs->delta = false;
+        }
+        // Pdfs of sampling the connection vertices and the ones before them from the other end of the path
+        pt->pdf_rev = s > 0 ? qs->Pdf(qs_minus, *pt) : pt->PdfLightOrigin(scene, *pt_minus);
+        if (pt_minus) {
+            pt_minus->pdf_rev = s > 0 ? pt->Pdf(qs, *pt_minus) : pt->PdfLight(*pt_minus);
+        }
+        if (qs) {
+            qs->pdf_rev = pt->Pdf(pt_minus, *qs);
+        }
+        if (qs_minus) {
+            qs_minus->pdf_rev = qs->Pdf(pt, *qs_minus);
+        }
+
+        // Sum the ratios of the pdfs of the other strategies to this one, delta pdfs cancel out
+        auto remap = [](float pdf) { return pdf != 0.f ? pdf : 1.f; };
+        float sum_ri = 0.f;
+        float ri = 1.f;
+        for (uint32_t i = t - 1; i > 0; i--) {
+            ri *= remap(camera_vertices[i].pdf_rev) / remap(camera_vertices[i].pdf_fwd);
+            if (!camera_vertices[i].delta && !camera_vertices[i - 1].delta) {
+                sum_ri += ri;
+            }
+        }
+        ri = 1.f;
+        for (int32_t i = static_cast<int32_t>(s) - 1; i >= 0; i--) {
+            ri *= remap(light_vertices[i].pdf_rev) / remap(light_vertices[i].pdf_fwd);
+            const bool delta_light = i > 0 ? light_vertices[i - 1].delta : light_vertices[0].light->IsDeltaLight();
+            if (!light_vertices[i].delta && !delta_light) {
+                sum_ri += ri;
+            }
+        }
+
+        for (uint32_t i = 0; i < 4; i++) {
+            if (updated[i]) {
+                *updated[i] = saved[i];
+            }
+        }
+
+        // Balance heuristic
+        return 1.f / (1.f + sum_ri);
+    }
+
+    SSESpectrum BDPTIntegrator::IncomingRadiance(const Ray &ray, const Scene &scene) const {
+        // Subpath vertices, a light subpath always has room for the vertex of light sampling
+        std::vector<Vertex> camera_vertices(max_depth + 2), light_vertices(max_depth + 1);
+        std::vector<SurfaceInteraction> camera_interactions(max_depth + 2), light_interactions(max_depth + 1);
+        RandomGenerator *const rng = &ThreadRandomGenerator();
+        const uint32_t n_camera = CameraSubpath(ray, scene, camera_vertices.data(), camera_interactions.data(),
+                                                rng);
+        const uint32_t n_light = LightSubpath(scene, light_vertices.data(), light_interactions.data(), rng);
+
+        // Run every strategy, light sampling does not need the light subpath
+        SSESpectrum L(0.f);
+        for (uint32_t t = 1; t <= n_camera; t++) {
+            for (uint32_t s = 0; s <= std::max(n_light, 1u); s++) {
+                const int32_t depth = static_cast<int32_t>(s + t) - 2;
+                if ((s == 1 && t == 1) || depth < 0 || depth > static_cast<int32_t>(max_depth)) {
+                    continue;
+                }
+                float raster_x, raster_y;
+                const SSESpectrum L_path = Connect(s, t, scene, light_vertices.data(), camera_vertices.data(),
+                                                   &raster_x, &raster_y, rng);
+                // Paths seen from the light subpath land anywhere on the film
+                if (t != 1) {
+                    L += L_path;
+                } else if (!IsBlack(L_path)) {
+                    film->AddSplat(L_path, raster_x, raster_y);
+                }
+            }
+        }
+
+        return L;
+    }
+
+}
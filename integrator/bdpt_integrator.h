@@ -0,0 +1,140 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2016 simon.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * File:   bdpt_integrator.h
+ * Author: simon
+ *
+ * Created on October 19, 2026, 11:58 PM
+ */
+
+
+#ifndef PIXEL_BDPT_INTEGRATOR_H
+#define PIXEL_BDPT_INTEGRATOR_H
+
+#include "pixel.h"
+#include "integrator.h"
+#include "sse_vector.h"
+#include "sse_spectrum.h"
+
+namespace pixel {
+
+    // Define bidirectional path tracer class
+
+    class BDPTIntegrator : public SurfaceIntegratorInterface {
+    public:
+        // Paths are built from a subpath traced from the camera and one traced from a light, joined by every
+        // connection strategy up to max_depth bounces. Paths seen by the camera from the light subpath are
+        // splatted on the film, whose splat buffer is enabled
+        BDPTIntegrator(const std::shared_ptr<const CameraInterface> &camera, const std::shared_ptr<Film> &film,
+                       uint32_t max_depth = 5);
+
+        void Preprocess(const Scene &scene) const override;
+
+        SSESpectrum IncomingRadiance(const Ray &ray, const Scene &scene) const override;
+
+    private:
+        // Kind of subpath vertex
+        enum VertexType {
+            CAMERA_VERTEX, LIGHT_VERTEX, SURFACE_VERTEX
+        };
+
+        // Vertex of a subpath
+        struct Vertex {
+            // Convert the solid angle pdf of sampling a vertex from this one to area
+            float ConvertDensity(float pdf, const Vertex &next) const;
+
+            // Area pdf of sampling next from this vertex, reached from prev
+            float Pdf(const Vertex *const prev, const Vertex &next) const;
+
+            // Area pdf of the light of this vertex emitting toward next
+            float PdfLight(const Vertex &next) const;
+
+            // Area pdf of a light subpath starting at this vertex, which emits toward next
+            float PdfLightOrigin(const Scene &scene, const Vertex &next) const;
+
+            // BSDF of a surface vertex toward next
+            SSESpectrum f(const Vertex &next) const;
+
+            // True if the vertex can be joined to the other subpath
+            bool IsConnectible() const;
+
+            // True if the vertex lies on a surface and pdfs reaching it account for its normal
+            bool IsOnSurface() const;
+
+            VertexType type;
+            // Throughput of the subpath up to the vertex
+            SSESpectrum beta;
+            // Position and normal, the normal is zero off surfaces
+            SSEVector p, n;
+            // Direction toward the previous vertex of surfaces
+            SSEVector wo;
+            // Hit of surface vertices, its BSDF is generated
+            const SurfaceInteraction *interaction;
+            // Light of light vertices and of surfaces which are lights, null for the lights at infinity
+            const LightInterface *light;
+            // Camera of camera vertices
+            const CameraInterface *camera;
+            // Sampled from a specular lobe, or at infinity for light vertices
+            bool delta, infinite;
+            // Area pdfs of sampling the vertex from the camera and from the light end of the path, pdf_fwd of
+            // a vertex at infinity is a solid angle one
+            float pdf_fwd, pdf_rev;
+        };
+
+        // Extend a subpath with up to max_vertices vertices sampling the BSDFs, paths from the camera may end
+        // with a vertex at infinity. Returns the number of vertices added. The subpaths and connections draw
+        // their samples from the generator of the calling thread
+        uint32_t RandomWalk(const Scene &scene, Ray ray, SSESpectrum beta, float pdf, uint32_t max_vertices,
+                            bool from_camera, Vertex *const path, SurfaceInteraction *const interactions,
+                            RandomGenerator *const rng) const;
+
+        // Trace the subpath starting at the camera ray
+        uint32_t CameraSubpath(const Ray &ray, const Scene &scene, Vertex *const path,
+                               SurfaceInteraction *const interactions, RandomGenerator *const rng) const;
+
+        // Trace a subpath starting at a light chosen uniformly
+        uint32_t LightSubpath(const Scene &scene, Vertex *const path, SurfaceInteraction *const interactions,
+                              RandomGenerator *const rng) const;
+
+        // Contribution of the strategy joining s light and t camera vertices, weighted by MIS. The raster
+        // position of light tracing splats is returned
+        SSESpectrum Connect(uint32_t s, uint32_t t, const Scene &scene, Vertex *const light_vertices,
+                            Vertex *const camera_vertices, float *const raster_x, float *const raster_y,
+                            RandomGenerator *const rng) const;
+
+        // MIS weight of a strategy, the vertex sampled by the light and camera sampling strategies is given
+        float MISWeight(uint32_t s, uint32_t t, const Scene &scene, Vertex *const light_vertices,
+                        Vertex *const camera_vertices, const Vertex &sampled) const;
+
+        // Camera and film light tracing paths are splatted on
+        std::shared_ptr<const CameraInterface> camera;
+        std::shared_ptr<Film> film;
+        // Maximum number of bounces
+        const uint32_t max_depth;
+    };
+
+}
+
+#endif //PIXEL_BDPT_INTEGRATOR_H
@@ -35,7 +35,7 @@ namespace pixel {
             : SurfaceIntegratorInterface(), mode(mode) {
     }
 
-    void DebugIntegrator::Preprocess() const {
+    void DebugIntegrator::Preprocess(const Scene &) const {
 
     }
 
@@ -51,7 +51,7 @@ namespace pixel {
         // Constructor
         DebugIntegrator(const DebugMode &mode);
 
-        void Preprocess() const override;
+        void Preprocess(const Scene &scene) const override;
 
         // Compute incoming radiance from a given ray
         SSESpectrum IncomingRadiance(const Ray &ray, const Scene &scene) const override;
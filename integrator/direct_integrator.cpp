@@ -33,7 +33,7 @@ namespace pixel {
     DirectIntegrator::DirectIntegrator() {
     }
 
-    void DirectIntegrator::Preprocess() const {
+    void DirectIntegrator::Preprocess(const Scene &) const {
 
     }
 
@@ -42,8 +42,10 @@ namespace pixel {
         // Find nearest intersection
         SurfaceInteraction interaction;
         if (!scene.Intersect(ray, &interaction)) {
-            return L;
+            return scene.EnvironmentRadiance(ray);
         }
+        // Generate BSDF
+        interaction.GenerateBSDF();
         // Compute wo
         SSEVector wo_world = Normalize(-ray.Direction());
         // Add emission
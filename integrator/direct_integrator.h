@@ -42,7 +42,7 @@ namespace pixel {
         // Constructor
         DirectIntegrator();
 
-        void Preprocess() const override;
+        void Preprocess(const Scene &scene) const override;
 
         SSESpectrum IncomingRadiance(const Ray &ray, const Scene &scene) const override;
 
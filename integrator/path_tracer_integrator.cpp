@@ -26,68 +26,344 @@
 #include "interaction.h"
 #include "sse_spectrum.h"
 #include "scene.h"
+#include "film.h"
 #include "ray.h"
 #include "scattering.h"
+#include "shading_batch.h"
+#include "matte_material.h"
+#include "montecarlo.h"
 
-#include <random>
+#include <algorithm>
 
 namespace pixel {
 
-    // TODO: FIX ME
-    std::default_random_engine generator_path;
-    std::uniform_real_distribution<float> distribution_path(0.f, 1.f);
+    // Probability of sampling guided bounces from the BSDF rather than the learned incident radiance
+    static const float BSDF_SAMPLING_FRACTION = 0.5f;
 
-    PathTracerIntegrator::PathTracerIntegrator(uint32_t max_depth)
-            : max_depth(max_depth) {
+    // Guided vertices of a path recorded into the SD-tree, later ones are still guided but not learned from
+    static const uint32_t MAX_GUIDING_VERTICES = 16;
+
+    // Largest error of the irradiance records interpolated
+    static const float IRRADIANCE_CACHE_ACCURACY = 0.2f;
+
+    PathTracerIntegrator::PathTracerIntegrator(uint32_t max_depth, uint32_t rr_depth, uint32_t max_split,
+                                               bool guiding, bool irradiance_caching)
+            : max_depth(max_depth), rr_depth(rr_depth), max_split(std::max(max_split, 1u)), guiding(guiding),
+              irradiance_caching(irradiance_caching) {
     }
 
-    void PathTracerIntegrator::Preprocess() const {
+    void PathTracerIntegrator::Preprocess(const Scene &scene) const {
+        if (guiding) {
+            sd_tree.reset(new SDTree(scene.WorldBound()));
+        }
+        if (irradiance_caching) {
+            irradiance_cache.reset(new IrradianceCache(scene.WorldBound(), IRRADIANCE_CACHE_ACCURACY));
+        }
+    }
 
+    void PathTracerIntegrator::EndPass() const {
+        if (sd_tree) {
+            sd_tree->Refine();
+        }
     }
 
-    SSESpectrum PathTracerIntegrator::IncomingRadiance(const Ray &ray, const Scene &scene) const {
-        SSESpectrum L(0.f);
-        SSESpectrum alpha(1.f);
-        // Current ray
-        Ray current_ray = ray;
-        // Current outgoing direction
-        SSEVector wo_world;
-        // Sampling BSDF
+    void PathTracerIntegrator::Escape(uint32_t bounce, const Scene &scene, PathState *const path) const {
+        // Lights at infinity after diffuse bounces are accounted for by the direct illumination
+        if (bounce == 0 || path->specular_hit) {
+            path->L += path->alpha * scene.EnvironmentRadiance(path->ray);
+        }
+    }
+
+    void PathTracerIntegrator::ShadeHit(const SurfaceInteraction &interaction, uint32_t bounce, const Scene &scene,
+                                        PathState *const path) const {
+        // Compute wo
+        const SSEVector wo_world = Normalize(-path->ray.Direction());
+        // Check for emission
+        if (bounce == 0 || path->specular_hit) {
+            path->L += path->alpha * interaction.EmittedRadiance(wo_world);
+        }
+        // Compute direct illumination
+        path->L += path->alpha * DirectIllumination(interaction, wo_world, scene);
+    }
+
+    bool PathTracerIntegrator::CachedIndirect(const SurfaceInteraction &interaction, const Scene &scene,
+                                              PathState *const path, RandomGenerator *const rng) const {
+        if (!irradiance_cache || path->diffuse_bounce || !dynamic_cast<const MatteMaterial *>(interaction.mat_ptr)) {
+            return false;
+        }
+        // Irradiance arrives on the side of the path
+        const SSEVector wo_world = Normalize(-path->ray.Direction());
+        const SSEVector n = DotProduct(interaction.normal, wo_world) < 0.f ? -interaction.normal
+                                                                            : interaction.normal;
+        SSESpectrum E;
+        if (!irradiance_cache->Interpolate(interaction.hit_point, n, &E)) {
+            // Gather a new record, tracing the paths of its hemisphere as if they left this hit
+            const IrradianceRecord record = irradiance_cache->Gather(interaction, n, [&](const Ray &ray,
+                                                                                      float *const distance) {
+                PathState gather(ray);
+                gather.diffuse_bounce = true;
+                TracePath(1, scene, &gather, rng, distance);
+                return gather.L;
+            }, rng);
+            irradiance_cache->Insert(record);
+            E = record.E;
+        }
+        // Exact for lambertian surfaces, the reflection of rough ones is taken along the normal
+        path->L += path->alpha * SSESpectrum(interaction.bsdf->f(wo_world, n) * E);
+
+        return true;
+    }
+
+    uint32_t PathTracerIntegrator::Continuations(const SurfaceInteraction &interaction, uint32_t bounce,
+                                                 PathState *const path, RandomGenerator *const rng) const {
+        // The expected count follows the throughput, relative to the weight of a fully split path
+        float q = std::min(MaxComponent(path->alpha) * max_split, float(max_split));
+        // No roulette before the minimum depth
+        if (bounce < rr_depth) {
+            q = std::max(q, 1.f);
+        }
+        // Splitting a purely specular bounce only traces the same ray again
+        if (q > 1.f && interaction.bsdf->NumMatchingBRDF(BRDF_TYPE(ALL_BRDF & ~BRDF_SPECULAR)) == 0) {
+            q = 1.f;
+        }
+        if (!(q > 0.f)) {
+            return 0;
+        }
+        // Round stochastically, only drawing a sample when q is fractional
+        uint32_t n = uint32_t(q);
+        const float fraction = q - n;
+        if (fraction > 0.f && (*rng)() < fraction) {
+            n++;
+        }
+        if (q != 1.f) {
+            path->alpha /= q;
+        }
+
+        return n;
+    }
+
+    bool PathTracerIntegrator::Scatter(const SurfaceInteraction &interaction, PathState *const path,
+                                       RandomGenerator *const rng) const {
+        const SSEVector wo_world = Normalize(-path->ray.Direction());
+        // Delta lobes cannot be guided
+        SDTree::Region *region = nullptr;
+        if (sd_tree && interaction.bsdf->NumMatchingBRDF(BRDF_SPECULAR) == 0) {
+            region = sd_tree->Lookup(interaction.hit_point);
+        }
         SSEVector wi_world;
         float pdf;
         BRDF_TYPE brdf_type;
-        bool specular_hit = false;
-        SurfaceInteraction interaction;
-        for (uint32_t bounce = 0; bounce < max_depth; bounce++) {
-            if (!scene.Intersect(current_ray, &interaction)) { break; }
-            interaction.GenerateBSDF();
-            // Compute wo
-            wo_world = Normalize(-current_ray.Direction());
-            // Check for emission
-            if (bounce == 0 || specular_hit) {
-                L += alpha * interaction.EmittedRadiance(wo_world);
+        SSESpectrum f;
+        if (region && region->sampling.Flux() > 0.f) {
+            // One sample MIS: sample either distribution and weight by the pdf of their mixture
+            const float u = (*rng)();
+            const float u1 = (*rng)();
+            const float u2 = (*rng)();
+            float bsdf_pdf, guide_pdf;
+            if (u < BSDF_SAMPLING_FRACTION) {
+                f = interaction.bsdf->Sample_f(wo_world, &wi_world, &bsdf_pdf, u1, u2, ALL_BRDF, &brdf_type);
+                if (bsdf_pdf == 0.f) {
+                    return false;
+                }
+                guide_pdf = region->sampling.Pdf(wi_world);
+            } else {
+                wi_world = region->sampling.Sample(u1, u2, &guide_pdf);
+                f = interaction.bsdf->f(wo_world, wi_world);
+                bsdf_pdf = interaction.bsdf->Pdf(wo_world, wi_world);
+                brdf_type = BRDF_DIFFUSE;
             }
-            // Compute direct illumination
-            L += alpha * DirectIllumination(interaction, wo_world, scene);
+            pdf = BSDF_SAMPLING_FRACTION * bsdf_pdf + (1.f - BSDF_SAMPLING_FRACTION) * guide_pdf;
+        } else {
             // Sample the BSDF
+            f = interaction.bsdf->Sample_f(wo_world, &wi_world, &pdf, (*rng)(), (*rng)(), ALL_BRDF, &brdf_type);
+        }
+        if (IsBlack(f) || pdf == 0.f) {
+            return false;
+        }
+        path->specular_hit = (brdf_type & BRDF_SPECULAR) != 0;
+        path->diffuse_bounce |= !path->specular_hit;
+        // Compute cosine term
+        float cos_wi = path->specular_hit ? 1.f : AbsDotProduct(wi_world, interaction.normal);
+        // Update alpha
+        path->alpha *= f * (cos_wi / pdf);
+        // Update ray, differentials are only kept along specular chains from the camera
+        path->ray = path->specular_hit ? interaction.SpawnSpecularRay(path->ray, wi_world,
+                                                                      (brdf_type & BRDF_TRANSMISSION) != 0)
+                                       : interaction.SpawnRay(wi_world);
+        // The radiance arriving through the bounce is learned once the path ends
+        path->guided = region != nullptr;
+        if (region) {
+            path->vertex = {region, wi_world, pdf, path->alpha, path->L};
+        }
+
+        return true;
+    }
+
+    void PathTracerIntegrator::RecordVertices(const GuidingVertex *const vertices, uint32_t n,
+                                              const SSESpectrum &L) const {
+        for (uint32_t i = 0; i < n; i++) {
+            const GuidingVertex &v = vertices[i];
+            // Radiance gathered after the bounce divided by the throughput up to it, averaged over the channels
+            const SSESpectrum dL(L - v.L);
+            float radiance = 0.f;
+            radiance += v.alpha.r > 0.f ? dL.r / v.alpha.r : 0.f;
+            radiance += v.alpha.g > 0.f ? dL.g / v.alpha.g : 0.f;
+            radiance += v.alpha.b > 0.f ? dL.b / v.alpha.b : 0.f;
+            v.region->building.Record(v.wi, radiance / (3.f * v.pdf));
+        }
+    }
+
+    void PathTracerIntegrator::TracePath(uint32_t bounce, const Scene &scene, PathState *const path,
+                                         RandomGenerator *const rng, float *const distance) const {
+        // Guided vertices of this path, a split path keeps its own from the bounce it was split at
+        GuidingVertex vertices[MAX_GUIDING_VERTICES];
+        uint32_t n_vertices = 0;
+        auto store_vertex = [&]() {
+            if (path->guided && n_vertices < MAX_GUIDING_VERTICES) {
+                vertices[n_vertices++] = path->vertex;
+            }
+            path->guided = false;
+        };
+        store_vertex();
+        if (distance) {
+            *distance = INFINITY;
+        }
+        const uint32_t first_bounce = bounce;
+        SurfaceInteraction interaction;
+        for (; bounce < max_depth; bounce++) {
+            if (!scene.Intersect(path->ray, &interaction)) {
+                Escape(bounce, scene, path);
+                break;
+            }
+            if (distance && bounce == first_bounce) {
+                *distance = Length(interaction.hit_point - path->ray.Origin());
+            }
             interaction.GenerateBSDF();
-            SSESpectrum f = interaction.bsdf->Sample_f(wo_world, &wi_world, &pdf,
-                                                       distribution_path(generator_path),
-                                                       distribution_path(generator_path),
-                                                       ALL_BRDF, &brdf_type);
-            if (IsBlack(f) || pdf == 0.f) {
+            ShadeHit(interaction, bounce, scene, path);
+            // The ray sampled at the last bounce would never be traced
+            if (bounce + 1 == max_depth || CachedIndirect(interaction, scene, path, rng)) {
                 break;
             }
-            specular_hit = (brdf_type & BRDF_SPECULAR) != 0;
-            // Compute cosine term
-            float cos_wi = specular_hit ? 1.f : AbsDotProduct(wi_world, interaction.normal);
-            // Update alpha
-            alpha *= f * (cos_wi / pdf);
-            // Update ray
-            current_ray = interaction.SpawnRay(wi_world);
+            const uint32_t n = Continuations(interaction, bounce, path, rng);
+            // Extra paths gather their own radiance, this one carries on
+            for (uint32_t i = 1; i < n; i++) {
+                PathState split(*path);
+                split.L = SSESpectrum(0.f);
+                if (Scatter(interaction, &split, rng)) {
+                    TracePath(bounce + 1, scene, &split, rng);
+                    path->L += split.L;
+                }
+            }
+            if (n == 0 || !Scatter(interaction, path, rng)) {
+                break;
+            }
+            store_vertex();
         }
+        RecordVertices(vertices, n_vertices, path->L);
+    }
 
-        return L;
+    SSESpectrum PathTracerIntegrator::IncomingRadiance(const Ray &ray, const Scene &scene) const {
+        PathState path(ray);
+        TracePath(0, scene, &path, &ThreadRandomGenerator());
+
+        return path.L;
+    }
+
+    void PathTracerIntegrator::IncomingRadianceBatch(const Ray *const rays, uint32_t count, const Scene &scene,
+                                                     SSESpectrum *const L, AOVSample *const aovs) const {
+        if (aovs) {
+            std::fill(aovs, aovs + count, AOVSample());
+        }
+        RandomGenerator *const rng = &ThreadRandomGenerator();
+        std::vector<PathState> paths(rays, rays + count);
+        // Split paths are appended after the camera paths, with the index of the path they were split from and
+        // its number of guided vertices at that point
+        std::vector<uint32_t> parent(count), split_vertex(count, 0);
+        for (uint32_t i = 0; i < count; i++) {
+            parent[i] = i;
+        }
+        // Guided vertices of each path
+        std::vector<GuidingVertex> vertices(guiding ? count * MAX_GUIDING_VERTICES : 0);
+        std::vector<uint32_t> n_vertices(count, 0);
+        auto store_vertex = [&](uint32_t p) {
+            if (paths[p].guided && n_vertices[p] < MAX_GUIDING_VERTICES) {
+                vertices[p * MAX_GUIDING_VERTICES + n_vertices[p]++] = paths[p].vertex;
+            }
+            paths[p].guided = false;
+        };
+        std::vector<SurfaceInteraction> interactions(count);
+        // Paths still being traced
+        std::vector<uint32_t> active(parent);
+        std::vector<uint8_t> alive(count);
+        ShadingBatch batch;
+        for (uint32_t bounce = 0; bounce < max_depth && !active.empty(); bounce++) {
+            // Intersect all the paths and gather the hits
+            batch.Clear();
+            for (uint32_t p : active) {
+                if (scene.Intersect(paths[p].ray, &interactions[p])) {
+                    batch.Add(&interactions[p], p);
+                } else {
+                    Escape(bounce, scene, &paths[p]);
+                }
+            }
+            // Shade material by material
+            batch.GenerateBSDFs();
+            std::fill(alive.begin(), alive.end(), 0);
+            const bool last = bounce + 1 == max_depth;
+            for (uint32_t i = 0; i < batch.Size(); i++) {
+                const uint32_t p = batch.Path(i);
+                if (aovs && bounce == 0) {
+                    RecordAOVs(interactions[p], rays[p], &aovs[p]);
+                }
+                ShadeHit(interactions[p], bounce, scene, &paths[p]);
+                if (last || CachedIndirect(interactions[p], scene, &paths[p], rng)) {
+                    continue;
+                }
+                const uint32_t n = Continuations(interactions[p], bounce, &paths[p], rng);
+                for (uint32_t j = 1; j < n; j++) {
+                    PathState split(paths[p]);
+                    split.L = SSESpectrum(0.f);
+                    if (Scatter(interactions[p], &split, rng)) {
+                        paths.push_back(split);
+                        parent.push_back(p);
+                        split_vertex.push_back(n_vertices[p]);
+                        n_vertices.push_back(0);
+                        alive.push_back(1);
+                        if (guiding) {
+                            vertices.resize(paths.size() * MAX_GUIDING_VERTICES);
+                        }
+                        store_vertex(static_cast<uint32_t>(paths.size() - 1));
+                    }
+                }
+                alive[p] = n > 0 && Scatter(interactions[p], &paths[p], rng);
+                store_vertex(p);
+            }
+            // Trace the surviving paths in their original order, neighbor pixels take similar paths
+            interactions.resize(paths.size());
+            active.clear();
+            for (uint32_t p = 0; p < paths.size(); p++) {
+                if (alive[p]) {
+                    active.push_back(p);
+                }
+            }
+        }
+        // Split paths are created after their parent, so going backwards each path has gathered the radiance of
+        // its own splits when it is recorded and added to its parent
+        for (uint32_t i = static_cast<uint32_t>(paths.size()); i-- > 0;) {
+            if (guiding) {
+                RecordVertices(&vertices[i * MAX_GUIDING_VERTICES], n_vertices[i], paths[i].L);
+            }
+            if (i < count) {
+                L[i] = paths[i].L;
+                continue;
+            }
+            // The parent vertices sampled after the split do not see its radiance
+            const uint32_t p = parent[i];
+            paths[p].L += paths[i].L;
+            for (uint32_t v = split_vertex[i]; v < n_vertices[p]; v++) {
+                vertices[p * MAX_GUIDING_VERTICES + v].L += paths[i].L;
+            }
+        }
     }
 
 }
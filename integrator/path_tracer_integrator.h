@@ -34,6 +34,10 @@
 
 #include "pixel.h"
 #include "integrator.h"
+#include "ray.h"
+#include "sse_spectrum.h"
+#include "sd_tree.h"
+#include "irradiance_cache.h"
 
 namespace pixel {
 
@@ -41,15 +45,99 @@ namespace pixel {
 
     class PathTracerIntegrator : public SurfaceIntegratorInterface {
     public:
-        PathTracerIntegrator(uint32_t max_depth = 30);
+        // Paths are subject to Russian roulette from rr_depth bounces on, and the indirect bounce of a
+        // non-specular hit may split into up to max_split paths while their throughput is high. With guiding,
+        // non-specular bounces also sample the incident radiance learned over the previous passes. With
+        // irradiance caching, the indirect lighting of the first diffuse hit on matte surfaces is interpolated
+        // from records shared by all the paths, gathered by path tracing where they are too sparse
+        PathTracerIntegrator(uint32_t max_depth = 30, uint32_t rr_depth = 3, uint32_t max_split = 1,
+                             bool guiding = false, bool irradiance_caching = false);
 
-        void Preprocess() const override;
+        void Preprocess(const Scene &scene) const override;
+
+        // Sample the incident radiance recorded in the pass from now on
+        void EndPass() const override;
 
         SSESpectrum IncomingRadiance(const Ray &ray, const Scene &scene) const override;
 
+        // Trace the paths of a batch together, sorting the hits of each bounce by material before shading. The
+        // auxiliary values are recorded at the first hits
+        void IncomingRadianceBatch(const Ray *const rays, uint32_t count, const Scene &scene,
+                                   SSESpectrum *const L, AOVSample *const aovs = nullptr) const override;
+
     private:
+        // Guided bounce of a path, recorded into the SD-tree once the radiance arriving through it is known
+        struct GuidingVertex {
+            // Region of the hit, sampled direction and its pdf
+            SDTree::Region *region;
+            SSEVector wi;
+            float pdf;
+            // Throughput after the bounce and radiance of the path at that point
+            SSESpectrum alpha, L;
+        };
+
+        // State of a path between bounces
+        struct PathState {
+            PathState(const Ray &ray)
+                    : ray(ray), alpha(1.f), L(0.f), specular_hit(false), diffuse_bounce(false), guided(false) {}
+
+            // Next ray to trace
+            Ray ray;
+            // Throughput and radiance gathered so far
+            SSESpectrum alpha, L;
+            // Last bounce was specular
+            bool specular_hit;
+            // A non-specular bounce was taken, only the first one is served by the irradiance cache
+            bool diffuse_bounce;
+            // Last bounce was guided, its vertex is still to be stored by the tracing loop
+            bool guided;
+            GuidingVertex vertex;
+        };
+
+        // Add the radiance of the lights at infinity for a path leaving the scene
+        void Escape(uint32_t bounce, const Scene &scene, PathState *const path) const;
+
+        // Add the emission and direct illumination at the hit of a path, whose BSDF is already generated
+        void ShadeHit(const SurfaceInteraction &interaction, uint32_t bounce, const Scene &scene,
+                      PathState *const path) const;
+
+        // Add the indirect lighting of a hit from the irradiance cache, gathering a new record when needed.
+        // Returns false when the cache does not apply and the path goes on
+        bool CachedIndirect(const SurfaceInteraction &interaction, const Scene &scene, PathState *const path,
+                            RandomGenerator *const rng) const;
+
+        // Choose how many paths continue from a hit, zero terminates the path. The throughput is divided by
+        // the expected count so the estimate stays unbiased
+        uint32_t Continuations(const SurfaceInteraction &interaction, uint32_t bounce, PathState *const path,
+                               RandomGenerator *const rng) const;
+
+        // Sample the next ray of a path at a hit, from the BSDF or the learned incident radiance. Returns false
+        // when the path ends
+        bool Scatter(const SurfaceInteraction &interaction, PathState *const path, RandomGenerator *const rng) const;
+
+        // Record the radiance arriving through the guided vertices of a path, given its final radiance
+        void RecordVertices(const GuidingVertex *const vertices, uint32_t n, const SSESpectrum &L) const;
+
+        // Trace a path from the given bounce on, split paths are traced recursively. The samples are drawn from
+        // the generator of the calling thread. The distance to the first hit is returned if asked, infinite when
+        // the path leaves the scene
+        void TracePath(uint32_t bounce, const Scene &scene, PathState *const path, RandomGenerator *const rng,
+                       float *const distance = nullptr) const;
+
         // Maximum tracing depth
         const uint32_t max_depth;
+        // First bounce subject to Russian roulette
+        const uint32_t rr_depth;
+        // Maximum number of paths a bounce splits into
+        const uint32_t max_split;
+        // Learn and sample the incident radiance
+        const bool guiding;
+        // Interpolate the indirect lighting of matte surfaces
+        const bool irradiance_caching;
+        // Incident radiance learned over the passes, created by Preprocess
+        mutable std::unique_ptr<SDTree> sd_tree;
+        // Irradiance records, created by Preprocess
+        mutable std::unique_ptr<IrradianceCache> irradiance_cache;
     };
 
 }
@@ -0,0 +1,190 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2016 simon.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "ppm_integrator.h"
+#include "interaction.h"
+#include "scene.h"
+#include "ray.h"
+#include "light.h"
+#include "bbox.h"
+#include "scattering.h"
+#include "parallel.h"
+#include "montecarlo.h"
+
+#include <random>
+
+namespace pixel {
+
+    // Rate at which the lookup radius shrinks, the photon density grows as the lookup area times a fraction
+    // alpha of the photons of each pass is kept
+    static const float PPM_ALPHA = 2.f / 3.f;
+
+    // Default initial radius relative to the diagonal of the scene bounds
+    static const float PPM_RADIUS_FRACTION = 0.005f;
+
+    // Photon paths traced per chunk, each one with its own random numbers
+    static const uint32_t PPM_CHUNK_SIZE = 4096;
+
+    PPMIntegrator::PPMIntegrator(uint32_t photons_per_pass, float initial_radius, uint32_t max_depth)
+            : photons_per_pass(photons_per_pass), initial_radius(initial_radius), max_depth(max_depth),
+              scene(nullptr), radius(0.f), pass(0) {
+    }
+
+    void PPMIntegrator::Preprocess(const Scene &s) const {
+        scene = &s;
+        pass = 0;
+        radius = initial_radius;
+        if (radius <= 0.f) {
+            const BBox bounds = s.WorldBound();
+            radius = PPM_RADIUS_FRACTION * Length(bounds.Max() - bounds.Min());
+        }
+        TracePhotons();
+    }
+
+    void PPMIntegrator::EndPass() const {
+        radius *= std::sqrt((pass + PPM_ALPHA) / (pass + 1.f));
+        pass++;
+        TracePhotons();
+    }
+
+    uint32_t PPMIntegrator::MaxPassSamples() const {
+        return 1;
+    }
+
+    void PPMIntegrator::TracePhotons() const {
+        const std::vector<const LightInterface *> &lights = scene->GetLights();
+        const uint32_t n_chunks = (photons_per_pass + PPM_CHUNK_SIZE - 1) / PPM_CHUNK_SIZE;
+        std::vector<std::vector<Photon>> chunk_photons(n_chunks);
+        if (!lights.empty()) {
+            ParallelFor(n_chunks, [&](uint32_t begin, uint32_t end) {
+                for (uint32_t c = begin; c < end; c++) {
+                    std::default_random_engine generator(pass * n_chunks + c + 1);
+                    std::uniform_real_distribution<float> distribution(0.f, 1.f);
+                    std::vector<Photon> &photons = chunk_photons[c];
+                    const uint32_t end_photon = std::min((c + 1) * PPM_CHUNK_SIZE, photons_per_pass);
+                    for (uint32_t k = c * PPM_CHUNK_SIZE; k < end_photon; k++) {
+                        // Choose a light uniformly and sample a ray leaving it
+                        const uint32_t index = std::min(
+                                static_cast<uint32_t>(distribution(generator) * lights.size()),
+                                static_cast<uint32_t>(lights.size() - 1));
+                        const float u1 = distribution(generator);
+                        const float u2 = distribution(generator);
+                        const float u3 = distribution(generator);
+                        const float u4 = distribution(generator);
+                        Ray ray(SSEVector(0.f, 0.f, 0.f, 1.f), SSEVector(0.f, 1.f, 0.f, 0.f));
+                        SSEVector normal;
+                        float pdf_pos, pdf_dir;
+                        const SSESpectrum Le = lights[index]->Sample_Le(u1, u2, u3, u4, &ray, &normal,
+                                                                        &pdf_pos, &pdf_dir);
+                        if (pdf_pos == 0.f || pdf_dir == 0.f || IsBlack(Le)) {
+                            continue;
+                        }
+                        const bool on_surface = normal.x != 0.f || normal.y != 0.f || normal.z != 0.f;
+                        const float cos_theta = on_surface ? AbsDotProduct(normal, ray.Direction()) : 1.f;
+                        SSESpectrum beta(Le * (cos_theta * lights.size() / (pdf_pos * pdf_dir)));
+                        // Follow the photon, direct lighting is left to the lights
+                        SurfaceInteraction interaction;
+                        for (uint32_t depth = 0; depth < max_depth; depth++) {
+                            if (!scene->Intersect(ray, &interaction)) {
+                                break;
+                            }
+                            interaction.GenerateBSDF();
+                            const SSEVector wo = Normalize(-ray.Direction());
+                            if (depth > 0 &&
+                                interaction.bsdf->NumMatchingBRDF(BRDF_TYPE(ALL_BRDF & ~BRDF_SPECULAR)) > 0) {
+                                photons.push_back({interaction.hit_point, wo, beta});
+                            }
+                            SSEVector wi;
+                            float pdf;
+                            BRDF_TYPE brdf_type;
+                            const SSESpectrum f = interaction.bsdf->Sample_f(wo, &wi, &pdf,
+                                                                             distribution(generator),
+                                                                             distribution(generator),
+                                                                             ALL_BRDF, &brdf_type);
+                            if (IsBlack(f) || pdf == 0.f) {
+                                break;
+                            }
+                            const float cos_wi = (brdf_type & BRDF_SPECULAR) ? 1.f
+                                                                             : AbsDotProduct(wi, interaction.normal);
+                            const SSESpectrum new_beta(beta * f * (cos_wi / pdf));
+                            // Russian roulette keeping the flux of the photons roughly constant
+                            const float q = std::max(0.f, 1.f - MaxComponent(new_beta) / MaxComponent(beta));
+                            if (distribution(generator) < q) {
+                                break;
+                            }
+                            beta = SSESpectrum(new_beta / (1.f - q));
+                            ray = interaction.SpawnRay(wi);
+                        }
+                    }
+                }
+            }, 1);
+        }
+        // Gather the photons of all the chunks
+        std::vector<Photon> photons;
+        for (const std::vector<Photon> &c : chunk_photons) {
+            photons.insert(photons.end(), c.begin(), c.end());
+        }
+        grid.Build(&photons, radius);
+    }
+
+    SSESpectrum PPMIntegrator::IncomingRadiance(const Ray &r, const Scene &s) const {
+        RandomGenerator &rng = ThreadRandomGenerator();
+        SSESpectrum L(0.f), beta(1.f);
+        Ray ray = r;
+        SurfaceInteraction interaction;
+        for (uint32_t depth = 0; depth < max_depth; depth++) {
+            if (!s.Intersect(ray, &interaction)) {
+                L += beta * s.EnvironmentRadiance(ray);
+                break;
+            }
+            interaction.GenerateBSDF();
+            const SSEVector wo = Normalize(-ray.Direction());
+            // Only reached through specular bounces
+            L += beta * interaction.EmittedRadiance(wo);
+            if (interaction.bsdf->NumMatchingBRDF(BRDF_TYPE(ALL_BRDF & ~BRDF_SPECULAR)) > 0) {
+                // Direct lighting from the lights and the rest from the photons around the hit
+                L += beta * DirectIllumination(interaction, wo, s);
+                SSESpectrum flux(0.f);
+                grid.Lookup(interaction.hit_point, [&](const Photon &photon) {
+                    flux += interaction.bsdf->f(wo, photon.wi) * photon.beta;
+                });
+                L += SSESpectrum(beta * flux) / (PI * radius * radius * photons_per_pass);
+                break;
+            }
+            // Follow specular bounces
+            SSEVector wi;
+            float pdf;
+            BRDF_TYPE brdf_type;
+            const SSESpectrum f = interaction.bsdf->Sample_f(wo, &wi, &pdf, rng(), rng(), ALL_BRDF, &brdf_type);
+            if (IsBlack(f) || pdf == 0.f) {
+                break;
+            }
+            beta *= f / pdf;
+            ray = interaction.SpawnSpecularRay(ray, wi, (brdf_type & BRDF_TRANSMISSION) != 0);
+        }
+
+        return L;
+    }
+
+}
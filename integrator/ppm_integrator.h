@@ -0,0 +1,82 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2016 simon.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * File:   ppm_integrator.h
+ * Author: simon
+ *
+ * Created on October 20, 2026, 12:55 AM
+ */
+
+
+#ifndef PIXEL_PPM_INTEGRATOR_H
+#define PIXEL_PPM_INTEGRATOR_H
+
+#include "pixel.h"
+#include "integrator.h"
+#include "photon_grid.h"
+
+namespace pixel {
+
+    // Define progressive photon mapping class
+
+    class PPMIntegrator : public SurfaceIntegratorInterface {
+    public:
+        // Camera paths follow specular bounces up to the first diffuse hit, lit directly by the lights and
+        // indirectly by a photon map traced anew each pass. The lookup radius shrinks every pass so the
+        // estimate converges, a zero initial radius is chosen from the scene size
+        PPMIntegrator(uint32_t photons_per_pass = 100000, float initial_radius = 0.f, uint32_t max_depth = 5);
+
+        // Trace the photon map of the first pass
+        void Preprocess(const Scene &scene) const override;
+
+        // Shrink the radius and trace the photon map of the next pass
+        void EndPass() const override;
+
+        // Every pass takes a single sample per pixel with its own photon map
+        uint32_t MaxPassSamples() const override;
+
+        SSESpectrum IncomingRadiance(const Ray &ray, const Scene &scene) const override;
+
+    private:
+        // Trace photons_per_pass photons from the lights over all the cores and build the grid
+        void TracePhotons() const;
+
+        // Number of photon paths traced in a pass
+        const uint32_t photons_per_pass;
+        // Lookup radius of the first pass
+        const float initial_radius;
+        // Maximum number of bounces of camera and photon paths
+        const uint32_t max_depth;
+        // Scene photons are traced in, set by Preprocess
+        mutable const Scene *scene;
+        // Photon map of the current pass, its lookup radius and the number of passes done
+        mutable PhotonGrid grid;
+        mutable float radius;
+        mutable uint32_t pass;
+    };
+
+}
+
+#endif //PIXEL_PPM_INTEGRATOR_H
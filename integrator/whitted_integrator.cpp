@@ -36,7 +36,7 @@ namespace pixel {
             : max_depth(max_depth) {
     }
 
-    void WhittedIntegrator::Preprocess() const {
+    void WhittedIntegrator::Preprocess(const Scene &) const {
 
     }
 
@@ -45,7 +45,7 @@ namespace pixel {
         // Find nearest intersection
         SurfaceInteraction interaction;
         if (!scene.Intersect(ray, &interaction)) {
-            return L;
+            return scene.EnvironmentRadiance(ray);
         }
         // Generate BSDF
         interaction.GenerateBSDF();
@@ -57,8 +57,8 @@ namespace pixel {
         L += DirectIllumination(interaction, wo_world, scene);
 
         if (ray.RayDepth() < max_depth) {
-            L += SpecularReflection(interaction, wo_world, this, scene, ray.RayDepth() + 1);
-            L += SpecularRefraction(interaction, wo_world, this, scene, ray.RayDepth() + 1);
+            L += SpecularReflect(interaction, ray, wo_world, this, scene, ray.RayDepth() + 1);
+            L += SpecularTransmit(interaction, ray, wo_world, this, scene, ray.RayDepth() + 1);
         }
 
         return L;
@@ -42,7 +42,7 @@ namespace pixel {
     public:
         WhittedIntegrator(uint32_t max_depth = 5);
 
-        void Preprocess() const override;
+        void Preprocess(const Scene &scene) const override;
 
         SSESpectrum IncomingRadiance(const Ray &ray, const Scene &scene) const override;
 
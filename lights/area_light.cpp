@@ -27,6 +27,7 @@
 #include "bbox.h"
 #include "sse_spectrum.h"
 #include "material.h"
+#include "montecarlo.h"
 
 namespace pixel {
 
@@ -57,12 +58,38 @@ namespace pixel {
         return shape->Pdf(from, wi);
     }
 
+    SSESpectrum AreaLight::Sample_Le(float u1, float u2, float u3, float u4, Ray *const ray, SSEVector *const normal,
+                                     float *const pdf_pos, float *const pdf_dir) const {
+        // Sample a point on the shape
+        SurfaceInteraction shape_sample = shape->Sample(u1, u2);
+        *normal = shape_sample.normal;
+        *pdf_pos = 1.f / shape->Area();
+        // Cosine sample a direction on the emitting side
+        const SSEVector local = CosineSampleHemisphere(u3, u4);
+        SSEVector s, t;
+        CoordinateSystem(*normal, &s, &t);
+        SSEVector dir(s * local.x);
+        dir += *normal * local.y;
+        dir += t * local.z;
+        *pdf_dir = CosinePdfHemisphere(local.y);
+        *ray = shape_sample.SpawnRay(dir);
+
+        return material->Emission(shape_sample, dir);
+    }
+
+    void AreaLight::Pdf_Le(const Ray &ray, const SSEVector &normal, float *const pdf_pos,
+                           float *const pdf_dir) const {
+        *pdf_pos = 1.f / shape->Area();
+        *pdf_dir = CosinePdfHemisphere(std::max(DotProduct(normal, ray.Direction()), 0.f));
+    }
+
     bool AreaLight::Intersect(const Ray &ray, SurfaceInteraction *const interaction) const {
         float t_hit;
         if (shape->Intersect(ray, &t_hit, interaction)) {
             // Update ray maximum value
             ray.SetNewMaximum(t_hit);
             interaction->prim_ptr = this;
+            interaction->instance_ptr = nullptr;
             interaction->mat_ptr = material.get();
 
             return true;
@@ -71,6 +98,10 @@ namespace pixel {
         return false;
     }
 
+    void AreaLight::ComputeSurfaceInteraction(const Ray &ray, SurfaceInteraction *const interaction) const {
+        shape->ComputeSurfaceInteraction(ray, interaction);
+    }
+
     bool AreaLight::IntersectP(const Ray &ray) const {
         return shape->IntersectP(ray);
     }
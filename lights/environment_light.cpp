@@ -0,0 +1,121 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2016 simon.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "environment_light.h"
+#include "image_io.h"
+#include "ray.h"
+#include <iostream>
+
+namespace pixel {
+
+    EnvironmentLight::EnvironmentLight(const std::string &file_name, const SSEMatrix &l2w,
+                                       const SSESpectrum &scale)
+            : light_to_world(l2w), world_to_light(Inverse(l2w)), scale(scale), width(0), height(0) {
+        if (!ReadPFM(file_name, &width, &height, &texels)) {
+            std::cerr << "Cannot read environment map " << file_name << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        Initialize();
+    }
+
+    EnvironmentLight::EnvironmentLight(const std::vector<SSESpectrum> &texels, uint32_t width, uint32_t height,
+                                       const SSEMatrix &l2w, const SSESpectrum &scale)
+            : light_to_world(l2w), world_to_light(Inverse(l2w)), scale(scale), width(width), height(height),
+              texels(texels) {
+        Initialize();
+    }
+
+    void EnvironmentLight::Initialize() {
+        // Weight the luminance by sin(theta) to account for the area of the rows on the sphere
+        std::vector<float> luminance(texels.size());
+        for (uint32_t y = 0; y < height; y++) {
+            const float sin_theta = std::sin(PI * (y + 0.5f) / height);
+            for (uint32_t x = 0; x < width; x++) {
+                const SSESpectrum &t = texels[y * width + x];
+                luminance[y * width + x] = (0.2126f * t.r + 0.7152f * t.g + 0.0722f * t.b) * sin_theta;
+            }
+        }
+        distribution.reset(new Distribution2D(luminance.data(), width, height));
+    }
+
+    void EnvironmentLight::DirectionToMap(const SSEVector &w, float *const u, float *const v) const {
+        const SSEVector d = Normalize(world_to_light * w);
+        float phi = Atan2(d.z, d.x);
+        if (phi < 0.f) {
+            phi += TWO_PI;
+        }
+        *u = phi / TWO_PI;
+        *v = Acos(Clamp(d.y, -1.f, 1.f)) / PI;
+    }
+
+    SSESpectrum EnvironmentLight::Lookup(float u, float v) const {
+        // Nearest texel, matching the piecewise constant distribution
+        const uint32_t x = FMin(static_cast<uint32_t>(u * width), width - 1);
+        const uint32_t y = FMin(static_cast<uint32_t>(v * height), height - 1);
+
+        return SSESpectrum(texels[y * width + x] * scale);
+    }
+
+    bool EnvironmentLight::IsInfiniteLight() const {
+        return true;
+    }
+
+    SSESpectrum EnvironmentLight::Le(const Ray &ray) const {
+        float u, v;
+        DirectionToMap(ray.Direction(), &u, &v);
+
+        return Lookup(u, v);
+    }
+
+    SSESpectrum EnvironmentLight::Sample_Li(const SurfaceInteraction &from, float u1, float u2,
+                                            SSEVector *const wi, float *const pdf,
+                                            OcclusionTester *const occ) const {
+        // Sample the map and convert the point to a direction
+        float u, v, map_pdf;
+        distribution->SampleContinuous(u1, u2, &u, &v, &map_pdf);
+        const float theta = v * PI;
+        float sin_theta, cos_theta;
+        SinCos(theta, &sin_theta, &cos_theta);
+        if (map_pdf == 0.f || sin_theta == 0.f) {
+            *pdf = 0.f;
+            return SSESpectrum(0.f);
+        }
+        *wi = Normalize(light_to_world * SphericalDirection(sin_theta, cos_theta, u * TWO_PI));
+        // Change of variables from the map to solid angle, d_omega = 2 pi^2 sin(theta) du dv
+        *pdf = map_pdf / (2.f * PI * PI * sin_theta);
+        *occ = OcclusionTester(from.hit_point, *wi, INFINITY);
+
+        return Lookup(u, v);
+    }
+
+    float EnvironmentLight::Pdf_Li(const SurfaceInteraction &, const SSEVector &wi) const {
+        float u, v;
+        DirectionToMap(wi, &u, &v);
+        const float sin_theta = std::sin(v * PI);
+        if (sin_theta == 0.f) { return 0.f; }
+
+        return distribution->Pdf(u, v) / (2.f * PI * PI * sin_theta);
+    }
+
+}
@@ -0,0 +1,90 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2016 simon.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * File:   environment_light.h
+ * Author: simon
+ *
+ * Created on October 19, 2026, 7:25 PM
+ */
+
+#ifndef PIXEL_ENVIRONMENT_LIGHT_H
+#define PIXEL_ENVIRONMENT_LIGHT_H
+
+#include "pixel.h"
+#include "light.h"
+#include "sse_matrix.h"
+#include "sse_spectrum.h"
+#include "montecarlo.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace pixel {
+
+    // Define EnvironmentLight class, light at infinity given by a lat-long radiance map. The top row of the
+    // map is the +y direction of the light space, u follows phi around it. Directions are importance
+    // sampled from the luminance of the map
+    class EnvironmentLight : public LightInterface {
+    public:
+        // Constructor from a PFM image
+        EnvironmentLight(const std::string &file_name, const SSEMatrix &l2w, const SSESpectrum &scale);
+
+        // Constructor from radiance values, rows from the top one
+        EnvironmentLight(const std::vector<SSESpectrum> &texels, uint32_t width, uint32_t height,
+                         const SSEMatrix &l2w, const SSESpectrum &scale);
+
+        bool IsInfiniteLight() const override;
+
+        SSESpectrum Le(const Ray &ray) const override;
+
+        SSESpectrum Sample_Li(const SurfaceInteraction &from, float u1, float u2,
+                              SSEVector *const wi, float *const pdf, OcclusionTester *const occ) const override;
+
+        float Pdf_Li(const SurfaceInteraction &from, const SSEVector &wi) const override;
+
+    private:
+        // Build the sampling distribution from the texels
+        void Initialize();
+
+        // Map coordinates of a world direction
+        void DirectionToMap(const SSEVector &w, float *const u, float *const v) const;
+
+        // Radiance at the given map coordinates
+        SSESpectrum Lookup(float u, float v) const;
+
+        // Light space
+        SSEMatrix light_to_world, world_to_light;
+        // Radiance scale
+        const SSESpectrum scale;
+        // Radiance map
+        uint32_t width, height;
+        std::vector<SSESpectrum> texels;
+        // Distribution of the map luminance weighted by sin(theta)
+        std::unique_ptr<const Distribution2D> distribution;
+    };
+
+}
+
+#endif //PIXEL_ENVIRONMENT_LIGHT_H
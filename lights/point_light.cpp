@@ -23,6 +23,8 @@
  */
 
 #include "point_light.h"
+#include "ray.h"
+#include "montecarlo.h"
 
 namespace pixel {
 
@@ -46,4 +48,20 @@ namespace pixel {
         return 0.f;
     }
 
+    SSESpectrum PointLight::Sample_Le(float, float, float u3, float u4, Ray *const ray, SSEVector *const normal,
+                                      float *const pdf_pos, float *const pdf_dir) const {
+        // Emit uniformly in all directions, the position is a delta
+        *ray = Ray(position, UniformSampleSphere(u3, u4));
+        *normal = SSEVector(0.f, 0.f, 0.f, 0.f);
+        *pdf_pos = 1.f;
+        *pdf_dir = UniformPdfSphere();
+
+        return intensity;
+    }
+
+    void PointLight::Pdf_Le(const Ray &, const SSEVector &, float *const pdf_pos, float *const pdf_dir) const {
+        *pdf_pos = 0.f;
+        *pdf_dir = UniformPdfSphere();
+    }
+
 }
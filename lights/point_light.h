@@ -50,6 +50,12 @@ namespace pixel {
 
         float Pdf_Li(const SurfaceInteraction &from, const SSEVector &wi) const override;
 
+        SSESpectrum Sample_Le(float u1, float u2, float u3, float u4, Ray *const ray, SSEVector *const normal,
+                              float *const pdf_pos, float *const pdf_dir) const override;
+
+        void Pdf_Le(const Ray &ray, const SSEVector &normal, float *const pdf_pos,
+                    float *const pdf_dir) const override;
+
     private:
         // Light position
         const SSEVector position;
@@ -34,7 +34,6 @@
 #include "box_film.h"
 #include "clamp_tonemapper.h"
 #include "ray.h"
-#include "matrix.h"
 #include "camera.h"
 #include "pinhole_camera.h"
 #include "scene.h"
@@ -55,6 +54,7 @@
 #include "mirror_material.h"
 #include "glass_material.h"
 #include "prim_list.h"
+#include "bvh.h"
 #include "point_light.h"
 #include "area_light.h"
 #include "constant_texture.h"
@@ -77,7 +77,7 @@ int main(int argc, char **argv) {
 //            pixel::SSEVector(0.f, 1.f, 0.f, 0.f),
 //            60.f, f->GetWidth(), f->GetHeight());
 
-    pixel::PrimitiveList list;
+    std::vector<const pixel::PrimitiveInterface *> primitives;
 
     // Create textures
     auto white_tex = std::make_shared<const pixel::ConstantTexture<pixel::SSESpectrum>>(
@@ -108,61 +108,64 @@ int main(int argc, char **argv) {
     auto s1 = std::make_shared<const pixel::Sphere>(pixel::Translate(-4.f, 2.f, 0.f), 2.f);
     auto m1 = std::make_shared<const pixel::MatteMaterial>(red_tex, sigma_tex);
     auto p1 = std::make_shared<const pixel::Instance>(s1, m1);
-    list.AddPrimitive(p1.get());
+    primitives.push_back(p1.get());
 
     auto s2 = std::make_shared<const pixel::Sphere>(pixel::Translate(4.f, 2.f, 0.f), 2.f);
     auto m2 = std::make_shared<const pixel::MatteMaterial>(green_tex, sigma_tex);
     auto p2 = std::make_shared<const pixel::Instance>(s2, m2);
-    list.AddPrimitive(p2.get());
+    primitives.push_back(p2.get());
 
     auto s3 = std::make_shared<const pixel::Sphere>(pixel::Translate(4.f, 6.f, 5.f), 3.f);
     auto g1 = std::make_shared<const pixel::GlassMaterial>(mirror_tex, mirror_tex, ref_tex);
     auto p3 = std::make_shared<const pixel::Instance>(s3, g1);
-    list.AddPrimitive(p3.get());
+    primitives.push_back(p3.get());
 
     auto s31 = std::make_shared<const pixel::Sphere>(pixel::Translate(-4.f, 6.f, 5.f), 3.f);
     auto p31 = std::make_shared<const pixel::Instance>(s31, g1);
-    list.AddPrimitive(p31.get());
+    primitives.push_back(p31.get());
 
     auto s4 = std::make_shared<const pixel::Sphere>(pixel::Translate(6.f, 8.f, -4.f), 2.f);
     auto mirror1 = std::make_shared<const pixel::MirrorMaterial>(mirror_tex);
     auto p4 = std::make_shared<const pixel::Instance>(s4, mirror1);
-    list.AddPrimitive(p4.get());
+    primitives.push_back(p4.get());
 
     auto r1 = std::make_shared<const pixel::Rectangle>(pixel::SSEMatrix(), 20.f, 20.f);
     auto m3 = std::make_shared<const pixel::MatteMaterial>(grid_tex, sigma_tex);
     auto p5 = std::make_shared<const pixel::Instance>(r1, m3);
-    list.AddPrimitive(p5.get());
+    primitives.push_back(p5.get());
 
     auto r2 = std::make_shared<const pixel::Rectangle>(pixel::Translate(10.f, 10.f, 0.f) * pixel::RotateZ(90.f), 20.f,
                                                        20.f);
     auto p6 = std::make_shared<const pixel::Instance>(r2, m3);
-    list.AddPrimitive(p6.get());
+    primitives.push_back(p6.get());
 
     auto r3 = std::make_shared<const pixel::Rectangle>(pixel::Translate(-10.f, 10.f, 0.f) * pixel::RotateZ(-90.f), 20.f,
                                                        20.f);
     auto p7 = std::make_shared<const pixel::Instance>(r3, m3);
-    list.AddPrimitive(p7.get());
+    primitives.push_back(p7.get());
 
     auto r4 = std::make_shared<const pixel::Rectangle>(pixel::Translate(0.f, 10.f, -10.f) * pixel::RotateX(90.f), 20.f,
                                                        20.f);
     auto p8 = std::make_shared<const pixel::Instance>(r4, m3);
-    list.AddPrimitive(p8.get());
+    primitives.push_back(p8.get());
 
     auto r5 = std::make_shared<const pixel::Rectangle>(pixel::Translate(0.f, 20.f, 0.f) * pixel::RotateX(180.f), 20.f,
                                                        20.f);
     auto p9 = std::make_shared<const pixel::Instance>(r5, m3);
-    list.AddPrimitive(p9.get());
+    primitives.push_back(p9.get());
 
     auto sphere_light = std::make_shared<const pixel::Sphere>(pixel::Translate(0.f, 10.f, 0.f), 2.5f);
     auto rectangle_light = std::make_shared<const pixel::Rectangle>(
             pixel::Translate(0.f, 19.f, 0.f) * pixel::RotateX(180.f), 10.f, 10.f);
     auto emitting_mat = std::make_shared<const pixel::EmittingMaterial>(emission_tex);
     auto area_light = std::make_shared<const pixel::AreaLight>(rectangle_light, emitting_mat);
-    list.AddPrimitive(area_light.get());
+    primitives.push_back(area_light.get());
+
+    // Build acceleration structure
+    pixel::BVHAccelerator bvh(primitives);
 
     // Create scene
-    pixel::Scene scene(&list);
+    pixel::Scene scene(&bvh);
 
     // Add light
     scene.AddLight(area_light.get());
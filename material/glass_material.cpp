@@ -34,16 +34,34 @@ namespace pixel {
     }
 
     std::unique_ptr<BSDF> GlassMaterial::GetBSDF(const SurfaceInteraction &interaction) const {
-        // Allocate BSDF
-        auto bsdf = std::make_unique<BSDF>(interaction);
         // Evaluate textures
-        const SSESpectrum ref = R->Evaluate(interaction);
-        const SSESpectrum trans = T->Evaluate(interaction);
-        const float r_i = r_index->Evaluate(interaction);
+        return CreateBSDF(interaction, R->Evaluate(interaction), T->Evaluate(interaction),
+                          r_index->Evaluate(interaction));
+    }
+
+    void GlassMaterial::GetBSDFs(SurfaceInteraction *const *const interactions, uint32_t count) const {
+        if (count == 0) { return; }
+        const bool constant_ref = R->IsConstant(), constant_trans = T->IsConstant();
+        const bool constant_r_i = r_index->IsConstant();
+        const SSESpectrum group_ref = constant_ref ? R->Evaluate(*interactions[0]) : SSESpectrum(0.f);
+        const SSESpectrum group_trans = constant_trans ? T->Evaluate(*interactions[0]) : SSESpectrum(0.f);
+        const float group_r_i = constant_r_i ? r_index->Evaluate(*interactions[0]) : 1.f;
+        for (uint32_t i = 0; i < count; i++) {
+            SurfaceInteraction &interaction = *interactions[i];
+            interaction.bsdf = CreateBSDF(interaction, constant_ref ? group_ref : R->Evaluate(interaction),
+                                          constant_trans ? group_trans : T->Evaluate(interaction),
+                                          constant_r_i ? group_r_i : r_index->Evaluate(interaction));
+        }
+    }
+
+    std::unique_ptr<BSDF> GlassMaterial::CreateBSDF(const SurfaceInteraction &interaction, const SSESpectrum &ref,
+                                                    const SSESpectrum &trans, float r_i) {
+        // Allocate BSDF
+        auto bsdf = std::make_unique<BSDF>(interaction, r_i);
         // Add simple Fresnel specular BRDF
         if (!IsBlack(ref) && !IsBlack(trans)) {
-            bsdf->AddBRDF(new SpecularReflection(ref, new FresnelDielectric(1.f, r_i)));
-            bsdf->AddBRDF(new SpecularTransmission(trans, 1.f, r_i));
+            bsdf->AddBRDF(SpecularReflection(ref, Fresnel(1.f, r_i)));
+            bsdf->AddBRDF(SpecularTransmission(trans, 1.f, r_i));
         }
 
         return bsdf;
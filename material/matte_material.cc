@@ -33,16 +33,31 @@ namespace pixel {
     }
 
     std::unique_ptr<BSDF> MatteMaterial::GetBSDF(const SurfaceInteraction &interaction) const {
+        // Evaluate textures
+        return CreateBSDF(interaction, Kd->Evaluate(interaction), sigma->Evaluate(interaction));
+    }
+
+    void MatteMaterial::GetBSDFs(SurfaceInteraction *const *const interactions, uint32_t count) const {
+        if (count == 0) { return; }
+        const bool constant_rho = Kd->IsConstant(), constant_sig = sigma->IsConstant();
+        const SSESpectrum group_rho = constant_rho ? Kd->Evaluate(*interactions[0]) : SSESpectrum(0.f);
+        const float group_sig = constant_sig ? sigma->Evaluate(*interactions[0]) : 0.f;
+        for (uint32_t i = 0; i < count; i++) {
+            SurfaceInteraction &interaction = *interactions[i];
+            interaction.bsdf = CreateBSDF(interaction, constant_rho ? group_rho : Kd->Evaluate(interaction),
+                                          constant_sig ? group_sig : sigma->Evaluate(interaction));
+        }
+    }
+
+    std::unique_ptr<BSDF> MatteMaterial::CreateBSDF(const SurfaceInteraction &interaction, const SSESpectrum &rho,
+                                                    float sig) {
         // Allocate BSDF
         auto bsdf = std::make_unique<BSDF>(interaction);
-        // Evaluate textures
-        const SSESpectrum rho = Kd->Evaluate(interaction);
-        const float sig = sigma->Evaluate(interaction);
         if (!IsBlack(rho)) {
             if (sig == 0) {
-                bsdf->AddBRDF(new LambertianReflection(rho));
+                bsdf->AddBRDF(LambertianReflection(rho));
             } else {
-                bsdf->AddBRDF(new OrenNayar(rho, sig));
+                bsdf->AddBRDF(OrenNayar(rho, sig));
             }
         }
 
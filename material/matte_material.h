@@ -46,7 +46,13 @@ namespace pixel {
 
         std::unique_ptr<BSDF> GetBSDF(const SurfaceInteraction &interaction) const override;
 
+        void GetBSDFs(SurfaceInteraction *const *const interactions, uint32_t count) const override;
+
     private:
+        // Create the BSDF of an interaction from the values of the textures
+        static std::unique_ptr<BSDF> CreateBSDF(const SurfaceInteraction &interaction, const SSESpectrum &rho,
+                                                float sig);
+
         // Material diffuse color
         const std::shared_ptr<const TextureInterface<SSESpectrum>> Kd;
         const std::shared_ptr<const TextureInterface<float>> sigma;
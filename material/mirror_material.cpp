@@ -32,12 +32,25 @@ namespace pixel {
     }
 
     std::unique_ptr<BSDF> MirrorMaterial::GetBSDF(const SurfaceInteraction &interaction) const {
+        // Evaluate texture
+        return CreateBSDF(interaction, Km->Evaluate(interaction));
+    }
+
+    void MirrorMaterial::GetBSDFs(SurfaceInteraction *const *const interactions, uint32_t count) const {
+        if (count == 0) { return; }
+        const bool constant_R = Km->IsConstant();
+        const SSESpectrum group_R = constant_R ? Km->Evaluate(*interactions[0]) : SSESpectrum(0.f);
+        for (uint32_t i = 0; i < count; i++) {
+            SurfaceInteraction &interaction = *interactions[i];
+            interaction.bsdf = CreateBSDF(interaction, constant_R ? group_R : Km->Evaluate(interaction));
+        }
+    }
+
+    std::unique_ptr<BSDF> MirrorMaterial::CreateBSDF(const SurfaceInteraction &interaction, const SSESpectrum &R) {
         // Allocate BSDF
         auto bsdf = std::make_unique<BSDF>(interaction);
-        // Evaluate texture
-        const SSESpectrum R = Km->Evaluate(interaction);
         if (!IsBlack(R)) {
-            bsdf->AddBRDF(new SpecularReflection(R, new FresnelIdeal()));
+            bsdf->AddBRDF(SpecularReflection(R, Fresnel()));
         }
 
         return bsdf;
@@ -44,7 +44,12 @@ namespace pixel {
 
         std::unique_ptr<BSDF> GetBSDF(const SurfaceInteraction &interaction) const override;
 
+        void GetBSDFs(SurfaceInteraction *const *const interactions, uint32_t count) const override;
+
     private:
+        // Create the BSDF of an interaction from the value of the texture
+        static std::unique_ptr<BSDF> CreateBSDF(const SurfaceInteraction &interaction, const SSESpectrum &R);
+
         // Mirror reflectance
         const std::shared_ptr<const TextureInterface<SSESpectrum>> Km;
     };
@@ -0,0 +1,1011 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2016 simon.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "bvh.h"
+#include "ray.h"
+#include "parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+namespace pixel {
+
+    // SAH costs used to evaluate the hierarchy quality
+    static const float BVH_TRAVERSAL_COST = 1.2f;
+    static const float BVH_INTERSECTION_COST = 1.f;
+    // Maximum number of leaves of a treelet during the restructuring pass
+    static const uint32_t BVH_TREELET_SIZE = 7;
+    // Maximum traversal stack depth
+    static const uint32_t BVH_STACK_SIZE = 128;
+    // Degraded subtrees are rebuilt only if their cost increase is at least this fraction of the total cost
+    static const float BVH_MIN_REBUILD_FRACTION = 0.01f;
+    // Marks the parent of the root node
+    static const uint32_t BVH_INVALID_NODE = 0xFFFFFFFF;
+    // Quantized leaf references store the primitive count minus one and the offset of the first primitive
+    static const uint32_t BVH_LEAF_FLAG = 0x80000000;
+    static const uint32_t BVH_LEAF_COUNT_SHIFT = 27;
+    static const uint32_t BVH_LEAF_OFFSET_MASK = (1u << BVH_LEAF_COUNT_SHIFT) - 1;
+    // Range of the quantization grid exponents, cells must be normal floats
+    static const int32_t BVH_MIN_EXPONENT = -126;
+    static const int32_t BVH_MAX_EXPONENT = 127;
+
+    static_assert(sizeof(QuantizedBVHNode) == 36, "QuantizedBVHNode is expected to be 36 bytes");
+
+    // Primitive with its Morton code, sorted during the build
+    struct MortonPrimitive {
+        uint32_t primitive_index;
+        uint64_t morton_code;
+    };
+
+    // Binary tree node produced by the LBVH build, before flattening
+    struct LBVHBuildNode {
+        BBox bounds;
+        uint32_t children[2];
+        uint32_t parent;
+        // SAH cost of the subtree
+        float cost;
+    };
+
+    // Spread the lower 10 bits of a value so that there are two zero bits between each of them
+    inline uint64_t LeftShift3(uint32_t x) {
+        x &= 0x3FF;
+        x = (x | (x << 16)) & 0x30000FF;
+        x = (x | (x << 8)) & 0x300F00F;
+        x = (x | (x << 4)) & 0x30C30C3;
+        x = (x | (x << 2)) & 0x9249249;
+
+        return x;
+    }
+
+    // Spread the lower 21 bits of a value so that there are two zero bits between each of them
+    inline uint64_t LeftShift3_21(uint64_t x) {
+        x &= 0x1FFFFF;
+        x = (x | (x << 32)) & 0x1F00000000FFFFULL;
+        x = (x | (x << 16)) & 0x1F0000FF0000FFULL;
+        x = (x | (x << 8)) & 0x100F00F00F00F00FULL;
+        x = (x | (x << 4)) & 0x10C30C30C30C30C3ULL;
+        x = (x | (x << 2)) & 0x1249249249249249ULL;
+
+        return x;
+    }
+
+    uint64_t EncodeMorton(const SSEVector &p, MortonPrecision precision) {
+        if (precision == MortonPrecision::MORTON_30) {
+            const float scale = 1023.f;
+            return (LeftShift3(static_cast<uint32_t>(Clamp(p.z, 0.f, 1.f) * scale)) << 2) |
+                   (LeftShift3(static_cast<uint32_t>(Clamp(p.y, 0.f, 1.f) * scale)) << 1) |
+                   LeftShift3(static_cast<uint32_t>(Clamp(p.x, 0.f, 1.f) * scale));
+        }
+        const float scale = 2097151.f;
+
+        return (LeftShift3_21(static_cast<uint64_t>(Clamp(p.z, 0.f, 1.f) * scale)) << 2) |
+               (LeftShift3_21(static_cast<uint64_t>(Clamp(p.y, 0.f, 1.f) * scale)) << 1) |
+               LeftShift3_21(static_cast<uint64_t>(Clamp(p.x, 0.f, 1.f) * scale));
+    }
+
+    // Sort primitives by Morton code using a least significant digit radix sort.
+    // Each pass splits the array in one chunk per core, builds the per chunk histograms in parallel
+    // and scatters the chunks in parallel at their prefix sum offsets, which keeps the sort stable
+    static void RadixSort(std::vector<MortonPrimitive> *const v, uint32_t n_bits) {
+        const uint32_t bits_per_pass = 8;
+        const uint32_t n_buckets = 1 << bits_per_pass;
+        const uint32_t n_passes = (n_bits + bits_per_pass - 1) / bits_per_pass;
+        const uint32_t n = static_cast<uint32_t>(v->size());
+        const uint32_t n_chunks = FMin(NumSystemCores(), FMax(1u, n / 4096));
+        const uint32_t chunk_size = (n + n_chunks - 1) / n_chunks;
+
+        std::vector<MortonPrimitive> temp(n);
+        std::vector<uint32_t> histograms(n_chunks * n_buckets);
+        for (uint32_t pass = 0; pass < n_passes; pass++) {
+            const uint32_t low_bit = pass * bits_per_pass;
+            const std::vector<MortonPrimitive> &in = (pass & 1) ? temp : *v;
+            std::vector<MortonPrimitive> &out = (pass & 1) ? *v : temp;
+            // Count bucket sizes for each chunk
+            std::fill(histograms.begin(), histograms.end(), 0);
+            ParallelFor(n_chunks, [&](uint32_t begin, uint32_t end) {
+                for (uint32_t c = begin; c < end; c++) {
+                    uint32_t *hist = &histograms[c * n_buckets];
+                    for (uint32_t i = c * chunk_size; i < FMin((c + 1) * chunk_size, n); i++) {
+                        hist[(in[i].morton_code >> low_bit) & (n_buckets - 1)]++;
+                    }
+                }
+            }, 1);
+            // Compute output offsets, buckets first and then chunks
+            uint32_t offset = 0;
+            for (uint32_t b = 0; b < n_buckets; b++) {
+                for (uint32_t c = 0; c < n_chunks; c++) {
+                    uint32_t count = histograms[c * n_buckets + b];
+                    histograms[c * n_buckets + b] = offset;
+                    offset += count;
+                }
+            }
+            // Scatter values
+            ParallelFor(n_chunks, [&](uint32_t begin, uint32_t end) {
+                for (uint32_t c = begin; c < end; c++) {
+                    uint32_t *hist = &histograms[c * n_buckets];
+                    for (uint32_t i = c * chunk_size; i < FMin((c + 1) * chunk_size, n); i++) {
+                        out[hist[(in[i].morton_code >> low_bit) & (n_buckets - 1)]++] = in[i];
+                    }
+                }
+            }, 1);
+        }
+        // Odd number of passes leave the result in the temporary buffer
+        if (n_passes & 1) {
+            v->swap(temp);
+        }
+    }
+
+    // Length of the common prefix of the codes at i and j, ties are broken using the indices.
+    // Returns -1 for indices outside the range
+    inline int32_t CommonPrefix(const std::vector<MortonPrimitive> &sorted, int32_t i, int32_t j) {
+        if (j < 0 || j >= static_cast<int32_t>(sorted.size())) {
+            return -1;
+        }
+        uint64_t ci = sorted[i].morton_code;
+        uint64_t cj = sorted[j].morton_code;
+        if (ci == cj) {
+            return 64 + __builtin_clz(static_cast<uint32_t>(i ^ j));
+        }
+
+        return __builtin_clzll(ci ^ cj);
+    }
+
+    // Find children of interior node i following Karras, "Maximizing Parallelism in the Construction of
+    // BVHs, Octrees, and k-d Trees". Interior nodes are stored in [0, n - 1), leaves in [n - 1, 2n - 1)
+    static void EmitInteriorNode(const std::vector<MortonPrimitive> &sorted, std::vector<LBVHBuildNode> *const nodes,
+                                 int32_t i) {
+        const int32_t n = static_cast<int32_t>(sorted.size());
+        // Direction of the range covered by the node
+        const int32_t d = (CommonPrefix(sorted, i, i + 1) - CommonPrefix(sorted, i, i - 1)) >= 0 ? 1 : -1;
+        // Upper bound for the range length
+        const int32_t delta_min = CommonPrefix(sorted, i, i - d);
+        int32_t l_max = 2;
+        while (CommonPrefix(sorted, i, i + l_max * d) > delta_min) {
+            l_max *= 2;
+        }
+        // Find the other end with a binary search
+        int32_t l = 0;
+        for (int32_t t = l_max / 2; t >= 1; t /= 2) {
+            if (CommonPrefix(sorted, i, i + (l + t) * d) > delta_min) {
+                l += t;
+            }
+        }
+        const int32_t j = i + l * d;
+        // Find the split position with a binary search
+        const int32_t delta_node = CommonPrefix(sorted, i, j);
+        int32_t s = 0;
+        int32_t t = l;
+        do {
+            t = (t + 1) / 2;
+            if (CommonPrefix(sorted, i, i + (s + t) * d) > delta_node) {
+                s += t;
+            }
+        } while (t > 1);
+        const int32_t gamma = i + s * d + FMin(d, 0);
+
+        // Output children
+        LBVHBuildNode &node = (*nodes)[i];
+        node.children[0] = (FMin(i, j) == gamma) ? (n - 1 + gamma) : gamma;
+        node.children[1] = (FMax(i, j) == gamma + 1) ? (n + gamma) : (gamma + 1);
+        (*nodes)[node.children[0]].parent = static_cast<uint32_t>(i);
+        (*nodes)[node.children[1]].parent = static_cast<uint32_t>(i);
+    }
+
+    // Find the optimal topology of the treelet rooted at the given node following Karras and Aila,
+    // "Fast Parallel Construction of High-Quality Bounding Volume Hierarchies".
+    // All the nodes of the subtree must have valid bounds and costs
+    static void RestructureTreelet(std::vector<LBVHBuildNode> *const nodes, uint32_t root, uint32_t n_leaves) {
+        std::vector<LBVHBuildNode> &tree = *nodes;
+        // Form treelet, expanding the leaf with the largest surface area at each step
+        uint32_t leaves[BVH_TREELET_SIZE];
+        uint32_t interiors[BVH_TREELET_SIZE - 1];
+        uint32_t n_treelet_leaves = 2;
+        uint32_t n_interiors = 1;
+        leaves[0] = tree[root].children[0];
+        leaves[1] = tree[root].children[1];
+        interiors[0] = root;
+        while (n_treelet_leaves < BVH_TREELET_SIZE) {
+            int32_t largest = -1;
+            float largest_area = -1.f;
+            for (uint32_t l = 0; l < n_treelet_leaves; l++) {
+                if (leaves[l] < n_leaves - 1 && tree[leaves[l]].bounds.SurfaceArea() > largest_area) {
+                    largest = l;
+                    largest_area = tree[leaves[l]].bounds.SurfaceArea();
+                }
+            }
+            if (largest < 0) { break; }
+            uint32_t expanded = leaves[largest];
+            interiors[n_interiors++] = expanded;
+            leaves[largest] = tree[expanded].children[0];
+            leaves[n_treelet_leaves++] = tree[expanded].children[1];
+        }
+        if (n_treelet_leaves < 3) { return; }
+
+        // Find optimal partitioning for every subset of the treelet leaves
+        const uint32_t n_subsets = 1u << n_treelet_leaves;
+        float area[1 << BVH_TREELET_SIZE];
+        float cost[1 << BVH_TREELET_SIZE];
+        uint32_t partition[1 << BVH_TREELET_SIZE];
+        for (uint32_t s = 1; s < n_subsets; s++) {
+            BBox bounds;
+            for (uint32_t l = 0; l < n_treelet_leaves; l++) {
+                if (s & (1u << l)) {
+                    bounds = BBoxUnion(bounds, tree[leaves[l]].bounds);
+                }
+            }
+            area[s] = bounds.SurfaceArea();
+        }
+        // Subsets of a set always have lower index, so they are processed first
+        for (uint32_t s = 1; s < n_subsets; s++) {
+            if ((s & (s - 1)) == 0) {
+                cost[s] = tree[leaves[__builtin_ctz(s)]].cost;
+                partition[s] = 0;
+                continue;
+            }
+            // Only consider partitions with the lowest bit on the left to skip mirrored ones
+            const uint32_t low_bit = s & (~s + 1);
+            float best_cost = INFINITY;
+            uint32_t best_partition = 0;
+            for (uint32_t p = (s - 1) & s; p > 0; p = (p - 1) & s) {
+                if (!(p & low_bit)) { continue; }
+                float c = cost[p] + cost[s ^ p];
+                if (c < best_cost) {
+                    best_cost = c;
+                    best_partition = p;
+                }
+            }
+            cost[s] = BVH_TRAVERSAL_COST * area[s] + best_cost;
+            partition[s] = best_partition;
+        }
+        const uint32_t all = n_subsets - 1;
+        if (cost[all] >= tree[root].cost * (1.f - EPS)) { return; }
+
+        // Rebuild treelet reusing the interior nodes, the root is the first one to be emitted
+        uint32_t next_interior = 0;
+        std::function<uint32_t(uint32_t, uint32_t)> emit = [&](uint32_t s, uint32_t parent) -> uint32_t {
+            if ((s & (s - 1)) == 0) {
+                uint32_t leaf = leaves[__builtin_ctz(s)];
+                tree[leaf].parent = parent;
+                return leaf;
+            }
+            uint32_t node = interiors[next_interior++];
+            tree[node].parent = parent;
+            tree[node].children[0] = emit(partition[s], node);
+            tree[node].children[1] = emit(s ^ partition[s], node);
+            tree[node].bounds = BBoxUnion(tree[tree[node].children[0]].bounds,
+                                          tree[tree[node].children[1]].bounds);
+            tree[node].cost = cost[s];
+            return node;
+        };
+        emit(all, tree[root].parent);
+    }
+
+    // Flatten the build hierarchy in depth first order
+    static uint32_t FlattenBVH(const std::vector<LBVHBuildNode> &build_nodes, uint32_t node, uint32_t n_leaves,
+                               uint32_t primitive_begin, std::vector<LinearBVHNode> *const nodes,
+                               std::vector<float> *const costs, uint32_t *const offset) {
+        const uint32_t linear_offset = (*offset)++;
+        LinearBVHNode &linear_node = (*nodes)[linear_offset];
+        linear_node.bounds = build_nodes[node].bounds;
+        linear_node.pad = 0;
+        (*costs)[linear_offset] = build_nodes[node].cost;
+        if (node >= n_leaves - 1) {
+            linear_node.primitive_offset = primitive_begin + node - (n_leaves - 1);
+            linear_node.n_primitives = 1;
+            linear_node.axis = 0;
+        } else {
+            linear_node.n_primitives = 0;
+            linear_node.axis = static_cast<uint8_t>(build_nodes[node].bounds.MaximumExtent());
+            FlattenBVH(build_nodes, build_nodes[node].children[0], n_leaves, primitive_begin, nodes, costs, offset);
+            uint32_t second = FlattenBVH(build_nodes, build_nodes[node].children[1], n_leaves, primitive_begin,
+                                         nodes, costs, offset);
+            (*nodes)[linear_offset].second_child_offset = second;
+        }
+
+        return linear_offset;
+    }
+
+    BVHAccelerator::BVHAccelerator(const std::vector<const PrimitiveInterface *> &p, MortonPrecision precision,
+                                   bool optimize_treelets, BVHNodeFormat format)
+            : primitives(p), precision(precision), optimize_treelets(optimize_treelets), format(format),
+              root_reference(BVH_INVALID_NODE), quantized_cost(0.f), quantized_build_cost(0.f) {
+        Build();
+        Finalize();
+    }
+
+    BVHAccelerator::BVHAccelerator(const std::vector<const PrimitiveInterface *> &p, const std::string &cache_file,
+                                   MortonPrecision precision, bool optimize_treelets, BVHNodeFormat format)
+            : primitives(p), precision(precision), optimize_treelets(optimize_treelets), format(format),
+              root_reference(BVH_INVALID_NODE), quantized_cost(0.f), quantized_build_cost(0.f) {
+        const uint64_t scene_hash = SceneHash();
+        if (!LoadCache(cache_file, scene_hash)) {
+            Build();
+            Finalize();
+            SaveCache(cache_file, p, scene_hash);
+        }
+    }
+
+    void BVHAccelerator::Build() {
+        nodes.clear();
+        subtree_costs.clear();
+        const uint32_t n = static_cast<uint32_t>(primitives.size());
+        if (n == 0) { return; }
+        nodes.resize(2 * n - 1);
+        subtree_costs.resize(2 * n - 1);
+        BuildRange(0, n, 0);
+    }
+
+    void BVHAccelerator::BuildRange(uint32_t primitive_begin, uint32_t primitive_end, uint32_t node_offset) {
+        const uint32_t n = primitive_end - primitive_begin;
+
+        // Compute primitives bounds and the bounds of their centroids
+        std::vector<BBox> primitive_bounds(n);
+        ParallelFor(n, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; i++) {
+                primitive_bounds[i] = primitives[primitive_begin + i]->PrimitiveBounding();
+            }
+        });
+        BBox centroid_bounds;
+        for (uint32_t i = 0; i < n; i++) {
+            centroid_bounds = BBoxUnion(centroid_bounds, primitive_bounds[i].Centroid());
+        }
+
+        // Compute Morton codes and sort them
+        std::vector<MortonPrimitive> sorted(n);
+        ParallelFor(n, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; i++) {
+                sorted[i].primitive_index = i;
+                sorted[i].morton_code = EncodeMorton(centroid_bounds.Offset(primitive_bounds[i].Centroid()),
+                                                     precision);
+            }
+        });
+        RadixSort(&sorted, precision == MortonPrecision::MORTON_30 ? 30 : 63);
+
+        // Emit hierarchy, each interior node is independent from the others
+        std::vector<LBVHBuildNode> build_nodes(2 * n - 1);
+        build_nodes[0].parent = BVH_INVALID_NODE;
+        ParallelFor(n - 1, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; i++) {
+                EmitInteriorNode(sorted, &build_nodes, static_cast<int32_t>(i));
+            }
+        });
+
+        // Compute bounds bottom-up, the second thread reaching a node processes it
+        std::unique_ptr<std::atomic<uint32_t>[]> visits(new std::atomic<uint32_t>[n]);
+        for (uint32_t i = 0; i < n; i++) {
+            visits[i].store(0, std::memory_order_relaxed);
+        }
+        ParallelFor(n, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; i++) {
+                LBVHBuildNode &leaf = build_nodes[n - 1 + i];
+                leaf.bounds = primitive_bounds[sorted[i].primitive_index];
+                leaf.cost = BVH_INTERSECTION_COST * leaf.bounds.SurfaceArea();
+                if (n == 1) { break; }
+                uint32_t current = leaf.parent;
+                while (current != BVH_INVALID_NODE) {
+                    if (visits[current].fetch_add(1, std::memory_order_acq_rel) == 0) { break; }
+                    LBVHBuildNode &node = build_nodes[current];
+                    const LBVHBuildNode &left = build_nodes[node.children[0]];
+                    const LBVHBuildNode &right = build_nodes[node.children[1]];
+                    node.bounds = BBoxUnion(left.bounds, right.bounds);
+                    node.cost = BVH_TRAVERSAL_COST * node.bounds.SurfaceArea() + left.cost + right.cost;
+                    if (optimize_treelets) {
+                        RestructureTreelet(&build_nodes, current, n);
+                    }
+                    current = node.parent;
+                }
+            }
+        }, 256);
+
+        // Reorder primitives following the leaves
+        std::vector<const PrimitiveInterface *> ordered(n);
+        for (uint32_t i = 0; i < n; i++) {
+            ordered[i] = primitives[primitive_begin + sorted[i].primitive_index];
+        }
+        std::copy(ordered.begin(), ordered.end(), primitives.begin() + primitive_begin);
+
+        // Flatten the tree, a single primitive is stored as a leaf root
+        uint32_t offset = node_offset;
+        FlattenBVH(build_nodes, 0, n, primitive_begin, &nodes, &subtree_costs, &offset);
+    }
+
+    RefitResult BVHAccelerator::Refit(float rebuild_threshold) {
+        if (format == BVHNodeFormat::QUANTIZED) {
+            if (root_reference == BVH_INVALID_NODE) { return RefitResult::REFIT; }
+            // The compressed nodes cannot be rebuilt in place, rebuild everything once the cost degrades
+            RefitQuantized();
+            if (quantized_cost > quantized_build_cost * rebuild_threshold) {
+                Build();
+                Finalize();
+                return RefitResult::FULL_REBUILD;
+            }
+            return RefitResult::REFIT;
+        }
+        if (nodes.empty()) { return RefitResult::REFIT; }
+        RefitBounds();
+
+        // Find the highest degraded subtrees, primitives may have moved anywhere inside them
+        auto is_degraded = [&](uint32_t node) {
+            return nodes[node].n_primitives == 0 && subtree_costs[node] > build_costs[node] * rebuild_threshold &&
+                   subtree_costs[node] - build_costs[node] > BVH_MIN_REBUILD_FRACTION * subtree_costs[0];
+        };
+        std::vector<uint32_t> degraded;
+        for (uint32_t i = 0; i < nodes.size();) {
+            if (is_degraded(i)) {
+                degraded.push_back(i);
+                // Skip the subtree, it is going to be rebuilt
+                i += SubtreeSize(i);
+            } else {
+                i++;
+            }
+        }
+        if (degraded.empty()) { return RefitResult::REFIT; }
+
+        // Rebuild everything if the degraded subtrees cover most of the primitives
+        uint32_t degraded_primitives = 0;
+        for (uint32_t node : degraded) {
+            degraded_primitives += (SubtreeSize(node) + 1) / 2;
+        }
+        if (degraded_primitives > primitives.size() / 2) {
+            Build();
+            build_costs = subtree_costs;
+            return RefitResult::FULL_REBUILD;
+        }
+
+        // A subtree is rebuilt in place over the primitives range of its leaves. Treelet restructuring moves
+        // leaves between subtrees, so check the leaves still cover a single range before relying on it
+        std::vector<uint32_t> range_begins(degraded.size());
+        for (size_t d = 0; d < degraded.size(); d++) {
+            const uint32_t node = degraded[d];
+            const uint32_t size = SubtreeSize(node);
+            uint32_t range_begin = static_cast<uint32_t>(primitives.size()), range_end = 0, count = 0;
+            for (uint32_t i = node; i < node + size; i++) {
+                if (nodes[i].n_primitives == 0) { continue; }
+                range_begin = std::min(range_begin, nodes[i].primitive_offset);
+                range_end = std::max(range_end, nodes[i].primitive_offset + nodes[i].n_primitives);
+                count += nodes[i].n_primitives;
+            }
+            if (range_end - range_begin != count || 2 * count - 1 != size) {
+                Build();
+                build_costs = subtree_costs;
+                return RefitResult::FULL_REBUILD;
+            }
+            range_begins[d] = range_begin;
+        }
+
+        // Rebuild the degraded subtrees in place, the LBVH of k primitives always takes 2k - 1 nodes
+        const float root_build_cost = build_costs[0];
+        for (size_t d = 0; d < degraded.size(); d++) {
+            const uint32_t node = degraded[d];
+            const uint32_t count = (SubtreeSize(node) + 1) / 2;
+            BuildRange(range_begins[d], range_begins[d] + count, node);
+            std::copy(subtree_costs.begin() + node, subtree_costs.begin() + node + 2 * count - 1,
+                      build_costs.begin() + node);
+        }
+        // Propagate the new bounds to the ancestors. Primitives that moved far away from their subtree
+        // are not fixed by a local rebuild, fall back to a full one if the overall cost is still too high
+        RefitBounds();
+        if (subtree_costs[0] > root_build_cost * rebuild_threshold) {
+            Build();
+            build_costs = subtree_costs;
+            return RefitResult::FULL_REBUILD;
+        }
+        // Accept the current cost of the ancestors
+        for (uint32_t i = 0; i < nodes.size(); i++) {
+            if (nodes[i].n_primitives == 0) {
+                build_costs[i] = FMax(build_costs[i], subtree_costs[i]);
+            }
+        }
+
+        return RefitResult::PARTIAL_REBUILD;
+    }
+
+    void BVHAccelerator::RefitBounds() {
+        const uint32_t n_nodes = static_cast<uint32_t>(nodes.size());
+        // Find the parent of each node, children are always stored after their parent
+        std::vector<uint32_t> parents(n_nodes);
+        parents[0] = BVH_INVALID_NODE;
+        for (uint32_t i = 0; i < n_nodes; i++) {
+            if (nodes[i].n_primitives == 0) {
+                parents[i + 1] = i;
+                parents[nodes[i].second_child_offset] = i;
+            }
+        }
+
+        // Update leaves and propagate bounds bottom-up, the second thread reaching a node processes it
+        std::unique_ptr<std::atomic<uint32_t>[]> visits(new std::atomic<uint32_t>[n_nodes]);
+        for (uint32_t i = 0; i < n_nodes; i++) {
+            visits[i].store(0, std::memory_order_relaxed);
+        }
+        ParallelFor(n_nodes, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; i++) {
+                LinearBVHNode &leaf = nodes[i];
+                if (leaf.n_primitives == 0) { continue; }
+                leaf.bounds = BBox();
+                for (uint32_t p = 0; p < leaf.n_primitives; p++) {
+                    leaf.bounds = BBoxUnion(leaf.bounds, primitives[leaf.primitive_offset + p]->PrimitiveBounding());
+                }
+                subtree_costs[i] = BVH_INTERSECTION_COST * leaf.n_primitives * leaf.bounds.SurfaceArea();
+                uint32_t current = parents[i];
+                while (current != BVH_INVALID_NODE) {
+                    if (visits[current].fetch_add(1, std::memory_order_acq_rel) == 0) { break; }
+                    LinearBVHNode &node = nodes[current];
+                    node.bounds = BBoxUnion(nodes[current + 1].bounds, nodes[node.second_child_offset].bounds);
+                    subtree_costs[current] = BVH_TRAVERSAL_COST * node.bounds.SurfaceArea() +
+                                             subtree_costs[current + 1] + subtree_costs[node.second_child_offset];
+                    current = parents[current];
+                }
+            }
+        }, 256);
+    }
+
+    bool BVHAccelerator::ValidNodes() const {
+        const uint32_t n = static_cast<uint32_t>(primitives.size());
+        const uint32_t n_nodes = static_cast<uint32_t>(nodes.size());
+        if (subtree_costs.size() != n_nodes || build_costs.size() != n_nodes) { return false; }
+        // Children are stored after their parents, so the depths are final when a node is reached. Each interior
+        // node on the path to a leaf can push one node on the traversal stack, which must not overflow
+        std::vector<uint32_t> depths(n_nodes, 0);
+        for (uint32_t i = 0; i < n_nodes; i++) {
+            const LinearBVHNode &node = nodes[i];
+            if (node.n_primitives > 0) {
+                if (node.primitive_offset > n || node.n_primitives > n - node.primitive_offset) { return false; }
+            } else if (i + 1 >= n_nodes || node.second_child_offset <= i + 1 || node.second_child_offset >= n_nodes ||
+                       depths[i] >= BVH_STACK_SIZE) {
+                return false;
+            } else {
+                depths[i + 1] = std::max(depths[i + 1], depths[i] + 1);
+                depths[node.second_child_offset] = std::max(depths[node.second_child_offset], depths[i] + 1);
+            }
+        }
+        // A quantized reference is valid if it points after from, the parent node
+        const uint32_t n_quantized = static_cast<uint32_t>(quantized_nodes.size());
+        auto valid_reference = [&](uint32_t reference, uint32_t from) {
+            if (reference & BVH_LEAF_FLAG) {
+                const uint32_t offset = reference & BVH_LEAF_OFFSET_MASK;
+                const uint32_t count = ((reference & ~BVH_LEAF_FLAG) >> BVH_LEAF_COUNT_SHIFT) + 1;
+                return offset <= n && count <= n - offset;
+            }
+            return reference < n_quantized && (from == BVH_INVALID_NODE || reference > from);
+        };
+        if (format == BVHNodeFormat::QUANTIZED) {
+            if (n_nodes != 0 || (root_reference == BVH_INVALID_NODE) != (n == 0)) { return false; }
+            if (n > 0 && !valid_reference(root_reference, BVH_INVALID_NODE)) { return false; }
+        } else if (n_quantized != 0 || n_nodes != (n > 0 ? 2 * n - 1 : 0)) {
+            return false;
+        }
+        std::vector<uint32_t> quantized_depths(n_quantized, 0);
+        for (uint32_t i = 0; i < n_quantized; i++) {
+            if (quantized_depths[i] >= BVH_STACK_SIZE) { return false; }
+            for (uint32_t c = 0; c < 2; c++) {
+                const uint32_t child = quantized_nodes[i].children[c];
+                if (!valid_reference(child, i)) { return false; }
+                if (!(child & BVH_LEAF_FLAG)) {
+                    quantized_depths[child] = std::max(quantized_depths[child], quantized_depths[i] + 1);
+                }
+            }
+        }
+
+        return true;
+    }
+
+    uint32_t BVHAccelerator::SubtreeSize(uint32_t node) const {
+        // The rightmost leaf of the subtree is the last node stored for it
+        uint32_t last = node;
+        while (nodes[last].n_primitives == 0) {
+            last = nodes[last].second_child_offset;
+        }
+
+        return last - node + 1;
+    }
+
+    // Component of a vector along the given axis
+    inline float AxisComponent(const SSEVector &v, uint32_t axis) {
+        return (axis == 0) ? v.x : ((axis == 1) ? v.y : v.z);
+    }
+
+    // Compute the children bounds of a quantized node, parent must enclose both children
+    static void QuantizeNode(const BBox &parent, const BBox children[2], QuantizedBVHNode *const node) {
+        for (uint32_t a = 0; a < 3; a++) {
+            const float origin = AxisComponent(parent.Min(), a);
+            const float extent = AxisComponent(parent.Max(), a) - origin;
+            // Smallest power of two cell covering the extent with 255 cells
+            int32_t exponent = BVH_MIN_EXPONENT;
+            if (extent > 0.f) {
+                int32_t e;
+                const float m = std::frexp(extent / 255.f, &e);
+                exponent = Clamp(m == 0.5f ? e - 1 : e, BVH_MIN_EXPONENT, BVH_MAX_EXPONENT);
+            }
+            const float scale = std::ldexp(1.f, exponent);
+            node->origin[a] = origin;
+            node->exponent[a] = static_cast<int8_t>(exponent);
+            // Round outwards, checking against the same arithmetic used to decode
+            for (uint32_t c = 0; c < 2; c++) {
+                const float c_min = AxisComponent(children[c].Min(), a);
+                const float c_max = AxisComponent(children[c].Max(), a);
+                int32_t q_min = Clamp(static_cast<int32_t>(std::floor((c_min - origin) / scale)), 0, 255);
+                while (q_min > 0 && origin + q_min * scale > c_min) { q_min--; }
+                int32_t q_max = Clamp(static_cast<int32_t>(std::ceil((c_max - origin) / scale)), 0, 255);
+                while (q_max < 255 && origin + q_max * scale < c_max) { q_max++; }
+                node->q_bounds[a][c] = static_cast<uint8_t>(q_min);
+                node->q_bounds[a][2 + c] = static_cast<uint8_t>(q_max);
+            }
+        }
+        node->pad = 0;
+    }
+
+    void BVHAccelerator::Finalize() {
+        if (format == BVHNodeFormat::FULL) {
+            build_costs = subtree_costs;
+            return;
+        }
+        quantized_nodes.clear();
+        if (nodes.empty()) {
+            root_bounds = BBox();
+            root_reference = BVH_INVALID_NODE;
+            quantized_cost = quantized_build_cost = 0.f;
+            return;
+        }
+        // Interior nodes of the quantized hierarchy describe both their children
+        quantized_nodes.reserve(nodes.size() / 2);
+        root_bounds = nodes[0].bounds;
+        root_reference = QuantizeSubtree(0);
+        quantized_cost = quantized_build_cost = subtree_costs[0];
+        // Full nodes are only needed to build
+        std::vector<LinearBVHNode>().swap(nodes);
+        std::vector<float>().swap(subtree_costs);
+        std::vector<float>().swap(build_costs);
+    }
+
+    uint32_t BVHAccelerator::QuantizeSubtree(uint32_t node) {
+        const LinearBVHNode &full_node = nodes[node];
+        if (full_node.n_primitives > 0) {
+            assert(full_node.primitive_offset <= BVH_LEAF_OFFSET_MASK && full_node.n_primitives <= 16);
+            return BVH_LEAF_FLAG | (static_cast<uint32_t>(full_node.n_primitives - 1) << BVH_LEAF_COUNT_SHIFT) |
+                   full_node.primitive_offset;
+        }
+        const uint32_t reference = static_cast<uint32_t>(quantized_nodes.size());
+        quantized_nodes.emplace_back();
+        const uint32_t first = QuantizeSubtree(node + 1);
+        const uint32_t second = QuantizeSubtree(full_node.second_child_offset);
+        const BBox children[2] = {nodes[node + 1].bounds, nodes[full_node.second_child_offset].bounds};
+        QuantizedBVHNode &quantized_node = quantized_nodes[reference];
+        QuantizeNode(full_node.bounds, children, &quantized_node);
+        quantized_node.children[0] = first;
+        quantized_node.children[1] = second;
+
+        return reference;
+    }
+
+    // Bounds and SAH cost of the primitives of a quantized leaf reference
+    static BBox QuantizedLeafBounds(const std::vector<const PrimitiveInterface *> &primitives, uint32_t reference,
+                                    float *const cost) {
+        const uint32_t offset = reference & BVH_LEAF_OFFSET_MASK;
+        const uint32_t count = ((reference & ~BVH_LEAF_FLAG) >> BVH_LEAF_COUNT_SHIFT) + 1;
+        BBox bounds;
+        for (uint32_t i = 0; i < count; i++) {
+            bounds = BBoxUnion(bounds, primitives[offset + i]->PrimitiveBounding());
+        }
+        *cost = BVH_INTERSECTION_COST * count * bounds.SurfaceArea();
+
+        return bounds;
+    }
+
+    void BVHAccelerator::RefitQuantized() {
+        if (root_reference & BVH_LEAF_FLAG) {
+            root_bounds = QuantizedLeafBounds(primitives, root_reference, &quantized_cost);
+            return;
+        }
+        const uint32_t n_nodes = static_cast<uint32_t>(quantized_nodes.size());
+        // Find the parent of each interior node and which of its children it is
+        std::vector<uint32_t> parents(n_nodes);
+        std::vector<uint8_t> parent_slots(n_nodes, 0);
+        parents[root_reference] = BVH_INVALID_NODE;
+        for (uint32_t i = 0; i < n_nodes; i++) {
+            for (uint32_t c = 0; c < 2; c++) {
+                const uint32_t child = quantized_nodes[i].children[c];
+                if (child & BVH_LEAF_FLAG) { continue; }
+                parents[child] = i;
+                parent_slots[child] = static_cast<uint8_t>(c);
+            }
+        }
+
+        // Bounds and costs of the children of each node, filled as they are refitted
+        std::vector<BBox> children_bounds(2 * n_nodes);
+        std::vector<float> children_costs(2 * n_nodes);
+        std::unique_ptr<std::atomic<uint32_t>[]> visits(new std::atomic<uint32_t>[n_nodes]);
+        for (uint32_t i = 0; i < n_nodes; i++) {
+            visits[i].store(0, std::memory_order_relaxed);
+        }
+
+        // Refit the leaves and propagate bounds bottom-up, the thread storing the second child processes a node
+        ParallelFor(n_nodes, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; i++) {
+                for (uint32_t c = 0; c < 2; c++) {
+                    const uint32_t child = quantized_nodes[i].children[c];
+                    if (!(child & BVH_LEAF_FLAG)) { continue; }
+                    children_bounds[2 * i + c] = QuantizedLeafBounds(primitives, child, &children_costs[2 * i + c]);
+                    uint32_t current = i;
+                    while (current != BVH_INVALID_NODE) {
+                        if (visits[current].fetch_add(1, std::memory_order_acq_rel) == 0) { break; }
+                        const BBox *const children = &children_bounds[2 * current];
+                        const BBox bounds = BBoxUnion(children[0], children[1]);
+                        QuantizeNode(bounds, children, &quantized_nodes[current]);
+                        const float cost = BVH_TRAVERSAL_COST * bounds.SurfaceArea() +
+                                           children_costs[2 * current] + children_costs[2 * current + 1];
+                        const uint32_t parent = parents[current];
+                        if (parent == BVH_INVALID_NODE) {
+                            root_bounds = bounds;
+                            quantized_cost = cost;
+                        } else {
+                            children_bounds[2 * parent + parent_slots[current]] = bounds;
+                            children_costs[2 * parent + parent_slots[current]] = cost;
+                        }
+                        current = parent;
+                    }
+                }
+            }
+        }, 256);
+    }
+
+    // Clip the ray parametric range against the slabs of both children of a quantized node along one axis.
+    // Bounds are decoded as origin + q * 2^exponent, lanes hold first min, second min, first max, second max
+    template <int Axis>
+    inline void ClipChildrenSlab(const QuantizedBVHNode &node, const __m128 &scales, const __m128 &node_origin,
+                                 const __m128 &ray_origin, const __m128 &inv_dir,
+                                 __m128 *const t_near, __m128 *const t_far) {
+        int32_t packed;
+        std::memcpy(&packed, node.q_bounds[Axis], sizeof(int32_t));
+        const __m128 q = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(packed)));
+        const __m128 scale = _mm_shuffle_ps(scales, scales, _MM_SHUFFLE(Axis, Axis, Axis, Axis));
+        const __m128 origin = _mm_shuffle_ps(node_origin, node_origin, _MM_SHUFFLE(Axis, Axis, Axis, Axis));
+        const __m128 bounds = _mm_add_ps(_mm_mul_ps(q, scale), origin);
+        const __m128 t = _mm_mul_ps(_mm_sub_ps(bounds, ray_origin), inv_dir);
+        // Swapping minimum and maximum planes handles negative directions
+        const __m128 t_swap = _mm_shuffle_ps(t, t, _MM_SHUFFLE(1, 0, 3, 2));
+        *t_near = _mm_max_ps(_mm_min_ps(t, t_swap), *t_near);
+        *t_far = _mm_min_ps(_mm_max_ps(t, t_swap), *t_far);
+    }
+
+    // Intersect the ray with both children of a quantized node within [t_min, t_max]. Returns a two bit mask of
+    // the children hit, their entry distances are stored in the first two lanes of t_entry
+    inline int32_t IntersectChildren(const QuantizedBVHNode &node, const __m128 ray_origin[3],
+                                     const __m128 inv_dir[3], float t_min, float t_max, __m128 *const t_entry) {
+        // Build the cell sizes directly from the exponents bits
+        int32_t packed_exponents;
+        std::memcpy(&packed_exponents, node.exponent, sizeof(int32_t));
+        const __m128i exponents = _mm_cvtepi8_epi32(_mm_cvtsi32_si128(packed_exponents));
+        const __m128 scales = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(exponents, _mm_set1_epi32(127)), 23));
+        const __m128 node_origin = _mm_set_ps(0.f, node.origin[2], node.origin[1], node.origin[0]);
+        __m128 t_near = _mm_set1_ps(t_min);
+        __m128 t_far = _mm_set1_ps(t_max);
+        ClipChildrenSlab<0>(node, scales, node_origin, ray_origin[0], inv_dir[0], &t_near, &t_far);
+        ClipChildrenSlab<1>(node, scales, node_origin, ray_origin[1], inv_dir[1], &t_near, &t_far);
+        ClipChildrenSlab<2>(node, scales, node_origin, ray_origin[2], inv_dir[2], &t_near, &t_far);
+        *t_entry = t_near;
+
+        return _mm_movemask_ps(_mm_cmple_ps(t_near, t_far)) & 0x3;
+    }
+
+    bool BVHAccelerator::IntersectQuantized(const Ray &ray, SurfaceInteraction *const interaction) const {
+        if (root_reference == BVH_INVALID_NODE || !root_bounds.IntersectP(ray)) { return false; }
+        bool hit = false;
+        const __m128 ray_origin[3] = {_mm_set1_ps(ray.Origin().x), _mm_set1_ps(ray.Origin().y),
+                                      _mm_set1_ps(ray.Origin().z)};
+        const __m128 inv_dir[3] = {_mm_set1_ps(ray.InvDirection().x), _mm_set1_ps(ray.InvDirection().y),
+                                   _mm_set1_ps(ray.InvDirection().z)};
+        // References left to visit
+        uint32_t to_visit[BVH_STACK_SIZE];
+        uint32_t to_visit_offset = 0;
+        uint32_t current = root_reference;
+        while (true) {
+            if (current & BVH_LEAF_FLAG) {
+                // Intersect primitives, each hit shortens the ray
+                const uint32_t offset = current & BVH_LEAF_OFFSET_MASK;
+                const uint32_t count = ((current & ~BVH_LEAF_FLAG) >> BVH_LEAF_COUNT_SHIFT) + 1;
+                for (uint32_t i = 0; i < count; i++) {
+                    if (primitives[offset + i]->Intersect(ray, interaction)) {
+                        hit = true;
+                    }
+                }
+                if (to_visit_offset == 0) { break; }
+                current = to_visit[--to_visit_offset];
+                continue;
+            }
+            const QuantizedBVHNode &node = quantized_nodes[current];
+            __m128 t_entry;
+            const int32_t mask = IntersectChildren(node, ray_origin, inv_dir, ray.RayMinimum(), ray.RayMaximum(),
+                                                     &t_entry);
+            if (mask == 0x3) {
+#ifdef DEBUG
+                assert(to_visit_offset < BVH_STACK_SIZE);
+#endif
+                // Visit the nearest child first
+                float t[4];
+                _mm_storeu_ps(t, t_entry);
+                const uint32_t nearest = (t[1] < t[0]) ? 1 : 0;
+                to_visit[to_visit_offset++] = node.children[1 - nearest];
+                current = node.children[nearest];
+            } else if (mask != 0) {
+                current = node.children[mask >> 1];
+            } else {
+                if (to_visit_offset == 0) { break; }
+                current = to_visit[--to_visit_offset];
+            }
+        }
+
+        return hit;
+    }
+
+    bool BVHAccelerator::IntersectPQuantized(const Ray &ray) const {
+        if (root_reference == BVH_INVALID_NODE || !root_bounds.IntersectP(ray)) { return false; }
+        const __m128 ray_origin[3] = {_mm_set1_ps(ray.Origin().x), _mm_set1_ps(ray.Origin().y),
+                                      _mm_set1_ps(ray.Origin().z)};
+        const __m128 inv_dir[3] = {_mm_set1_ps(ray.InvDirection().x), _mm_set1_ps(ray.InvDirection().y),
+                                   _mm_set1_ps(ray.InvDirection().z)};
+        uint32_t to_visit[BVH_STACK_SIZE];
+        uint32_t to_visit_offset = 0;
+        uint32_t current = root_reference;
+        while (true) {
+            if (current & BVH_LEAF_FLAG) {
+                const uint32_t offset = current & BVH_LEAF_OFFSET_MASK;
+                const uint32_t count = ((current & ~BVH_LEAF_FLAG) >> BVH_LEAF_COUNT_SHIFT) + 1;
+                for (uint32_t i = 0; i < count; i++) {
+                    if (primitives[offset + i]->IntersectP(ray)) {
+                        return true;
+                    }
+                }
+                if (to_visit_offset == 0) { break; }
+                current = to_visit[--to_visit_offset];
+                continue;
+            }
+            const QuantizedBVHNode &node = quantized_nodes[current];
+            __m128 t_entry;
+            const int32_t mask = IntersectChildren(node, ray_origin, inv_dir, ray.RayMinimum(), ray.RayMaximum(),
+                                                     &t_entry);
+            if (mask == 0x3) {
+                to_visit[to_visit_offset++] = node.children[1];
+                current = node.children[0];
+            } else if (mask != 0) {
+                current = node.children[mask >> 1];
+            } else {
+                if (to_visit_offset == 0) { break; }
+                current = to_visit[--to_visit_offset];
+            }
+        }
+
+        return false;
+    }
+
+    bool BVHAccelerator::Intersect(const Ray &ray, SurfaceInteraction *const interaction) const {
+        if (format == BVHNodeFormat::QUANTIZED) { return IntersectQuantized(ray, interaction); }
+        if (nodes.empty()) { return false; }
+        bool hit = false;
+        const bool dir_is_neg[3] = {ray.Direction().x < 0.f, ray.Direction().y < 0.f, ray.Direction().z < 0.f};
+        // Nodes left to visit
+        uint32_t to_visit[BVH_STACK_SIZE];
+        uint32_t to_visit_offset = 0;
+        uint32_t current = 0;
+        while (true) {
+            const LinearBVHNode &node = nodes[current];
+            if (node.bounds.IntersectP(ray)) {
+                if (node.n_primitives > 0) {
+                    // Intersect primitives, each hit shortens the ray
+                    for (uint32_t i = 0; i < node.n_primitives; i++) {
+                        if (primitives[node.primitive_offset + i]->Intersect(ray, interaction)) {
+                            hit = true;
+                        }
+                    }
+                    if (to_visit_offset == 0) { break; }
+                    current = to_visit[--to_visit_offset];
+                } else {
+#ifdef DEBUG
+                    assert(to_visit_offset < BVH_STACK_SIZE);
+#endif
+                    // Visit the nearest child first
+                    if (dir_is_neg[node.axis]) {
+                        to_visit[to_visit_offset++] = current + 1;
+                        current = node.second_child_offset;
+                    } else {
+                        to_visit[to_visit_offset++] = node.second_child_offset;
+                        current = current + 1;
+                    }
+                }
+            } else {
+                if (to_visit_offset == 0) { break; }
+                current = to_visit[--to_visit_offset];
+            }
+        }
+
+        return hit;
+    }
+
+    bool BVHAccelerator::IntersectP(const Ray &ray) const {
+        if (format == BVHNodeFormat::QUANTIZED) { return IntersectPQuantized(ray); }
+        if (nodes.empty()) { return false; }
+        const bool dir_is_neg[3] = {ray.Direction().x < 0.f, ray.Direction().y < 0.f, ray.Direction().z < 0.f};
+        uint32_t to_visit[BVH_STACK_SIZE];
+        uint32_t to_visit_offset = 0;
+        uint32_t current = 0;
+        while (true) {
+            const LinearBVHNode &node = nodes[current];
+            if (node.bounds.IntersectP(ray)) {
+                if (node.n_primitives > 0) {
+                    for (uint32_t i = 0; i < node.n_primitives; i++) {
+                        if (primitives[node.primitive_offset + i]->IntersectP(ray)) {
+                            return true;
+                        }
+                    }
+                    if (to_visit_offset == 0) { break; }
+                    current = to_visit[--to_visit_offset];
+                } else {
+                    if (dir_is_neg[node.axis]) {
+                        to_visit[to_visit_offset++] = current + 1;
+                        current = node.second_child_offset;
+                    } else {
+                        to_visit[to_visit_offset++] = node.second_child_offset;
+                        current = current + 1;
+                    }
+                }
+            } else {
+                if (to_visit_offset == 0) { break; }
+                current = to_visit[--to_visit_offset];
+            }
+        }
+
+        return false;
+    }
+
+    BBox BVHAccelerator::PrimitiveBounding() const {
+        if (format == BVHNodeFormat::QUANTIZED) { return root_bounds; }
+        return nodes.empty() ? BBox() : nodes[0].bounds;
+    }
+
+    float BVHAccelerator::SAHCost() const {
+        if (format == BVHNodeFormat::QUANTIZED) {
+            const float root_area = root_bounds.SurfaceArea();
+            return (root_reference == BVH_INVALID_NODE || root_area == 0.f) ? 0.f : quantized_cost / root_area;
+        }
+        if (nodes.empty()) { return 0.f; }
+        const float root_area = nodes[0].bounds.SurfaceArea();
+
+        return (root_area == 0.f) ? 0.f : subtree_costs[0] / root_area;
+    }
+
+    uint32_t BVHAccelerator::NumNodes() const {
+        if (format == BVHNodeFormat::QUANTIZED) {
+            // Leaves are stored in their parent references
+            return static_cast<uint32_t>(quantized_nodes.size());
+        }
+        return static_cast<uint32_t>(nodes.size());
+    }
+
+    size_t BVHAccelerator::NodesMemory() const {
+        return nodes.size() * sizeof(LinearBVHNode) + (subtree_costs.size() + build_costs.size()) * sizeof(float) +
+               quantized_nodes.size() * sizeof(QuantizedBVHNode);
+    }
+
+}
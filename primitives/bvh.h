@@ -0,0 +1,201 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2016 simon.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * File:   bvh.h
+ * Author: simon
+ *
+ * Created on October 19, 2026, 10:20 AM
+ */
+
+#ifndef PIXEL_BVH_H
+#define PIXEL_BVH_H
+
+#include "pixel.h"
+#include "primitive.h"
+#include "bbox.h"
+
+namespace pixel {
+
+    // Number of bits used to quantize the primitive centroids
+    enum class MortonPrecision {
+        // 10 bits per axis
+        MORTON_30,
+        // 21 bits per axis
+        MORTON_63
+    };
+
+    // Compute Morton code of a point in [0, 1]^3
+    uint64_t EncodeMorton(const SSEVector &p, MortonPrecision precision);
+
+    // Outcome of a BVH refit
+    enum class RefitResult {
+        // Only the bounds were updated
+        REFIT,
+        // Some degraded subtrees were rebuilt
+        PARTIAL_REBUILD,
+        // The whole hierarchy was rebuilt
+        FULL_REBUILD
+    };
+
+    // Memory layout of the BVH nodes
+    enum class BVHNodeFormat {
+        // Full precision bounds for every node
+        FULL,
+        // Children bounds quantized to 8 bits relative to their parent
+        QUANTIZED
+    };
+
+    // Flattened BVH node, children of interior nodes are stored in depth first order
+    struct LinearBVHNode {
+        // Node bounds
+        BBox bounds;
+        union {
+            // Leaf node, offset in the ordered primitives list
+            uint32_t primitive_offset;
+            // Interior node, offset of the second child, the first one follows the node
+            uint32_t second_child_offset;
+        };
+        // Number of primitives in the node, 0 for interior nodes
+        uint16_t n_primitives;
+        // Axis used to order the children traversal
+        uint8_t axis;
+        uint8_t pad;
+    };
+
+    // Compressed BVH node storing the bounds of its two children quantized on a grid spanning the node bounds.
+    // Cells have power of two sizes so that decoding is exact, children bounds always enclose the original ones
+    struct QuantizedBVHNode {
+        // Minimum corner of the node bounds
+        float origin[3];
+        // Grid cell size is 2^exponent along each axis
+        int8_t exponent[3];
+        uint8_t pad;
+        // Quantized children bounds, for each axis: first min, second min, first max, second max
+        uint8_t q_bounds[3][4];
+        // Children references, leaves have BVH_LEAF_FLAG set and store the primitives offset and count
+        uint32_t children[2];
+    };
+
+    // Define BVHAccelerator class, builds a linear BVH (LBVH) by sorting the primitives
+    // along a Morton curve and emitting the hierarchy from the sorted codes
+    class BVHAccelerator : public PrimitiveInterface {
+    public:
+        // Constructor
+        BVHAccelerator(const std::vector<const PrimitiveInterface *> &p,
+                       MortonPrecision precision = MortonPrecision::MORTON_30,
+                       bool optimize_treelets = false,
+                       BVHNodeFormat format = BVHNodeFormat::FULL);
+
+        // Constructor, loads the hierarchy from the cache file when it was built for primitives with the same
+        // bounds and parameters, otherwise builds it and writes the cache file
+        BVHAccelerator(const std::vector<const PrimitiveInterface *> &p, const std::string &cache_file,
+                       MortonPrecision precision = MortonPrecision::MORTON_30,
+                       bool optimize_treelets = false,
+                       BVHNodeFormat format = BVHNodeFormat::FULL);
+
+        bool Intersect(const Ray &ray, SurfaceInteraction *const interaction) const override;
+
+        bool IntersectP(const Ray &ray) const override;
+
+        BBox PrimitiveBounding() const override;
+
+        // Update the bounds after the primitives moved, keeping the topology. Subtrees whose SAH cost grew
+        // by more than rebuild_threshold times their cost at build time are rebuilt, and the whole hierarchy
+        // is rebuilt when they hold most of the primitives. Quantized hierarchies only requantize their bounds
+        // and are fully rebuilt when the overall cost crosses the threshold.
+        // Must not run concurrently with traversals
+        RefitResult Refit(float rebuild_threshold = 1.5f);
+
+        // SAH cost of the hierarchy, relative to the root surface area
+        float SAHCost() const;
+
+        // Number of nodes in the hierarchy
+        uint32_t NumNodes() const;
+
+        // Memory used by the hierarchy, in bytes
+        size_t NodesMemory() const;
+
+    private:
+        // Build the hierarchy from the current primitives
+        void Build();
+
+        // Build the subtree of the given primitives range, storing its nodes from node_offset
+        void BuildRange(uint32_t primitive_begin, uint32_t primitive_end, uint32_t node_offset);
+
+        // Recompute all bounds and SAH costs bottom-up
+        void RefitBounds();
+
+        // Number of nodes of the subtree rooted at the given node
+        uint32_t SubtreeSize(uint32_t node) const;
+
+        // Keep the hierarchy in the requested format once built
+        void Finalize();
+
+        // Convert the full node subtree to the quantized format, returns the reference to its root
+        uint32_t QuantizeSubtree(uint32_t node);
+
+        // Recompute all bounds and the SAH cost of the quantized hierarchy bottom-up
+        void RefitQuantized();
+
+        // Traversals of the quantized hierarchy
+        bool IntersectQuantized(const Ray &ray, SurfaceInteraction *const interaction) const;
+
+        bool IntersectPQuantized(const Ray &ray) const;
+
+        // Hash of the primitives bounds and build parameters, which fully determine the hierarchy
+        uint64_t SceneHash() const;
+
+        // Check that the offsets of every node stay within the nodes and the primitives, that children come
+        // after their parent and that the hierarchy is shallow enough for the traversal stack
+        bool ValidNodes() const;
+
+        // Load the hierarchy from a cache file, returns false if the file is missing, does not match or is corrupt
+        bool LoadCache(const std::string &cache_file, uint64_t scene_hash);
+
+        // Write the hierarchy to a cache file, p are the primitives in their original order
+        void SaveCache(const std::string &cache_file, const std::vector<const PrimitiveInterface *> &p,
+                       uint64_t scene_hash) const;
+
+        // Primitives, in the order used by the leaves
+        std::vector<const PrimitiveInterface *> primitives;
+        // Build parameters
+        const MortonPrecision precision;
+        const bool optimize_treelets;
+        const BVHNodeFormat format;
+        // Flattened hierarchy
+        std::vector<LinearBVHNode> nodes;
+        // Current SAH cost of each subtree and the cost it had when it was built
+        std::vector<float> subtree_costs, build_costs;
+        // Quantized hierarchy, with the root bounds and a reference to the root
+        std::vector<QuantizedBVHNode> quantized_nodes;
+        BBox root_bounds;
+        uint32_t root_reference;
+        // Current SAH cost of the quantized hierarchy and the cost it had when it was built
+        float quantized_cost, quantized_build_cost;
+    };
+
+}
+
+#endif //PIXEL_BVH_H
@@ -0,0 +1,248 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2016 simon.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "bvh.h"
+#include "parallel.h"
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace pixel {
+
+    // Identifies BVH cache files, the version must be increased whenever the layout of the file or of the
+    // nodes changes
+    static const char BVH_CACHE_MAGIC[8] = {'P', 'I', 'X', 'E', 'L', 'B', 'V', 'H'};
+    static const uint32_t BVH_CACHE_VERSION = 1;
+
+    // Header at the beginning of a cache file. It is followed by the original index of each ordered primitive,
+    // then the full nodes with their current and build costs, then the quantized nodes. Each section starts
+    // at a multiple of 16 bytes so that nodes can be copied straight from the mapping
+    struct BVHCacheHeader {
+        char magic[8];
+        uint32_t version;
+        // Size of the node records, guards against layout changes between builds of the renderer
+        uint32_t node_size;
+        uint32_t quantized_node_size;
+        // Build parameters
+        uint8_t precision;
+        uint8_t optimize_treelets;
+        uint8_t format;
+        uint8_t pad;
+        uint64_t scene_hash;
+        uint32_t n_primitives;
+        uint32_t n_nodes;
+        uint32_t n_quantized_nodes;
+        uint32_t root_reference;
+        // Root bounds and costs of the quantized hierarchy
+        float root_min[3];
+        float root_max[3];
+        float quantized_cost;
+        float quantized_build_cost;
+    };
+
+    // Round a file offset to the next section boundary
+    inline size_t AlignCacheOffset(size_t offset) {
+        return (offset + 15) & ~static_cast<size_t>(15);
+    }
+
+    // Offsets of the file sections, the last one is the file size
+    struct BVHCacheLayout {
+        size_t order, nodes, subtree_costs, build_costs, quantized_nodes, size;
+
+        BVHCacheLayout(const BVHCacheHeader &header) {
+            order = AlignCacheOffset(sizeof(BVHCacheHeader));
+            nodes = AlignCacheOffset(order + header.n_primitives * sizeof(uint32_t));
+            subtree_costs = AlignCacheOffset(nodes + header.n_nodes * sizeof(LinearBVHNode));
+            build_costs = AlignCacheOffset(subtree_costs + header.n_nodes * sizeof(float));
+            quantized_nodes = AlignCacheOffset(build_costs + header.n_nodes * sizeof(float));
+            size = quantized_nodes + header.n_quantized_nodes * sizeof(QuantizedBVHNode);
+        }
+    };
+
+    // FNV-1a hash of a block of memory
+    inline uint64_t HashBytes(const void *data, size_t size, uint64_t hash) {
+        const uint8_t *bytes = static_cast<const uint8_t *>(data);
+        for (size_t i = 0; i < size; i++) {
+            hash = (hash ^ bytes[i]) * 0x100000001B3ULL;
+        }
+
+        return hash;
+    }
+
+    uint64_t BVHAccelerator::SceneHash() const {
+        const uint32_t n = static_cast<uint32_t>(primitives.size());
+        // The build only looks at the primitives bounds
+        std::vector<float> bounds(6 * n);
+        ParallelFor(n, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; i++) {
+                const BBox b = primitives[i]->PrimitiveBounding();
+                const float values[6] = {b.Min().x, b.Min().y, b.Min().z, b.Max().x, b.Max().y, b.Max().z};
+                std::copy(values, values + 6, &bounds[6 * i]);
+            }
+        });
+        const uint32_t parameters[4] = {n, static_cast<uint32_t>(precision), optimize_treelets ? 1u : 0u,
+                                        static_cast<uint32_t>(format)};
+        uint64_t hash = HashBytes(parameters, sizeof(parameters), 0xCBF29CE484222325ULL);
+
+        return HashBytes(bounds.data(), bounds.size() * sizeof(float), hash);
+    }
+
+    bool BVHAccelerator::LoadCache(const std::string &cache_file, uint64_t scene_hash) {
+        const int fd = open(cache_file.c_str(), O_RDONLY);
+        if (fd < 0) { return false; }
+        struct stat file_stat;
+        if (fstat(fd, &file_stat) != 0 || static_cast<size_t>(file_stat.st_size) < sizeof(BVHCacheHeader)) {
+            close(fd);
+            return false;
+        }
+        const size_t file_size = static_cast<size_t>(file_stat.st_size);
+        void *mapping = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapping == MAP_FAILED) { return false; }
+        const uint8_t *data = static_cast<const uint8_t *>(mapping);
+
+        // Check the file was written for this scene by a compatible build
+        BVHCacheHeader header;
+        std::memcpy(&header, data, sizeof(BVHCacheHeader));
+        const BVHCacheLayout layout(header);
+        const uint32_t n = static_cast<uint32_t>(primitives.size());
+        bool valid = std::memcmp(header.magic, BVH_CACHE_MAGIC, sizeof(BVH_CACHE_MAGIC)) == 0 &&
+                     header.version == BVH_CACHE_VERSION &&
+                     header.node_size == sizeof(LinearBVHNode) &&
+                     header.quantized_node_size == sizeof(QuantizedBVHNode) &&
+                     header.precision == static_cast<uint8_t>(precision) &&
+                     header.optimize_treelets == (optimize_treelets ? 1 : 0) &&
+                     header.format == static_cast<uint8_t>(format) &&
+                     header.scene_hash == scene_hash && header.n_primitives == n && layout.size == file_size;
+        // Primitives order must be a permutation
+        std::vector<const PrimitiveInterface *> ordered(n);
+        if (valid) {
+            const uint32_t *order = reinterpret_cast<const uint32_t *>(data + layout.order);
+            std::vector<bool> used(n, false);
+            for (uint32_t i = 0; i < n && valid; i++) {
+                valid = order[i] < n && !used[order[i]];
+                if (valid) {
+                    used[order[i]] = true;
+                    ordered[i] = primitives[order[i]];
+                }
+            }
+        }
+        if (valid) {
+            primitives.swap(ordered);
+            nodes.resize(header.n_nodes);
+            subtree_costs.resize(header.n_nodes);
+            build_costs.resize(header.n_nodes);
+            quantized_nodes.resize(header.n_quantized_nodes);
+            std::memcpy(static_cast<void *>(nodes.data()), data + layout.nodes, header.n_nodes * sizeof(LinearBVHNode));
+            std::memcpy(subtree_costs.data(), data + layout.subtree_costs, header.n_nodes * sizeof(float));
+            std::memcpy(build_costs.data(), data + layout.build_costs, header.n_nodes * sizeof(float));
+            std::memcpy(quantized_nodes.data(), data + layout.quantized_nodes,
+                        header.n_quantized_nodes * sizeof(QuantizedBVHNode));
+            root_reference = header.root_reference;
+            root_bounds = BBox(SSEVector(header.root_min[0], header.root_min[1], header.root_min[2], 1.f),
+                               SSEVector(header.root_max[0], header.root_max[1], header.root_max[2], 1.f));
+            quantized_cost = header.quantized_cost;
+            quantized_build_cost = header.quantized_build_cost;
+            // A corrupt file must not index out of the nodes or primitives, start again from the scene
+            valid = ValidNodes();
+            if (!valid) {
+                primitives.swap(ordered);
+                nodes.clear();
+                subtree_costs.clear();
+                build_costs.clear();
+                quantized_nodes.clear();
+            }
+        }
+        munmap(mapping, file_size);
+
+        return valid;
+    }
+
+    void BVHAccelerator::SaveCache(const std::string &cache_file, const std::vector<const PrimitiveInterface *> &p,
+                                   uint64_t scene_hash) const {
+        BVHCacheHeader header;
+        std::memset(&header, 0, sizeof(BVHCacheHeader));
+        std::memcpy(header.magic, BVH_CACHE_MAGIC, sizeof(BVH_CACHE_MAGIC));
+        header.version = BVH_CACHE_VERSION;
+        header.node_size = sizeof(LinearBVHNode);
+        header.quantized_node_size = sizeof(QuantizedBVHNode);
+        header.precision = static_cast<uint8_t>(precision);
+        header.optimize_treelets = optimize_treelets ? 1 : 0;
+        header.format = static_cast<uint8_t>(format);
+        header.scene_hash = scene_hash;
+        header.n_primitives = static_cast<uint32_t>(primitives.size());
+        header.n_nodes = static_cast<uint32_t>(nodes.size());
+        header.n_quantized_nodes = static_cast<uint32_t>(quantized_nodes.size());
+        header.root_reference = root_reference;
+        const SSEVector &root_min = root_bounds.Min();
+        const SSEVector &root_max = root_bounds.Max();
+        const float root_values[6] = {root_min.x, root_min.y, root_min.z, root_max.x, root_max.y, root_max.z};
+        std::copy(root_values, root_values + 3, header.root_min);
+        std::copy(root_values + 3, root_values + 6, header.root_max);
+        header.quantized_cost = quantized_cost;
+        header.quantized_build_cost = quantized_build_cost;
+        const BVHCacheLayout layout(header);
+
+        // Find the original index of each ordered primitive. A primitive listed several times has one index per
+        // position, each ordered occurrence takes the next one so that the order stays a permutation
+        std::unordered_map<const PrimitiveInterface *, std::vector<uint32_t>> indices;
+        indices.reserve(p.size());
+        for (uint32_t i = static_cast<uint32_t>(p.size()); i-- > 0;) {
+            indices[p[i]].push_back(i);
+        }
+        std::vector<uint32_t> order(primitives.size());
+        for (uint32_t i = 0; i < primitives.size(); i++) {
+            std::vector<uint32_t> &positions = indices[primitives[i]];
+            order[i] = positions.back();
+            positions.pop_back();
+        }
+
+        // Write to a temporary file and move it in place, so concurrent renders never map a partial file. Its name
+        // is unique to the process and the save, as other processes or hierarchies may write the same cache
+        std::vector<uint8_t> data(layout.size, 0);
+        std::memcpy(data.data(), &header, sizeof(BVHCacheHeader));
+        std::memcpy(data.data() + layout.order, order.data(), order.size() * sizeof(uint32_t));
+        std::memcpy(data.data() + layout.nodes, nodes.data(), nodes.size() * sizeof(LinearBVHNode));
+        std::memcpy(data.data() + layout.subtree_costs, subtree_costs.data(), subtree_costs.size() * sizeof(float));
+        std::memcpy(data.data() + layout.build_costs, build_costs.data(), build_costs.size() * sizeof(float));
+        std::memcpy(data.data() + layout.quantized_nodes, quantized_nodes.data(),
+                    quantized_nodes.size() * sizeof(QuantizedBVHNode));
+        static std::atomic<uint32_t> n_saves(0);
+        const std::string temp_file = cache_file + "." + std::to_string(getpid()) + "." +
+                                      std::to_string(n_saves.fetch_add(1)) + ".tmp";
+        std::ofstream file(temp_file, std::ofstream::binary);
+        file.write(reinterpret_cast<const char *>(data.data()), data.size());
+        file.close();
+        if (!file || std::rename(temp_file.c_str(), cache_file.c_str()) != 0) {
+            std::remove(temp_file.c_str());
+            std::cerr << "Could not write BVH cache file " << cache_file << std::endl;
+        }
+    }
+
+}
@@ -42,6 +42,7 @@ namespace pixel {
             // Update ray maximum value
             ray.SetNewMaximum(t_hit);
             interaction->prim_ptr = this;
+            interaction->instance_ptr = nullptr;
             interaction->mat_ptr = material.get();
             // interaction->mat_ptr = material;
 
@@ -51,6 +52,10 @@ namespace pixel {
         return false;
     }
 
+    void Instance::ComputeSurfaceInteraction(const Ray &ray, SurfaceInteraction *const interaction) const {
+        shape->ComputeSurfaceInteraction(ray, interaction);
+    }
+
     bool Instance::IntersectP(const Ray &ray) const {
         return shape->IntersectP(ray);
     }
@@ -47,6 +47,8 @@ namespace pixel {
 
         bool Intersect(const Ray &ray, SurfaceInteraction *const interaction) const override;
 
+        void ComputeSurfaceInteraction(const Ray &ray, SurfaceInteraction *const interaction) const override;
+
         bool IntersectP(const Ray &ray) const override;
 
         BBox PrimitiveBounding() const override;
@@ -0,0 +1,69 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2016 simon.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "object_instance.h"
+#include "ray.h"
+#include "interaction.h"
+#include "bbox.h"
+
+namespace pixel {
+
+    ObjectInstance::ObjectInstance(const std::shared_ptr<const PrimitiveInterface> &o, const SSEMatrix &o2w)
+            : object(o), object_to_world(o2w), world_to_object(Inverse(o2w)) {
+    }
+
+    bool ObjectInstance::Intersect(const Ray &ray, SurfaceInteraction *const interaction) const {
+        // Transform ray to object space, the ray parameter is not affected by the transformation
+        Ray object_ray = TransformRay(ray, world_to_object);
+        if (object->Intersect(object_ray, interaction)) {
+            // Update ray maximum value, the interaction is completed in object space later
+            ray.SetNewMaximum(object_ray.RayMaximum());
+            interaction->instance_ptr = this;
+
+            return true;
+        }
+
+        return false;
+    }
+
+    void ObjectInstance::ComputeSurfaceInteraction(const Ray &ray, SurfaceInteraction *const interaction) const {
+        interaction->prim_ptr->ComputeSurfaceInteraction(TransformRay(ray, world_to_object), interaction);
+        // Transform interaction back to world space
+        TransformSurfaceInteraction(interaction, object_to_world, world_to_object);
+    }
+
+    bool ObjectInstance::IntersectP(const Ray &ray) const {
+        return object->IntersectP(TransformRay(ray, world_to_object));
+    }
+
+    BBox ObjectInstance::PrimitiveBounding() const {
+        return TransformBBox(object->PrimitiveBounding(), object_to_world);
+    }
+
+    void ObjectInstance::SetTransform(const SSEMatrix &o2w) {
+        object_to_world = o2w;
+        world_to_object = Inverse(o2w);
+    }
+
+}
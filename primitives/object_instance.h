@@ -0,0 +1,70 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2016 simon.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * File:   object_instance.h
+ * Author: simon
+ *
+ * Created on October 19, 2026, 1:40 PM
+ */
+
+#ifndef PIXEL_OBJECT_INSTANCE_H
+#define PIXEL_OBJECT_INSTANCE_H
+
+#include "pixel.h"
+#include "primitive.h"
+#include "sse_matrix.h"
+
+namespace pixel {
+
+    // Define ObjectInstance class, places a shared object (usually a BVHAccelerator built in object space)
+    // in the world. Rays are transformed once at the instance boundary, so any number of instances
+    // only costs a transform each. Putting the instances in a BVHAccelerator gives a two-level hierarchy.
+    // Hits are completed through the instance, so objects must not contain other object instances
+    class ObjectInstance : public PrimitiveInterface {
+    public:
+        // Constructor
+        ObjectInstance(const std::shared_ptr<const PrimitiveInterface> &o, const SSEMatrix &o2w);
+
+        bool Intersect(const Ray &ray, SurfaceInteraction *const interaction) const override;
+
+        void ComputeSurfaceInteraction(const Ray &ray, SurfaceInteraction *const interaction) const override;
+
+        bool IntersectP(const Ray &ray) const override;
+
+        BBox PrimitiveBounding() const override;
+
+        // Move the instance, the acceleration structures containing it need to be refitted
+        void SetTransform(const SSEMatrix &o2w);
+
+    private:
+        // Shared object geometry
+        std::shared_ptr<const PrimitiveInterface> object;
+        // Transformation matrices
+        SSEMatrix object_to_world, world_to_object;
+    };
+
+}
+
+#endif //PIXEL_OBJECT_INSTANCE_H
@@ -0,0 +1,179 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2016 simon.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "sphere_set.h"
+#include "ray.h"
+#include "interaction.h"
+#include "kernels.h"
+#include <algorithm>
+#include <cassert>
+
+namespace pixel {
+
+    // Intersect the ray with a packet of spheres stored as SoA with the kernel selected for the CPU. Returns
+    // the mask of the spheres hit, their nearest distances in the ray range are stored in t_hit
+    inline uint32_t IntersectSpheres(const float *const x, const float *const y, const float *const z,
+                                     const float *const r, const Ray &ray, float *const t_hit) {
+        return Kernels().intersect_spheres(x, y, z, r, &ray.Origin().x, &ray.Direction().x,
+                                           ray.RayMinimum(), ray.RayMaximum(), t_hit);
+    }
+
+    SpherePacket::SpherePacket(const SSEVector *const centers, const float *const radii, uint32_t count) {
+        assert(count > 0 && count <= SPHERE_PACKET_SIZE);
+        for (uint32_t i = 0; i < SPHERE_PACKET_SIZE; i++) {
+            const uint32_t s = FMin(i, count - 1);
+            x[i] = centers[s].x;
+            y[i] = centers[s].y;
+            z[i] = centers[s].z;
+            r[i] = radii[s];
+            const SSEVector radius_vector(r[i], r[i], r[i], 0.f);
+            bounds = BBoxUnion(bounds, BBox(centers[s] - radius_vector, centers[s] + radius_vector));
+        }
+    }
+
+    bool SpherePacket::Intersect(const Ray &ray, SurfaceInteraction *const interaction) const {
+        float t[SPHERE_PACKET_SIZE];
+        uint32_t mask = IntersectSpheres(x, y, z, r, ray, t);
+        if (mask == 0) { return false; }
+        // Find the closest sphere
+        uint32_t closest = __builtin_ctz(mask);
+        for (mask &= mask - 1; mask != 0; mask &= mask - 1) {
+            const uint32_t i = __builtin_ctz(mask);
+            if (t[i] < t[closest]) { closest = i; }
+        }
+        // Update ray maximum value, the set computes the frame from the slot of the sphere hit
+        ray.SetNewMaximum(t[closest]);
+        interaction->hit_point = ray(t[closest]);
+        interaction->normal = Normalize(interaction->hit_point - SSEVector(x[closest], y[closest], z[closest], 1.f));
+        interaction->prim_ptr = this;
+        interaction->prim_index = closest;
+
+        return true;
+    }
+
+    bool SpherePacket::IntersectP(const Ray &ray) const {
+        float t[SPHERE_PACKET_SIZE];
+
+        return IntersectSpheres(x, y, z, r, ray, t) != 0;
+    }
+
+    BBox SpherePacket::PrimitiveBounding() const {
+        return bounds;
+    }
+
+    SphereSet::SphereSet(const std::vector<SSEVector> &centers, const std::vector<float> &radii,
+                         const std::shared_ptr<const MaterialInterface> &m)
+            : n_spheres(static_cast<uint32_t>(centers.size())), packet_width(Kernels().sphere_packet_width),
+              sphere_radii(radii), material(m) {
+        assert(centers.size() == radii.size());
+        // Sort spheres along a Morton curve so that packets hold nearby spheres
+        BBox centers_bounds;
+        for (const SSEVector &c : centers) {
+            centers_bounds = BBoxUnion(centers_bounds, c);
+        }
+        std::vector<std::pair<uint64_t, uint32_t>> sorted(n_spheres);
+        for (uint32_t i = 0; i < n_spheres; i++) {
+            sorted[i] = std::make_pair(EncodeMorton(centers_bounds.Offset(centers[i]), MortonPrecision::MORTON_63), i);
+        }
+        std::sort(sorted.begin(), sorted.end());
+        sphere_indices.resize(n_spheres);
+        for (uint32_t i = 0; i < n_spheres; i++) {
+            sphere_indices[i] = sorted[i].second;
+        }
+
+        // Create packets, the hierarchy keeps pointers to them so they must not be moved afterwards
+        assert(packet_width <= SPHERE_PACKET_SIZE);
+        packets.reserve((n_spheres + packet_width - 1) / packet_width);
+        SSEVector packet_centers[SPHERE_PACKET_SIZE];
+        float packet_radii[SPHERE_PACKET_SIZE];
+        for (uint32_t begin = 0; begin < n_spheres; begin += packet_width) {
+            const uint32_t count = FMin(packet_width, n_spheres - begin);
+            for (uint32_t i = 0; i < count; i++) {
+                packet_centers[i] = centers[sorted[begin + i].second];
+                packet_radii[i] = radii[sorted[begin + i].second];
+            }
+            packets.emplace_back(packet_centers, packet_radii, count);
+        }
+        std::vector<const PrimitiveInterface *> packet_pointers(packets.size());
+        for (uint32_t i = 0; i < packets.size(); i++) {
+            packet_pointers[i] = &packets[i];
+        }
+        bvh.reset(new BVHAccelerator(packet_pointers));
+    }
+
+    bool SphereSet::Intersect(const Ray &ray, SurfaceInteraction *const interaction) const {
+        if (!bvh->Intersect(ray, interaction)) { return false; }
+        // Turn the packet and slot hit into the index the sphere was given to the constructor with
+        const auto packet = static_cast<const SpherePacket *>(interaction->prim_ptr);
+        const uint32_t slot = interaction->prim_index;
+        interaction->prim_index = sphere_indices[static_cast<uint32_t>(packet - packets.data()) * packet_width + slot];
+        interaction->prim_ptr = this;
+        interaction->instance_ptr = nullptr;
+        interaction->mat_ptr = material.get();
+
+        return true;
+    }
+
+    void SphereSet::ComputeSurfaceInteraction(const Ray &, SurfaceInteraction *const interaction) const {
+        // Compute local frame from the normal found by the packet, spheres are not rotated so it is already
+        // in world space
+        const SSEVector &n = interaction->normal;
+        const float radius = sphere_radii[interaction->prim_index];
+        float phi = Atan2(n.z, n.x);
+        if (phi < 0.f) {
+            phi += TWO_PI;
+        }
+        float theta = Acos(Clamp(n.y, -1.f, 1.f));
+        // The sines and cosines also give the derivatives below
+        float sin_phi, cos_phi, sin_theta, cos_theta;
+        SinCos(phi, &sin_phi, &cos_phi);
+        SinCos(theta, &sin_theta, &cos_theta);
+        if (theta > EPS) {
+            interaction->s = SSEVector(sin_phi, 0.f, -cos_phi, 0.f);
+            interaction->t = SSEVector(cos_theta * cos_phi, -sin_theta, cos_theta * sin_phi, 0.f);
+        } else {
+            CoordinateSystem(n, &(interaction->s), &(interaction->t));
+        }
+        interaction->u = phi / TWO_PI;
+        interaction->v = theta / PI;
+        // Derivatives of the uv parametrization, the normal ones are scaled by the inverse radius
+        interaction->dndu = SSEVector(-TWO_PI * n.z, 0.f, TWO_PI * n.x, 0.f);
+        interaction->dndv = SSEVector(PI * n.y * cos_phi, -PI * sin_theta, PI * n.y * sin_phi, 0.f);
+        interaction->dpdu = radius * interaction->dndu;
+        interaction->dpdv = radius * interaction->dndv;
+    }
+
+    bool SphereSet::IntersectP(const Ray &ray) const {
+        return bvh->IntersectP(ray);
+    }
+
+    BBox SphereSet::PrimitiveBounding() const {
+        return bvh->PrimitiveBounding();
+    }
+
+    uint32_t SphereSet::NumSpheres() const {
+        return n_spheres;
+    }
+
+}
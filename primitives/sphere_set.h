@@ -0,0 +1,105 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2016 simon.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * File:   sphere_set.h
+ * Author: simon
+ *
+ * Created on October 19, 2026, 2:10 PM
+ */
+
+#ifndef PIXEL_SPHERE_SET_H
+#define PIXEL_SPHERE_SET_H
+
+#include "pixel.h"
+#include "primitive.h"
+#include "bbox.h"
+#include "bvh.h"
+#include "sse_vector.h"
+
+namespace pixel {
+
+    // Largest number of spheres intersected together, the kernels of the CPU give the packet width
+    static const uint32_t SPHERE_PACKET_SIZE = 16;
+
+    // Group of nearby spheres stored as SoA, intersected with a single 16 wide AVX-512 test, an 8 wide AVX
+    // test or two 4 wide SSE tests. Only the hit point and normal are computed for hits
+    class SpherePacket : public PrimitiveInterface {
+    public:
+        // Constructor, unused slots repeat the last sphere
+        SpherePacket(const SSEVector *const centers, const float *const radii, uint32_t count);
+
+        bool Intersect(const Ray &ray, SurfaceInteraction *const interaction) const override;
+
+        bool IntersectP(const Ray &ray) const override;
+
+        BBox PrimitiveBounding() const override;
+
+    private:
+        // Sphere centers and radii
+        float x[SPHERE_PACKET_SIZE];
+        float y[SPHERE_PACKET_SIZE];
+        float z[SPHERE_PACKET_SIZE];
+        float r[SPHERE_PACKET_SIZE];
+        // Packet bounds
+        BBox bounds;
+    };
+
+    // Define SphereSet class, a set of translated and uniformly scaled spheres sharing a material.
+    // Spheres are grouped in packets along a Morton curve and the packets are stored in a BVH
+    class SphereSet : public PrimitiveInterface {
+    public:
+        // Constructor, hits report the index of the sphere in the given vectors in prim_index
+        SphereSet(const std::vector<SSEVector> &centers, const std::vector<float> &radii,
+                  const std::shared_ptr<const MaterialInterface> &m);
+
+        bool Intersect(const Ray &ray, SurfaceInteraction *const interaction) const override;
+
+        void ComputeSurfaceInteraction(const Ray &ray, SurfaceInteraction *const interaction) const override;
+
+        bool IntersectP(const Ray &ray) const override;
+
+        BBox PrimitiveBounding() const override;
+
+        // Number of spheres in the set
+        uint32_t NumSpheres() const;
+
+    private:
+        // Number of spheres, and in each packet
+        uint32_t n_spheres;
+        uint32_t packet_width;
+        // Sphere packets and their hierarchy
+        std::vector<SpherePacket> packets;
+        std::unique_ptr<const BVHAccelerator> bvh;
+        // Index passed to the constructor of the sphere in each packet slot
+        std::vector<uint32_t> sphere_indices;
+        // Radii by sphere index
+        std::vector<float> sphere_radii;
+        // Material
+        std::shared_ptr<const MaterialInterface> material;
+    };
+
+}
+
+#endif //PIXEL_SPHERE_SET_H
@@ -0,0 +1,304 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2016 simon.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "restir_renderer.h"
+#include "film.h"
+#include "camera.h"
+#include "scene.h"
+#include "light.h"
+#include "interaction.h"
+#include "ray.h"
+#include "scattering.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <functional>
+#include <random>
+
+namespace pixel {
+
+    // Pixels processed together, each chunk draws its own random numbers
+    static const uint32_t RESTIR_CHUNK_SIZE = 4096;
+
+    // Largest number of samples the previous frame may count for, relative to the current one
+    static const uint32_t TEMPORAL_M_FACTOR = 20;
+
+    // Neighbor pixels are only reused when they see a similar surface
+    static const float NORMAL_THRESHOLD = 0.9f;
+    static const float DEPTH_THRESHOLD = 0.1f;
+
+    // State of a pixel after its ray is traced
+    enum PIXEL_STATE {
+        // Shaded already, the ray left the scene
+        PIXEL_DONE = 0,
+        // Lit by resampling
+        PIXEL_RESAMPLED = 1,
+        // Left to the integrator
+        PIXEL_INTEGRATED = 2
+    };
+
+    // Non-specular lobes lit by the lights
+    static const BRDF_TYPE DIRECT_BRDF = BRDF_TYPE(ALL_BRDF & ~BRDF_SPECULAR);
+
+    // Call func with each pixel and a function drawing random numbers, over all the cores
+    template<typename F>
+    static void ParallelPixels(uint32_t n, uint32_t seed, F &&func) {
+        const uint32_t n_chunks = (n + RESTIR_CHUNK_SIZE - 1) / RESTIR_CHUNK_SIZE;
+        ParallelFor(n_chunks, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t c = begin; c < end; c++) {
+                std::default_random_engine generator(seed * n_chunks + c + 1);
+                std::uniform_real_distribution<float> distribution(0.f, 1.f);
+                const std::function<float()> u = [&]() {
+                    return distribution(generator);
+                };
+                const uint32_t end_pixel = std::min((c + 1) * RESTIR_CHUNK_SIZE, n);
+                for (uint32_t p = c * RESTIR_CHUNK_SIZE; p < end_pixel; p++) {
+                    func(p, u);
+                }
+            }
+        }, 1);
+    }
+
+    // Target of the resampling at a hit, the luminance of the unshadowed contribution of a light sample. The
+    // contribution and the occlusion tester of the sample are returned if asked
+    static float Target(const SurfaceInteraction &interaction, const SSEVector &wo, const LightInterface &light,
+                        float u1, float u2, SSESpectrum *const contribution = nullptr,
+                        OcclusionTester *const occ = nullptr) {
+        SSEVector wi;
+        float pdf;
+        OcclusionTester tester;
+        const SSESpectrum Li = light.Sample_Li(interaction, u1, u2, &wi, &pdf, &tester);
+        if (pdf == 0.f || IsBlack(Li)) {
+            return 0.f;
+        }
+        const SSESpectrum c(interaction.bsdf->f(wo, wi, DIRECT_BRDF) * Li *
+                            (AbsDotProduct(wi, interaction.normal) / pdf));
+        if (contribution) {
+            *contribution = c;
+        }
+        if (occ) {
+            *occ = tester;
+        }
+
+        return Luminance(c);
+    }
+
+    // Check if two pixels see a similar surface, given their normal and depth
+    static bool Similar(const SSEVector &n1, float depth1, const SSEVector &n2, float depth2) {
+        return DotProduct(n1, n2) > NORMAL_THRESHOLD && std::abs(depth1 - depth2) < DEPTH_THRESHOLD * depth1;
+    }
+
+    void ReSTIRRenderer::Reservoir::Update(uint32_t l, float v1, float v2, float weight, float u) {
+        weight_sum += weight;
+        if (u * weight_sum < weight) {
+            light = l;
+            u1 = v1;
+            u2 = v2;
+        }
+    }
+
+    void ReSTIRRenderer::Reservoir::Merge(const Reservoir &other, float weight, float u) {
+        Update(other.light, other.u1, other.u2, weight, u);
+        M += other.M;
+    }
+
+    void ReSTIRRenderer::Reservoir::Finalize(float target) {
+        W = (weight_sum > 0.f && target > 0.f) ? weight_sum / target : 0.f;
+    }
+
+    ReSTIRRenderer::ReSTIRRenderer(const std::shared_ptr<const SurfaceIntegratorInterface> &i, uint32_t candidates,
+                                   uint32_t spatial_neighbors, float spatial_radius, bool temporal)
+            : RendererInterface(i), candidates(std::max(candidates, 1u)), spatial_neighbors(spatial_neighbors),
+              spatial_radius(spatial_radius), temporal(temporal), frame(0) {
+    }
+
+    void ReSTIRRenderer::RenderImage(Film *const film, const Scene &scene, const CameraInterface &camera) const {
+        const uint32_t width = film->GetWidth(), height = film->GetHeight();
+        const uint32_t n = width * height;
+        const std::vector<const LightInterface *> &lights = scene.GetLights();
+        const uint32_t n_lights = static_cast<uint32_t>(lights.size());
+        // Surface seen through each pixel, with its normal facing the camera and its depth
+        std::vector<SurfaceInteraction> hits(n);
+        std::vector<SSEVector> wo(n), normals(n);
+        std::vector<float> depths(n, INFINITY);
+        std::vector<uint8_t> state(n, PIXEL_DONE);
+        std::vector<SSESpectrum> L(n);
+        std::vector<Reservoir> reservoirs(n);
+        std::vector<AOVSample> aovs(film->HasAOVs() ? n : 0);
+        // The seeds of the stages differ from frame to frame
+        const uint32_t seed = frame * 3;
+
+        // Trace the camera rays through the pixel centers and resample the light samples drawn at the hits. Only
+        // the sample kept is tested for visibility, occluded ones are not spread to the neighbors
+        ParallelPixels(n, seed, [&](uint32_t p, const std::function<float()> &u) {
+            const Ray ray = camera.GenerateRay(p % width, p / width, 0.5f, 0.5f);
+            SurfaceInteraction &hit = hits[p];
+            if (!scene.Intersect(ray, &hit)) {
+                L[p] = scene.EnvironmentRadiance(ray);
+                return;
+            }
+            hit.GenerateBSDF();
+            if (!aovs.empty()) {
+                RecordAOVs(hit, ray, &aovs[p]);
+            }
+            if (hit.bsdf->NumMatchingBRDF(DIRECT_BRDF) == 0) {
+                state[p] = PIXEL_INTEGRATED;
+                return;
+            }
+            state[p] = PIXEL_RESAMPLED;
+            wo[p] = Normalize(-ray.Direction());
+            normals[p] = DotProduct(hit.normal, wo[p]) < 0.f ? -hit.normal : hit.normal;
+            depths[p] = Length(hit.hit_point - ray.Origin());
+            L[p] = hit.EmittedRadiance(wo[p]);
+            if (n_lights == 0) {
+                return;
+            }
+            Reservoir &r = reservoirs[p];
+            for (uint32_t k = 0; k < candidates; k++) {
+                // Lights are chosen uniformly
+                const uint32_t light = std::min(static_cast<uint32_t>(u() * n_lights), n_lights - 1);
+                const float u1 = u();
+                const float u2 = u();
+                r.Update(light, u1, u2, Target(hit, wo[p], *lights[light], u1, u2) * n_lights / candidates, u());
+            }
+            r.M = candidates;
+            OcclusionTester occ;
+            const float target = Target(hit, wo[p], *lights[r.light], r.u1, r.u2, nullptr, &occ);
+            r.Finalize(target > 0.f && occ.Unoccluded(scene) ? target : 0.f);
+        });
+
+        // Target of the sample of a reservoir at a pixel
+        auto target = [&](uint32_t p, const Reservoir &r) {
+            return Target(hits[p], wo[p], *lights[r.light], r.u1, r.u2);
+        };
+
+        // Reuse the reservoir of the previous frame at the same pixel, if it saw a similar surface. Its count is
+        // clamped so that the history does not outweigh the new samples when the lighting changes, and both
+        // samples are weighted by their count since they share the surface
+        if (temporal && previous.size() == n && n_lights > 0) {
+            ParallelPixels(n, seed + 1, [&](uint32_t p, const std::function<float()> &u) {
+                if (state[p] != PIXEL_RESAMPLED || previous[p].M == 0 ||
+                    !Similar(normals[p], depths[p], previous_normals[p], previous_depths[p])) {
+                    return;
+                }
+                const Reservoir &current = reservoirs[p];
+                Reservoir history = previous[p];
+                history.M = std::min(history.M, TEMPORAL_M_FACTOR * current.M);
+                const float M = static_cast<float>(current.M + history.M);
+                Reservoir r;
+                r.Merge(current, current.W > 0.f ? current.M / M * target(p, current) * current.W : 0.f, u());
+                r.Merge(history, history.W > 0.f ? history.M / M * target(p, history) * history.W : 0.f, u());
+                r.Finalize(target(p, r));
+                reservoirs[p] = r;
+            });
+        }
+
+        // Reuse the reservoirs of neighbor pixels seeing a similar surface. Each sample is weighted by the balance
+        // heuristic over the targets of all the pixels reused, so that samples the neighbor was unlikely to keep
+        // are not blown up where they matter more
+        if (spatial_neighbors > 0 && n_lights > 0) {
+            std::vector<Reservoir> spatial(reservoirs);
+            ParallelPixels(n, seed + 2, [&](uint32_t p, const std::function<float()> &u) {
+                if (state[p] != PIXEL_RESAMPLED) {
+                    return;
+                }
+                // Pixels reused, this one first
+                std::vector<uint32_t> pixels(1, p);
+                pixels.reserve(spatial_neighbors + 1);
+                for (uint32_t k = 0; k < spatial_neighbors; k++) {
+                    // Uniform in the disk around the pixel
+                    const float radius = spatial_radius * std::sqrt(u());
+                    const float phi = TWO_PI * u();
+                    const int32_t i = static_cast<int32_t>(p % width) +
+                                      static_cast<int32_t>(std::round(radius * std::cos(phi)));
+                    const int32_t j = static_cast<int32_t>(p / width) +
+                                      static_cast<int32_t>(std::round(radius * std::sin(phi)));
+                    if (i < 0 || j < 0 || i >= static_cast<int32_t>(width) || j >= static_cast<int32_t>(height)) {
+                        continue;
+                    }
+                    const uint32_t q = static_cast<uint32_t>(j) * width + static_cast<uint32_t>(i);
+                    if (state[q] == PIXEL_RESAMPLED && std::find(pixels.begin(), pixels.end(), q) == pixels.end() &&
+                        Similar(normals[p], depths[p], normals[q], depths[q])) {
+                        pixels.push_back(q);
+                    }
+                }
+                Reservoir r;
+                for (uint32_t a : pixels) {
+                    const Reservoir &source = reservoirs[a];
+                    float weight = 0.f;
+                    if (source.W > 0.f) {
+                        float own = 0.f, sum = 0.f;
+                        for (uint32_t b : pixels) {
+                            const float t = target(b, source) * reservoirs[b].M;
+                            own = (a == b) ? t : own;
+                            sum += t;
+                        }
+                        weight = sum > 0.f ? own / sum * target(p, source) * source.W : 0.f;
+                    }
+                    r.Merge(source, weight, u());
+                }
+                r.Finalize(target(p, r));
+                spatial[p] = r;
+            });
+            reservoirs.swap(spatial);
+        }
+
+        // Shade the sample kept by each pixel
+        if (n_lights > 0) {
+            ParallelPixels(n, seed, [&](uint32_t p, const std::function<float()> &) {
+                const Reservoir &r = reservoirs[p];
+                if (state[p] != PIXEL_RESAMPLED || r.W == 0.f) {
+                    return;
+                }
+                SSESpectrum contribution;
+                OcclusionTester occ;
+                if (Target(hits[p], wo[p], *lights[r.light], r.u1, r.u2, &contribution, &occ) > 0.f &&
+                    occ.Unoccluded(scene)) {
+                    L[p] += contribution * r.W;
+                }
+            });
+        }
+
+        // The integrator is not assumed to be safe to call from several threads
+        integrator->Preprocess(scene);
+        for (uint32_t p = 0; p < n; p++) {
+            if (state[p] == PIXEL_INTEGRATED) {
+                L[p] = integrator->IncomingRadiance(camera.GenerateRay(p % width, p / width, 0.5f, 0.5f), scene);
+            }
+        }
+        for (uint32_t p = 0; p < n; p++) {
+            film->AddSample(L[p], p % width + 0.5f, p / width + 0.5f);
+            if (!aovs.empty()) {
+                film->AddAOVSample(aovs[p], p % width + 0.5f, p / width + 0.5f);
+            }
+        }
+
+        // Keep the reservoirs for the next frame
+        previous.swap(reservoirs);
+        previous_normals.swap(normals);
+        previous_depths.swap(depths);
+        frame++;
+    }
+
+}
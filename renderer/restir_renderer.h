@@ -0,0 +1,102 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2016 simon.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * File:   restir_renderer.h
+ * Author: simon
+ *
+ * Created on October 20, 2026, 2:35 AM
+ */
+
+#ifndef PIXEL_RESTIR_RENDERER_H
+#define PIXEL_RESTIR_RENDERER_H
+
+#include "pixel.h"
+#include "renderer.h"
+#include "sse_vector.h"
+
+#include <vector>
+
+namespace pixel {
+
+    // Define ReSTIRRenderer class, an interactive preview tracing one ray per pixel whose hits are lit directly
+    // through reservoir resampling. Each pixel resamples a few light samples down to one, then reuses the
+    // reservoirs of the previous frame at the same pixel and those of its neighbors before shading the sample
+    // kept. Every call to RenderImage renders a frame, rays hitting purely specular surfaces are left to the
+    // integrator
+    class ReSTIRRenderer : public RendererInterface {
+    public:
+        // Constructor, candidates light samples are drawn per pixel and the reservoirs of spatial_neighbors
+        // pixels within spatial_radius pixels are reused, after those of the previous frame with temporal reuse
+        ReSTIRRenderer(const std::shared_ptr<const SurfaceIntegratorInterface> &i, uint32_t candidates = 32,
+                       uint32_t spatial_neighbors = 5, float spatial_radius = 30.f, bool temporal = true);
+
+        // Render a frame
+        void RenderImage(Film *const film, const Scene &scene, const CameraInterface &camera) const override;
+
+    private:
+        // Weighted reservoir keeping one light sample out of a stream. A sample is a light with the numbers its
+        // Sample_Li is called with, so that any pixel can evaluate the sample of another one
+        struct Reservoir {
+            Reservoir()
+                    : light(0), u1(0.f), u2(0.f), weight_sum(0.f), M(0), W(0.f) {}
+
+            // Add a sample with its resampling weight, it is kept with probability weight / weight_sum
+            void Update(uint32_t l, float v1, float v2, float weight, float u);
+
+            // Add the sample of another reservoir with its resampling weight, and the samples it stands for
+            void Merge(const Reservoir &other, float weight, float u);
+
+            // Compute the contribution weight once all the samples are in, given the target of the sample kept.
+            // The resampling weights already include the MIS weights of their samples
+            void Finalize(float target);
+
+            // Sample kept
+            uint32_t light;
+            float u1, u2;
+            // Sum of the resampling weights and number of samples seen
+            float weight_sum;
+            uint32_t M;
+            // Contribution weight of the sample kept, one over its pdf
+            float W;
+        };
+
+        // Number of light samples drawn per pixel
+        const uint32_t candidates;
+        // Neighbors reused and radius they are chosen within
+        const uint32_t spatial_neighbors;
+        const float spatial_radius;
+        // Reuse the reservoirs of the previous frame
+        const bool temporal;
+        // Reservoirs of the previous frame, with the normal and the depth of their pixel
+        mutable std::vector<Reservoir> previous;
+        mutable std::vector<SSEVector> previous_normals;
+        mutable std::vector<float> previous_depths;
+        // Number of frames rendered
+        mutable uint32_t frame;
+    };
+
+}
+
+#endif //PIXEL_RESTIR_RENDERER_H
@@ -30,6 +30,7 @@
 
 // DEBUG
 #include <random>
+#include <algorithm>
 
 namespace pixel {
 
@@ -38,24 +39,66 @@ namespace pixel {
     }
 
     void SamplerRenderer::RenderImage(Film *const film, const Scene &scene, const CameraInterface &camera) const {
+        // The footprint of each sample shrinks with the number of samples in a pixel
+        const float differential_scale = 1.f / std::sqrt(static_cast<float>(aa_samples));
         // DEBUG
         std::default_random_engine generator;
         std::uniform_real_distribution<float> distribution(0.f, 1.f);
 
-        // Loop over all image pixels
-        for (uint32_t i = 0; i < film->GetWidth(); i++) {
-            for (uint32_t j = 0; j < film->GetHeight(); j++) {
-                // Loop over all samples
-                for (uint32_t s = 0; s < aa_samples; s++) {
-                    // Request ray from camera
-                    Ray ray = camera.GenerateRay(i, j, distribution(generator),
-                                                 distribution(generator)); // TODO: FIX ME
-                    // Integrate ray
-                    SSESpectrum Li = integrator->IncomingRadiance(ray, scene);
-                    // Add sampler
-                    film->AddSample(Li, i + 0.5f, j + 0.5f);
+        // Rays are integrated in batches so that integrators can shade their hits together
+        const uint32_t batch_size = 256;
+        std::vector<Ray> rays;
+        std::vector<std::pair<uint32_t, uint32_t>> pixels;
+        std::vector<SSESpectrum> Li(batch_size);
+        rays.reserve(batch_size);
+        pixels.reserve(batch_size);
+        std::vector<AOVSample> aovs(film->HasAOVs() ? batch_size : 0);
+        auto flush = [&]() {
+            integrator->IncomingRadianceBatch(rays.data(), static_cast<uint32_t>(rays.size()), scene, Li.data(),
+                                              aovs.empty() ? nullptr : aovs.data());
+            for (uint32_t k = 0; k < rays.size(); k++) {
+                film->AddSample(Li[k], pixels[k].first + 0.5f, pixels[k].second + 0.5f);
+                if (!aovs.empty()) {
+                    film->AddAOVSample(aovs[k], pixels[k].first + 0.5f, pixels[k].second + 0.5f);
                 }
             }
+            rays.clear();
+            pixels.clear();
+        };
+
+        // Every camera sample may trace a path from the lights splatting anywhere on the film
+        film->SetSplatScale(1.f / aa_samples);
+
+        // Samples are taken in passes over the image doubling in size up to the limit of the integrator, which
+        // may learn from a pass
+        integrator->Preprocess(scene);
+        uint32_t pass_samples = 1;
+        for (uint32_t done = 0; done < aa_samples; done += pass_samples, pass_samples *= 2) {
+            pass_samples = std::min({pass_samples, aa_samples - done, integrator->MaxPassSamples()});
+            // Loop over all image pixels
+            for (uint32_t i = 0; i < film->GetWidth(); i++) {
+                for (uint32_t j = 0; j < film->GetHeight(); j++) {
+                    // Loop over the samples of the pass
+                    for (uint32_t s = 0; s < pass_samples; s++) {
+                        // Request ray from camera
+                        Ray ray = camera.GenerateRay(i, j, distribution(generator),
+                                                     distribution(generator)); // TODO: FIX ME
+                        ray.ScaleDifferentials(differential_scale);
+                        rays.push_back(ray);
+                        pixels.emplace_back(i, j);
+                        if (rays.size() == batch_size) {
+                            flush();
+                        }
+                    }
+                }
+            }
+            if (!rays.empty()) {
+                flush();
+            }
+            // Nothing learns from the last pass
+            if (done + pass_samples < aa_samples) {
+                integrator->EndPass();
+            }
         }
     }
 
@@ -34,7 +34,7 @@ namespace pixel {
             : ShapeInterface(l2w), half_x_width(x_w / 2.f), half_z_width(z_w / 2.f) {
     }
 
-    bool Rectangle::Intersect(const Ray &ray, float *const t_hit, SurfaceInteraction *const interaction) const {
+    bool Rectangle::Intersect(const Ray &ray, float *const t_hit, SurfaceInteraction *const) const {
         // Transform ray to local space
         Ray local_ray = TransformRay(ray, world_to_local);
         // Check if ray direction is parallel to plane
@@ -46,17 +46,7 @@ namespace pixel {
                 SSEVector hit_p = local_ray(t);
                 if (hit_p.x >= -half_x_width && hit_p.x <= half_x_width &&
                     hit_p.z >= -half_z_width && hit_p.z <= half_z_width) {
-                    // Fill interaction data
                     *t_hit = t;
-                    interaction->hit_point = hit_p;
-                    interaction->normal = SSEVector(0.f, 1.f, 0.f, 0.f);
-                    interaction->s = SSEVector(1.f, 0.f, 0.f, 0.f);
-                    interaction->t = SSEVector(0.f, 0.f, 1.f, 0.f);
-                    interaction->u = (hit_p.x + half_x_width) / (2.f * half_x_width);
-                    interaction->v = (hit_p.z + half_z_width) / (2.f * half_z_width);
-
-                    // Transform interaction back to world space
-                    TransformSurfaceInteraction(interaction, local_to_world);
 
                     return true;
                 }
@@ -66,6 +56,25 @@ namespace pixel {
         return false;
     }
 
+    void Rectangle::ComputeSurfaceInteraction(const Ray &ray, SurfaceInteraction *const interaction) const {
+        // Transform ray to local space
+        Ray local_ray = TransformRay(ray, world_to_local);
+        // Fill interaction data
+        SSEVector hit_p = local_ray(local_ray.RayMaximum());
+        interaction->hit_point = hit_p;
+        interaction->normal = SSEVector(0.f, 1.f, 0.f, 0.f);
+        interaction->s = SSEVector(1.f, 0.f, 0.f, 0.f);
+        interaction->t = SSEVector(0.f, 0.f, 1.f, 0.f);
+        interaction->u = (hit_p.x + half_x_width) / (2.f * half_x_width);
+        interaction->v = (hit_p.z + half_z_width) / (2.f * half_z_width);
+        interaction->dpdu = SSEVector(2.f * half_x_width, 0.f, 0.f, 0.f);
+        interaction->dpdv = SSEVector(0.f, 0.f, 2.f * half_z_width, 0.f);
+        interaction->dndu = interaction->dndv = SSEVector(0.f, 0.f, 0.f, 0.f);
+
+        // Transform interaction back to world space
+        TransformSurfaceInteraction(interaction, local_to_world, world_to_local);
+    }
+
     bool Rectangle::IntersectP(const Ray &ray) const {
         // Transform ray to local space
         Ray local_ray = TransformRay(ray, world_to_local);
@@ -99,7 +108,7 @@ namespace pixel {
         interaction.normal = SSEVector(0.f, 1.f, 0.f, 0.f);
         interaction.u = (interaction.hit_point.x + half_x_width) / x_width;
         interaction.v = (interaction.hit_point.z + half_z_width) / z_width;
-        TransformSurfaceInteraction(&interaction, local_to_world);
+        TransformSurfaceInteraction(&interaction, local_to_world, world_to_local);
 
         return interaction;
     }
@@ -34,7 +34,7 @@ namespace pixel {
             : ShapeInterface(l2w), radius(r) {
     }
 
-    bool Sphere::Intersect(const Ray &ray, float *const t_hit, SurfaceInteraction *const interaction) const {
+    bool Sphere::Intersect(const Ray &ray, float *const t_hit, SurfaceInteraction *const) const {
         // Transform ray to local space
         Ray local_ray = TransformRay(ray, world_to_local);
         // Compute terms for quadratic form
@@ -68,30 +68,43 @@ namespace pixel {
                 return false;
             }
         }
-        // Fill interaction data
         *t_hit = nearest_t;
-        interaction->hit_point = local_ray(nearest_t);
+
+        return true;
+    }
+
+    void Sphere::ComputeSurfaceInteraction(const Ray &ray, SurfaceInteraction *const interaction) const {
+        // Transform ray to local space
+        Ray local_ray = TransformRay(ray, world_to_local);
+        // Fill interaction data
+        interaction->hit_point = local_ray(local_ray.RayMaximum());
         interaction->normal = Normalize(interaction->hit_point - SSEVector(0.f, 0.f, 0.f, 1.f));
-        float phi = std::atan2(interaction->hit_point.z, interaction->hit_point.x);
+        float phi = Atan2(interaction->hit_point.z, interaction->hit_point.x);
         if (phi < 0.f) {
             phi += TWO_PI;
         }
-        float theta = std::acos((interaction->hit_point.y) / radius);
+        float theta = Acos(Clamp(interaction->hit_point.y / radius, -1.f, 1.f));
+        // The sines and cosines also give the derivatives below
+        float sin_phi, cos_phi, sin_theta, cos_theta;
+        SinCos(phi, &sin_phi, &cos_phi);
+        SinCos(theta, &sin_theta, &cos_theta);
         if (theta > EPS) {
-            interaction->s = SSEVector(std::sin(phi), 0.f, -std::cos(phi), 0.f);
-            interaction->t = SSEVector(std::cos(theta) * std::cos(phi), -std::sin(theta),
-                                       std::cos(theta) * std::sin(phi),
-                                       0.f);
+            interaction->s = SSEVector(sin_phi, 0.f, -cos_phi, 0.f);
+            interaction->t = SSEVector(cos_theta * cos_phi, -sin_theta, cos_theta * sin_phi, 0.f);
         } else {
             CoordinateSystem(interaction->normal, &(interaction->s), &(interaction->t));
         }
         interaction->u = phi / TWO_PI;
         interaction->v = theta / PI;
+        // Derivatives of the uv parametrization, the normal is the point over the radius
+        const SSEVector &p = interaction->hit_point;
+        interaction->dpdu = SSEVector(-TWO_PI * p.z, 0.f, TWO_PI * p.x, 0.f);
+        interaction->dpdv = SSEVector(PI * p.y * cos_phi, -PI * radius * sin_theta, PI * p.y * sin_phi, 0.f);
+        interaction->dndu = interaction->dpdu / radius;
+        interaction->dndv = interaction->dpdv / radius;
 
         // Transform interaction back to world space
-        TransformSurfaceInteraction(interaction, local_to_world);
-
-        return true;
+        TransformSurfaceInteraction(interaction, local_to_world, world_to_local);
     }
 
     bool Sphere::IntersectP(const Ray &ray) const {
@@ -138,11 +151,11 @@ namespace pixel {
         SurfaceInteraction interaction;
         // Sample point on sphere
         SSEVector p_sphere = radius * UniformSampleSphere(u1, u2);
-        float phi = std::atan2(p_sphere.z, p_sphere.x);
+        float phi = Atan2(p_sphere.z, p_sphere.x);
         if (phi < 0.f) {
             phi += TWO_PI;
         }
-        float theta = std::acos((interaction.hit_point.y) / radius);
+        float theta = Acos(Clamp(p_sphere.y / radius, -1.f, 1.f));
         interaction.u = phi / TWO_PI;
         interaction.v = theta / PI;
         interaction.hit_point = local_to_world * SSEVector(p_sphere.x, p_sphere.y, p_sphere.z, 1.f);
@@ -175,15 +188,15 @@ namespace pixel {
         SurfaceInteraction interaction;
         interaction.normal = SphericalDirection(sin_alpha, cos_alpha, phi, -u_c, -v_c, -w_c);
         interaction.hit_point = SSEVector(0.f, 0.f, 0.f, 1.f) + radius * interaction.normal;
-        float sphere_phi = std::atan2(interaction.hit_point.z, interaction.hit_point.x);
+        float sphere_phi = Atan2(interaction.hit_point.z, interaction.hit_point.x);
         if (sphere_phi < 0.f) {
             sphere_phi += TWO_PI;
         }
-        float theta = std::acos((interaction.hit_point.y) / radius);
+        float theta = Acos(Clamp(interaction.hit_point.y / radius, -1.f, 1.f));
         interaction.u = sphere_phi / TWO_PI;
         interaction.v = theta / PI;
 
-        TransformSurfaceInteraction(&interaction, local_to_world);
+        TransformSurfaceInteraction(&interaction, local_to_world, world_to_local);
 
         return interaction;
     }
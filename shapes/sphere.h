@@ -46,6 +46,8 @@ namespace pixel {
 
         bool Intersect(const Ray &ray, float *const t_hit, SurfaceInteraction *const interaction) const override;
 
+        void ComputeSurfaceInteraction(const Ray &ray, SurfaceInteraction *const interaction) const override;
+
         bool IntersectP(const Ray &ray) const override;
 
         float Area() const override;
@@ -48,16 +48,50 @@ namespace pixel {
 
         T Evaluate(const SurfaceInteraction &interaction) const override {
             // Map new uv coordinates
-            float u, v;
-            mapping->Map(interaction, &u, &v);
-            if ((static_cast<uint32_t>(std::floor(u)) + static_cast<uint32_t>(std::floor(v))) % 2
-                == 0) {
-                return tex1->Evaluate(interaction);
+            TextureCoordinates c;
+            mapping->Map(interaction, &c);
+            // Half size of the filter box
+            const float ds = std::max(std::abs(c.dudx), std::abs(c.dudy));
+            const float dt = std::max(std::abs(c.dvdx), std::abs(c.dvdy));
+            const float s0 = c.u - ds, s1 = c.u + ds;
+            const float t0 = c.v - dt, t1 = c.v + dt;
+            if (std::floor(s0) == std::floor(s1) && std::floor(t0) == std::floor(t1)) {
+                // The footprint is inside a single check
+                if ((static_cast<uint32_t>(std::floor(c.u)) + static_cast<uint32_t>(std::floor(c.v))) % 2
+                    == 0) {
+                    return tex1->Evaluate(interaction);
+                }
+                return tex2->Evaluate(interaction);
             }
-            return tex2->Evaluate(interaction);
+            // Box filter the pattern, the odd checks cover a fraction of the footprint found by integrating
+            // the 1D step functions along each axis
+            float area2 = 0.5f;
+            if (ds <= 1.f && dt <= 1.f) {
+                const float s_int = OddFraction(c.u, ds);
+                const float t_int = OddFraction(c.v, dt);
+                area2 = s_int + t_int - 2.f * s_int * t_int;
+            }
+
+            return T((1.f - area2) * tex1->Evaluate(interaction) + area2 * tex2->Evaluate(interaction));
         }
 
     private:
+        // Integral of the step function that is one on the odd unit intervals
+        static float BumpIntegral(float x) {
+            const float half = std::floor(x / 2.f);
+
+            return half + 2.f * std::max(x / 2.f - half - 0.5f, 0.f);
+        }
+
+        // Fraction of [x - d, x + d] covered by the odd unit intervals
+        static float OddFraction(float x, float d) {
+            if (d == 0.f) {
+                return static_cast<float>(static_cast<int64_t>(std::floor(x)) & 1);
+            }
+
+            return (BumpIntegral(x + d) - BumpIntegral(x - d)) / (2.f * d);
+        }
+
         // Mapping
         const std::shared_ptr<const TextureMapping2DInterface> mapping;
         // Colors
@@ -47,6 +47,10 @@ namespace pixel {
             return value;
         }
 
+        bool IsConstant() const override {
+            return true;
+        }
+
     private:
         const T value;
     };
@@ -37,7 +37,7 @@
 
 namespace pixel {
 
-    // Define constant texture
+    // Define grid texture
     template<typename T>
     class GridTexture : public TextureInterface<T> {
     public:
@@ -49,15 +49,49 @@ namespace pixel {
 
         T Evaluate(const SurfaceInteraction &interaction) const override {
             // Map new uv coordinates
-            float u, v;
-            mapping->Map(interaction, &u, &v);
-            if (std::abs(u - std::round(u)) < thickness || std::abs(v - std::round(v)) < thickness) {
+            TextureCoordinates c;
+            mapping->Map(interaction, &c);
+            // Half size of the filter box
+            const float ds = std::max(std::abs(c.dudx), std::abs(c.dudy));
+            const float dt = std::max(std::abs(c.dvdx), std::abs(c.dvdy));
+            if (ds == 0.f && dt == 0.f) {
+                if (std::abs(c.u - std::round(c.u)) < thickness || std::abs(c.v - std::round(c.v)) < thickness) {
+                    return tex1->Evaluate(interaction);
+                }
+                return tex2->Evaluate(interaction);
+            }
+            // Box filter the lines along each axis, a point is on the grid if it is on either set of lines
+            const float s_line = LineFraction(c.u, ds);
+            const float t_line = LineFraction(c.v, dt);
+            const float line = s_line + t_line - s_line * t_line;
+            if (line == 0.f) {
+                return tex2->Evaluate(interaction);
+            }
+            if (line == 1.f) {
                 return tex1->Evaluate(interaction);
             }
-            return tex2->Evaluate(interaction);
+
+            return T(line * tex1->Evaluate(interaction) + (1.f - line) * tex2->Evaluate(interaction));
         }
 
     private:
+        // Integral of the function that is one within thickness of the integers
+        float LineIntegral(float x) const {
+            const float cell = std::floor(x);
+            const float f = x - cell;
+
+            return cell * 2.f * thickness + std::min(f, thickness) + std::max(f - (1.f - thickness), 0.f);
+        }
+
+        // Fraction of [x - d, x + d] covered by the lines
+        float LineFraction(float x, float d) const {
+            if (d == 0.f) {
+                return std::abs(x - std::round(x)) < thickness ? 1.f : 0.f;
+            }
+
+            return (LineIntegral(x + d) - LineIntegral(x - d)) / (2.f * d);
+        }
+
         // Mapping
         const std::shared_ptr<const TextureMapping2DInterface> mapping;
         // Colors
@@ -0,0 +1,76 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2016 simon.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * File:   image_texture.h
+ * Author: simon
+ *
+ * Created on October 19, 2026, 10:15 PM
+ */
+
+#ifndef PIXEL_IMAGE_TEXTURE_H
+#define PIXEL_IMAGE_TEXTURE_H
+
+#include "pixel.h"
+#include "texture.h"
+#include "mipmap.h"
+
+namespace pixel {
+
+    // Convert a filtered texel to the texture type, scalar textures use the luminance
+    inline void ConvertTexel(const SSESpectrum &texel, SSESpectrum *const value) {
+        *value = texel;
+    }
+
+    inline void ConvertTexel(const SSESpectrum &texel, float *const value) {
+        *value = 0.2126f * texel.r + 0.7152f * texel.g + 0.0722f * texel.b;
+    }
+
+    // Define image texture, texels are paged in from a tiled mipmap through the global texture cache
+    template<typename T>
+    class ImageTexture : public TextureInterface<T> {
+    public:
+        ImageTexture(const std::shared_ptr<const TextureMapping2DInterface> mapping, const std::string &file_name)
+                : mapping(mapping), mipmap(OpenMIPMap(file_name)) {}
+
+        T Evaluate(const SurfaceInteraction &interaction) const override {
+            // Map new uv coordinates, the footprint selects the filter
+            TextureCoordinates c;
+            mapping->Map(interaction, &c);
+            T value;
+            ConvertTexel(mipmap->Lookup(c.u, c.v, c.dudx, c.dvdx, c.dudy, c.dvdy), &value);
+
+            return value;
+        }
+
+    private:
+        // Mapping
+        const std::shared_ptr<const TextureMapping2DInterface> mapping;
+        // Image
+        const std::shared_ptr<const TiledMIPMap> mipmap;
+    };
+
+}
+
+#endif //PIXEL_IMAGE_TEXTURE_H
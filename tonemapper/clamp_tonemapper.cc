@@ -23,7 +23,9 @@
  */
 
 #include "clamp_tonemapper.h"
+#include "kernels.h"
 #include <fstream>
+#include <vector>
 
 namespace pixel {
 
@@ -39,17 +41,22 @@ namespace pixel {
         file << "P3\n";
         file << f.GetWidth() << " " << f.GetHeight() << "\n";
         file << "255\n";
-        // Write colors to file
+        // Write colors to file, a row at a time through the tone mapping kernel
+        std::vector<float> row(3 * f.GetWidth());
+        std::vector<int32_t> row_colors(3 * f.GetWidth());
         for (int32_t j = f.GetHeight() - 1; j >= 0; j--) {
             for (uint32_t i = 0; i < f.GetWidth(); i++) {
                 // Get color
                 const SSESpectrum &c = f.GetSpectrum(i, j);
-                // Clamp the color and correct gamma
-                SSESpectrum clamped_c = Pow(Clamp(c, 0, 1), gamma);
-                // Output color
-                file << static_cast<int32_t> (clamped_c.r * 255) << " ";
-                file << static_cast<int32_t> (clamped_c.g * 255) << " ";
-                file << static_cast<int32_t> (clamped_c.b * 255) << " ";
+                row[3 * i] = c.r;
+                row[3 * i + 1] = c.g;
+                row[3 * i + 2] = c.b;
+            }
+            // Clamp the colors and correct gamma
+            Kernels().tone_map(row.data(), static_cast<uint32_t>(row.size()), gamma, row_colors.data());
+            // Output colors
+            for (int32_t c : row_colors) {
+                file << c << " ";
             }
             file << "\n";
         }